@@ -0,0 +1,89 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Benchmark of the batch integrator against independent Model runs
+ *
+ * Usage: bench_batch [trajectories] [experiment]
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file batch.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/BatchModel.h"
+#include "../src/headers/Model.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const char *const kernelNames[] = { "scalar", "avx2", "avx512" };
+
+    double seconds(chrono::steady_clock::time_point start) {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Spread of R0 around the Model value, one per trajectory
+    double laneR0(size_t lane, size_t lanes) {
+        return 2.0 + 6.0 * lane / lanes;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t lanes = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+    int experiment = argc > 2 ? atoi(argv[2]) : 4;
+    if (lanes == 0 || experiment < 1 || experiment > 4) {
+        return 1;
+    }
+    bool SIERD = experiment >= 3;
+    bool restrictions = experiment % 2 == 0;
+    unsigned long days = Date::reportDays;
+
+    // Scalar path, one Model per parameter set
+    vector<double> reference(lanes);
+    auto start = chrono::steady_clock::now();
+    for (size_t k = 0; k < lanes; k++) {
+        Model model;
+        model.setVerbose(false);
+        model.setOutput("");
+        model.setRates(laneR0(k, lanes), 0.0556, 0.1923, 0.0034);
+        model.performExp(experiment);
+        reference[k] = model.getStats().sumInfected;
+    }
+    double scalarTime = seconds(start);
+    printf("trajectories=%zu days=%lu experiment=%d\n", lanes, days, experiment);
+    printf("%-8s %10.4f s %12.1f ns/trajectory-day\n", "Model", scalarTime, scalarTime * 1e9 / (lanes * days));
+
+    // Batch path with every kernel the CPU supports
+    const BatchModel::Kernel kernels[] = { BatchModel::SCALAR, BatchModel::AVX2, BatchModel::AVX512 };
+    const Timeline timeline = Timeline::hubei(restrictions);
+    for (BatchModel::Kernel kernel : kernels) {
+        BatchModel batch(lanes, SIERD);
+        if (!batch.setKernel(kernel)) {
+            continue;
+        }
+        for (size_t k = 0; k < lanes; k++) {
+            batch.setRates(k, laneR0(k, lanes), 0.0556, 0.1923, 0.0034);
+            batch.setTimeline(k, timeline);
+        }
+
+        start = chrono::steady_clock::now();
+        batch.simulate(days);
+        double batchTime = seconds(start);
+
+        // Largest relative difference of the final statistics to the Model runs
+        double error = 0.0;
+        for (size_t k = 0; k < lanes; k++) {
+            double diff = fabs((double)(batch.getSumInfected()[k] - reference[k]) / (double)reference[k]);
+            error = diff > error ? diff : error;
+        }
+        printf("%-8s %10.4f s %12.1f ns/trajectory-day  speedup %6.1fx  max rel. diff %.3g\n",
+               kernelNames[kernel], batchTime, batchTime * 1e9 / (lanes * days), scalarTime / batchTime, error);
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Benchmark suite of the SIMLIB calendars over queue sizes 10, 100, ...
+ * and the interval distributions of the calendar test:
+ *  hold  a filled calendar, every event executed schedules itself again
+ *  up    the calendar filled by scheduling the events one by one
+ *  down  the filled calendar emptied by the run
+ * Prints one CSV row per calendar, model, distribution and size with time,
+ * reorganizations of the calendar and cache misses per operation (hold,
+ * enqueue or dequeue). Misses are read by perf_event_open and left empty
+ * where the hardware counters are not available.
+ *
+ * Usage: bench_calendar [largest size] [holds] [calendar]...
+ *  defaults 10000000 events, 1000000 holds, calendars list cq ladder heap
+ *  (list only up to 10000 events, its operations are linear)
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file calendar.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "simlib.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const unsigned long listLimit = 10000;
+
+    /**
+     * Hardware counter of this thread in user space, invalid if it can not be opened
+     */
+    class Counter {
+    public:
+        Counter(unsigned type, unsigned long long config) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+        ~Counter() {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        bool valid() const { return fd >= 0; }
+
+        void start() {
+            if (valid()) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        long long stop() {
+            long long count = -1;
+            if (valid()) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+                    count = -1;
+                }
+            }
+            return count;
+        }
+
+    private:
+        int fd;
+    };
+
+    /**
+     * Time, calendar reorganizations and cache misses between start and stop
+     */
+    class Measurement {
+    public:
+        Measurement()
+            : misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+              l1dMisses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8
+                                            | PERF_COUNT_HW_CACHE_RESULT_MISS << 16) {}
+
+        void start() {
+            resizes = CalendarResizes();
+            misses.start();
+            l1dMisses.start();
+            begin = chrono::steady_clock::now();
+        }
+
+        void stop() {
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            l1dMissed = l1dMisses.stop();
+            missed = misses.stop();
+            resizes = CalendarResizes() - resizes;
+        }
+
+        /**
+         * Prints the CSV row
+         */
+        void print(const char *calendar, const char *model, const char *distribution, unsigned long size,
+                   unsigned long operations) const {
+            printf("%s,%s,%s,%lu,%lu,%.1f,%lu,", calendar, model, distribution, size, operations,
+                   seconds * 1e9 / operations, resizes);
+            printPerOperation(missed, operations);
+            printf(",");
+            printPerOperation(l1dMissed, operations);
+            printf("\n");
+            fflush(stdout);
+        }
+
+    private:
+        Counter misses, l1dMisses;
+        chrono::steady_clock::time_point begin;
+        double seconds = 0.0;
+        unsigned long resizes = 0;
+        long long missed = -1, l1dMissed = -1;
+
+        static void printPerOperation(long long count, unsigned long operations) {
+            if (count >= 0) {
+                printf("%.3f", (double)count / operations);
+            }
+        }
+    };
+
+    // Intervals of the calendar test, all with mean 1
+    double uniform() { return 2 * Random(); }
+    double exponential() { return Exponential(1); }
+    double biased() { return 0.9 + 0.2 * Random(); }
+    double bimodal() { return 0.95238 * Random() + (Random() < 0.1 ? 9.5238 : 0.0); }
+    double triangular() { return 1.5 * sqrt(Random()); }
+
+    struct Distribution {
+        const char *name;
+        double (*interval)();
+    };
+    const Distribution distributions[] = {
+        { "uniform", uniform },
+        { "exponential", exponential },
+        { "biased", biased },
+        { "bimodal", bimodal },
+        { "triangular", triangular },
+    };
+
+    Measurement measurement;
+    double (*interval)() = exponential;
+    bool holding = false/* Events schedule themselves again */;
+    unsigned long executed = 0, first = 0/* First measured */, last = 0/* After the last measured */;
+
+    class Hold : public Event {
+        void Behavior() {
+            if (executed == first && holding) {
+                measurement.start();
+            }
+            if (++executed > last) {
+                if (holding) {
+                    measurement.stop();
+                    Stop();
+                }
+                return;
+            }
+            if (holding) {
+                Activate(Time + interval());
+            } else if (executed == last) {
+                measurement.stop();
+            }
+        }
+    };
+
+    void hold(const char *calendar, const Distribution &distribution, unsigned long size, unsigned long holds) {
+        SetCalendar(calendar);
+        Init(0);
+        RandomSeed(1234567);
+        interval = distribution.interval;
+        for (unsigned long i = 0; i < size; i++) {
+            (new Hold)->Activate(interval());
+        }
+        // Warm up to the steady state first
+        holding = true;
+        executed = 0;
+        first = size < holds ? size : holds;
+        last = first + holds;
+        Run();
+        measurement.print(calendar, "hold", distribution.name, size, holds);
+    }
+
+    void upDown(const char *calendar, const Distribution &distribution, unsigned long size) {
+        SetCalendar(calendar);
+        Init(0);
+        RandomSeed(1234567);
+        vector<Hold *> events(size);
+        vector<double> times(size);
+        for (unsigned long i = 0; i < size; i++) {
+            events[i] = new Hold;
+            times[i] = distribution.interval();
+        }
+
+        measurement.start();
+        for (unsigned long i = 0; i < size; i++) {
+            events[i]->Activate(times[i]);
+        }
+        measurement.stop();
+        measurement.print(calendar, "up", distribution.name, size, size);
+
+        holding = false;
+        executed = 0;
+        last = size;
+        measurement.start();
+        Run();
+        measurement.print(calendar, "down", distribution.name, size, size);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned long largest = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000000;
+    unsigned long holds = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000;
+    vector<const char *> calendars;
+    for (int i = 3; i < argc; i++) {
+        calendars.push_back(argv[i]);
+    }
+    if (calendars.empty()) {
+        calendars = { "list", "cq", "ladder", "heap" };
+    }
+
+    printf("calendar,model,distribution,size,operations,ns_per_op,resizes,cache_misses_per_op,l1d_misses_per_op\n");
+    for (unsigned long size = 10; size <= largest; size *= 10) {
+        for (const Distribution &distribution : distributions) {
+            for (const char *calendar : calendars) {
+                if (strcmp(calendar, "list") == 0 && size > listLimit) {
+                    continue;
+                }
+                hold(calendar, distribution, size, holds);
+                upDown(calendar, distribution, size);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Benchmark of the continuous-time model: error against time per run of the
+ * daily Euler step of Model, SIMLIB Euler with smaller steps and the adaptive
+ * RKF5/RKF8 methods, and the cheapest method meeting each error budget
+ *
+ * The error is the largest difference of the daily infected from a reference
+ * solution (RKF8, relative accuracy 1e-11) over the peak of the reference.
+ *
+ * Usage: bench_continuous [experiment]
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file continuous.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Continuous.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Keeps the infected of every day
+    class InfectedSink : public TrajectorySink {
+    public:
+        vector<double> values;
+
+        int open(const vector<string> &columns) override {
+            column = find(columns.begin(), columns.end(), "I") - columns.begin();
+            values.clear();
+            return 0;
+        }
+
+        void write(const double *row) override { values.push_back(row[column]); }
+        int close() override { return 0; }
+
+    private:
+        size_t column = 0;
+    };
+
+    class EulerObserver : public Model::Observer {
+    public:
+        InfectedSink &sink;
+        int column;
+
+        EulerObserver(InfectedSink &sink, int column) : sink(sink), column(column) {}
+        void day(const Model &model) override { sink.values.push_back(model.getState()[column]); }
+    };
+
+    struct Result {
+        string method, setting;
+        double error, seconds;
+        long steps;
+    };
+
+    double error(const vector<double> &values, const vector<double> &reference) {
+        double peak = *max_element(reference.begin(), reference.end()), worst = 0.0;
+        for (size_t day = 0; day < reference.size(); day++) {
+            worst = max(worst, fabs(values[day] - reference[day]));
+        }
+        return worst / peak;
+    }
+
+    // Repeats a run for at least 50 ms, returns seconds per run
+    template<typename Run>
+    double measure(Run run) {
+        auto start = chrono::steady_clock::now();
+        unsigned runs = 0;
+        double seconds;
+        do {
+            run();
+            runs++;
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        } while (seconds < 0.05);
+        return seconds / runs;
+    }
+
+    char *format(const char *pattern, double value) {
+        static char text[32];
+        snprintf(text, sizeof(text), pattern, value);
+        return text;
+    }
+}
+
+int main(int argc, char **argv) {
+    int experiment = argc > 1 ? atoi(argv[1]) : 4;
+    if (experiment < 1 || experiment > 4) {
+        return 1;
+    }
+    const unsigned long days = Date::reportDays;
+    const Model::Parameters parameters = Model::Parameters::experiment(experiment);
+
+    InfectedSink sink;
+    ContinuousModel reference(parameters);
+    reference.setMethod(ContinuousModel::RKF8);
+    reference.setAccuracy(1e-11);
+    reference.simulate(days, &sink);
+    const vector<double> exact = sink.values;
+
+    vector<Result> results;
+
+    // Daily step of Model
+    Model model(parameters);
+    EulerObserver observer(sink, model.compartment("I"));
+    model.addObserver(observer);
+    Result daily = { "model", "h=1", 0.0, 0.0, (long)days };
+    daily.seconds = measure([&]() {
+        sink.values.clear();
+        model.reset();
+        model.runTo(days);
+    });
+    daily.error = error(sink.values, exact);
+    results.push_back(daily);
+
+    vector<ContinuousModel::Method> methods;
+    vector<string> names, settings;
+    vector<double> values;
+    for (double h = 1.0; h >= 1.0 / 64; h /= 2) {
+        methods.push_back(ContinuousModel::EULER);
+        names.push_back("euler");
+        settings.push_back(string("h=") + format("%g", h));
+        values.push_back(h);
+    }
+    for (ContinuousModel::Method method : { ContinuousModel::RKF5, ContinuousModel::RKF8 }) {
+        for (double accuracy = 1e-2; accuracy >= 1e-9; accuracy /= 10) {
+            methods.push_back(method);
+            names.push_back(method == ContinuousModel::RKF5 ? "rkf5" : "rkf8");
+            settings.push_back(string("tol=") + format("%.0e", accuracy));
+            values.push_back(accuracy);
+        }
+    }
+
+    for (size_t i = 0; i < methods.size(); i++) {
+        ContinuousModel ode(parameters);
+        ode.setMethod(methods[i]);
+        if (methods[i] == ContinuousModel::EULER) {
+            ode.setStep(values[i], values[i]);
+        } else {
+            ode.setAccuracy(values[i]);
+        }
+        Result result = { names[i], settings[i], 0.0, 0.0, 0 };
+        result.seconds = measure([&]() { ode.simulate(days, &sink); });
+        result.error = error(sink.values, exact);
+        result.steps = ode.getSteps();
+        results.push_back(result);
+    }
+
+    printf("experiment %d, %lu days\n", experiment, days);
+    printf("%-6s %-10s %12s %8s %12s\n", "method", "setting", "error", "steps", "time");
+    for (const Result &result : results) {
+        printf("%-6s %-10s %12.3e %8ld %9.1f us\n", result.method.c_str(), result.setting.c_str(),
+               result.error, result.steps, result.seconds * 1e6);
+    }
+
+    printf("\n%-8s %-6s %-10s %12s\n", "budget", "method", "setting", "time");
+    for (double budget = 1e-1; budget >= 1e-8; budget /= 10) {
+        const Result *best = nullptr;
+        for (const Result &result : results) {
+            if (result.error <= budget && (!best || result.seconds < best->seconds)) {
+                best = &result;
+            }
+        }
+        if (best) {
+            printf("%-8.0e %-6s %-10s %9.1f us\n", budget, best->method.c_str(), best->setting.c_str(), best->seconds * 1e6);
+        } else {
+            printf("%-8.0e none\n", budget);
+        }
+    }
+    return 0;
+}
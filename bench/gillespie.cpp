@@ -0,0 +1,62 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Benchmark of the exact stochastic simulation: events per second of the
+ * direct and next reaction methods against population size
+ *
+ * Usage: bench_gillespie [model declaration] [days]
+ *  without a declaration the SEIRD model of Model starting with 10 infected
+ *  is scaled from a village to a city, a declaration is run as it is
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file gillespie.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Gillespie.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const char *const methodNames[] = { "direct", "next-reaction" };
+
+    void run(const CompartmentModel<double> &model, unsigned long days) {
+        for (Gillespie::Method method : { Gillespie::DIRECT, Gillespie::NEXT_REACTION }) {
+            Gillespie ssa(model, 1, method);
+            auto start = chrono::steady_clock::now();
+            uint64_t events = ssa.advance((double)days);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            printf("%12.0f %-14s %12llu %10.4f s %12.3g events/s\n", model.getPopulation(), methodNames[method],
+                   (unsigned long long)events, seconds, events / seconds);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned long days = argc > 2 ? strtoul(argv[2], nullptr, 10) : 200;
+    printf("%12s %-14s %12s %12s %12s\n", "population", "method", "events", "time", "rate");
+
+    if (argc > 1) {
+        CompartmentModel<double> model;
+        if (model.load(argv[1]) != 0) {
+            return 1;
+        }
+        run(model, days);
+        return 0;
+    }
+
+    const double parameters[] = { 0.0556 * 5.6015, 0.0556, 0.1923, 0.0034 };
+    for (double N = 1e2; N <= 1e6; N *= 10) {
+        CompartmentModel<double> model = CompartmentModel<double>::seird(N, 10.0, 0.0);
+        for (int p = 0; p < 4; p++) {
+            model.setParameter(p, parameters[p]);
+        }
+        run(model, days);
+    }
+    return 0;
+}
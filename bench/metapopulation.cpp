@@ -0,0 +1,114 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Benchmark of the metapopulation engine on a synthetic country: regions on
+ * a square grid exchanging commuters with their four neighbours, every
+ * region split into age groups with a dense age mixing matrix
+ *
+ * Usage: bench_metapopulation [regions] [age groups] [days] [threads]
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file metapopulation.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Metapopulation.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    double seconds(chrono::steady_clock::time_point start) {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    void build(Metapopulation &model) {
+        size_t regions = model.getRegions(), groups = model.getGroups();
+        size_t side = (size_t)ceil(sqrt((double)regions));
+
+        // Most contacts within the own age group, fewer with distant ones
+        vector<double> mixing(groups * groups);
+        double rowSum = 0.0;
+        for (size_t a = 0; a < groups; a++) {
+            for (size_t b = 0; b < groups; b++) {
+                mixing[a * groups + b] = 1.0 / (1.0 + fabs((double)a - (double)b));
+            }
+        }
+        for (size_t b = 0; b < groups; b++) {
+            rowSum += mixing[b];
+        }
+
+        for (size_t r = 0; r < regions; r++) {
+            // Four percent of the contacts of a region happen in each neighbour
+            size_t x = r % side, y = r / side;
+            vector<pair<size_t, double>> mobility = { { r, 1.0 } };
+            if (x > 0) mobility.push_back({ r - 1, 0.04 });
+            if (x + 1 < side && r + 1 < regions) mobility.push_back({ r + 1, 0.04 });
+            if (y > 0) mobility.push_back({ r - side, 0.04 });
+            if (r + side < regions) mobility.push_back({ r + side, 0.04 });
+            for (const pair<size_t, double> &other : mobility) {
+                for (size_t a = 0; a < groups; a++) {
+                    for (size_t b = 0; b < groups; b++) {
+                        model.addContact(model.patch(r, a), model.patch(other.first, b),
+                                         other.second * mixing[a * groups + b] / rowSum);
+                    }
+                }
+            }
+        }
+
+        // Hubei population spread evenly, the first cases in region 0
+        double N = 58500000.0 / (regions * groups);
+        for (size_t i = 0; i < model.patches(); i++) {
+            bool seeded = i < groups;
+            model.setPopulation(i, N, seeded ? 27.0 * 20.0 / groups : 0.0, seeded ? 27.0 / groups : 0.0);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t regions = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+    size_t groups = argc > 2 ? strtoul(argv[2], nullptr, 10) : 16;
+    unsigned long days = argc > 3 ? strtoul(argv[3], nullptr, 10) : 365;
+    unsigned threads = argc > 4 ? (unsigned)strtoul(argv[4], nullptr, 10) : 0;
+    if (regions == 0 || groups == 0) {
+        return 1;
+    }
+
+    Metapopulation serial(regions, groups), parallel(regions, groups);
+    build(serial);
+    build(parallel);
+    serial.setThreads(1);
+    parallel.setThreads(threads);
+    printf("regions=%zu groups=%zu patches=%zu contacts=%zu days=%lu\n",
+           regions, groups, serial.patches(), serial.nonZeros(), days);
+    parallel.nonZeros();
+
+    auto start = chrono::steady_clock::now();
+    serial.simulate(days);
+    double serialTime = seconds(start);
+
+    start = chrono::steady_clock::now();
+    parallel.simulate(days);
+    double parallelTime = seconds(start);
+
+    bool identical = memcmp(serial.getI(), parallel.getI(), serial.patches() * sizeof(double)) == 0
+                     && memcmp(serial.getS(), parallel.getS(), serial.patches() * sizeof(double)) == 0;
+    double contacts = (double)serial.nonZeros() * days;
+    printf("%-8s %10.4f s %8.2f ns/contact-day\n", "serial", serialTime, serialTime * 1e9 / contacts);
+    printf("%-8s %10.4f s %8.2f ns/contact-day  speedup %6.1fx  identical %s\n", "parallel", parallelTime,
+           parallelTime * 1e9 / contacts, serialTime / parallelTime, identical ? "yes" : "no");
+
+    double infected = 0.0, dead = 0.0;
+    for (size_t i = 0; i < serial.patches(); i++) {
+        infected += serial.getSumInfected()[i];
+        dead += serial.getD()[i];
+    }
+    printf("infected %.0f dead %.0f\n", infected, dead);
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Benchmark of the particle filter: particle days per second of a filter
+ * fed with the daily reports of the SIERD experiment with measures
+ *
+ * Usage: bench_particles [particles] [days] [threads]
+ *  defaults 100000 particles over 365 days on every hardware thread
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file particles.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/ParticleFilter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char **argv) {
+    size_t particles = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+    unsigned long days = argc > 2 ? strtoul(argv[2], nullptr, 10) : 365;
+    unsigned threads = argc > 3 ? (unsigned)strtoul(argv[3], nullptr, 10) : 0;
+
+    // Reports of the deterministic model
+    Model model(Model::Parameters::experiment(4));
+    vector<double> cases(1, 0.0);
+    double sum = model.getStats().sumInfected;
+    while (model.getDay() < days) {
+        model.step();
+        cases.push_back(round(model.getStats().sumInfected - sum));
+        sum = model.getStats().sumInfected;
+    }
+
+    ParticleFilter filter(Model::Parameters::experiment(4), particles);
+    filter.setThreads(threads);
+    unsigned long resamplings = 0;
+    auto start = chrono::steady_clock::now();
+    for (unsigned long day = 1; day <= days; day++) {
+        filter.assimilate(day, cases[day]);
+        resamplings += filter.getStep().resampled;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%12s %8s %12s %10s %14s %12s\n", "particles", "days", "resamplings", "time", "rate", "log lik.");
+    printf("%12zu %8lu %12lu %8.3f s %10.3g p*d/s %12.1f\n", particles, days, resamplings, seconds,
+           particles * days / seconds, filter.getLogLikelihood());
+    return 0;
+}
@@ -3,7 +3,9 @@
     Data plotting
 """
 import matplotlib.pyplot as plt
+import numpy
 import pandas
+import struct
 import sys
 import datetime
 from dateutil import relativedelta
@@ -12,16 +14,107 @@ from matplotlib.dates import (DAILY, DateFormatter,
 
 model = ""
 
+BINARY_MAGIC = b"IMSTRAJ\0"
+BINARY_HEADER = struct.Struct("<8sIIQ")
+BINARY_NAME_SIZE = 16
+BINARY_ALIGNMENT = 64
+
+def read_binary(filename: str) -> dict:
+    """
+    Maps file in the binary columnar format (see src/headers/Output.h)
+    and returns column name -> numpy array without copying the data
+    """
+    with open(filename, "rb") as file:
+        magic, version, columns, rows = BINARY_HEADER.unpack(file.read(BINARY_HEADER.size))
+        if magic != BINARY_MAGIC or version != 2:
+            raise ValueError(filename + " is not a binary trajectory")
+        names = [file.read(BINARY_NAME_SIZE).rstrip(b"\0").decode() for _ in range(columns)]
+
+    header = BINARY_HEADER.size + columns * BINARY_NAME_SIZE
+    offset = (header + BINARY_ALIGNMENT - 1) // BINARY_ALIGNMENT * BINARY_ALIGNMENT
+    # Every column is padded to a multiple of the alignment
+    stride = (rows * 8 + BINARY_ALIGNMENT - 1) // BINARY_ALIGNMENT * BINARY_ALIGNMENT // 8
+    data = numpy.memmap(filename, dtype="<f8", mode="r", offset=offset, shape=(columns, stride))
+    return {name: data[i, :rows] for i, name in enumerate(names)}
+
+DELTA_MAGIC = b"IMSDLOG\0"
+DELTA_HEADER = struct.Struct("<8sIIII")
+DELTA_TRAILER = struct.Struct("<QQ8s")
+
+def read_varint(data: bytes, at: int):
+    """
+    Decodes a varint, returns the value and the position after it
+    """
+    value, shift = 0, 0
+    while True:
+        byte = data[at]
+        at += 1
+        value |= (byte & 0x7f) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, at
+
+def read_delta(filename: str) -> dict:
+    """
+    Decodes the compressed trajectory log (see DeltaSink in src/headers/Output.h)
+    and returns column name -> numpy array
+    """
+    with open(filename, "rb") as file:
+        data = file.read()
+    magic, version, columns, block_rows, _ = DELTA_HEADER.unpack_from(data, 0)
+    index, rows, end_magic = DELTA_TRAILER.unpack_from(data, len(data) - DELTA_TRAILER.size)
+    if magic != DELTA_MAGIC or end_magic != DELTA_MAGIC or version != 1:
+        raise ValueError(filename + " is not a trajectory log")
+
+    at = DELTA_HEADER.size
+    names = []
+    for _ in range(columns):
+        size, at = read_varint(data, at)
+        names.append(data[at:at + size].decode())
+        at += size
+
+    values = [[] for _ in range(columns)]
+    blocks = (rows + block_rows - 1) // block_rows
+    for block in range(blocks):
+        at = struct.unpack_from("<Q", data, index + 8 * block)[0]
+        count = min(block_rows, rows - block * block_rows)
+        for column in values:
+            encoding = data[at]
+            at += 1
+            previous, change = 0, 0
+            for _ in range(count):
+                if encoding == 0:
+                    delta, at = read_varint(data, at)
+                    change += (delta >> 1) ^ -(delta & 1)
+                    previous += change
+                    column.append(float(previous))
+                else:
+                    low, stored = data[at] >> 4, data[at] & 0xf
+                    previous ^= int.from_bytes(data[at + 1:at + 1 + stored], "little") << (8 * low)
+                    at += 1 + stored
+                    column.append(struct.unpack("<d", previous.to_bytes(8, "little"))[0])
+    return {name: numpy.array(values[i]) for i, name in enumerate(names)}
+
+def read_data(filename: str):
+    """
+    Reads CSV, binary (.bin) or compressed log (.delta) data file
+    """
+    if filename.endswith(".bin"):
+        return read_binary(filename)
+    if filename.endswith(".delta"):
+        return read_delta(filename)
+    return pandas.read_csv(filename)
+
 def main(filename: str) -> None:
     """
-    Reads file in CSV format and visualises the data it contains
+    Reads data file and visualises the data it contains
     """
 
-    # Read CSV file
-    df = pandas.read_csv(filename)
+    # Read CSV or binary file
+    df = read_data(filename)
 
     # Get data set size
-    steps = df.index.stop
+    steps = len(df['S'])
     discrete_steps = list(range(steps))
 
     S = df['S'] # Susceptible
@@ -98,10 +191,11 @@ def without_susceptible(E, I, R, D, discrete_steps):
 
 if __name__ == '__main__':
     model = sys.argv[1]
+    filename = sys.argv[2] if len(sys.argv) > 2 else "statistics/data.csv"
     if model == "SIR":
-        main("statistics/data.csv")
+        main(filename)
     elif model == "SEIRD":
-        main("statistics/data.csv")
+        main(filename)
     else:
         pass
 
@@ -25,6 +25,7 @@ void SIMLIB_atexit(SIMLIB_atexit_function_t p) {
     DEBUG(DBG_ATEXIT,("SIMLIB_atexit(%p)", p ));
     int i;
     for(i=0; i<MAX_ATEXIT; i++) {
+       if(atexit_array[i]==p) return; // registered already (e.g. SetCalendar)
        if(atexit_array[i]==0) break;
     }
     if(i<MAX_ATEXIT)
@@ -21,6 +21,8 @@
 #include "internal.h"
 #include <cmath>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 
 //#define MEASURE // comment this to switch off
 #ifdef MEASURE
@@ -61,6 +63,52 @@ namespace simlib3 {
 
 SIMLIB_IMPLEMENTATION;
 
+class Calendar;
+
+////////////////////////////////////////////////////////////////////////////
+/// current-time bucket: items of the first activation time
+//
+// When the run takes the first item, the other items of its time are
+// taken out of the calendar at once into a contiguous array (in calendar
+// order) and the run dispatches them from there. The records stay linked
+// with their entities, so the entities are still scheduled: Get() leaves
+// a hole in the array. Until the time of the bucket changes, scheduling
+// at it puts the item at its place in the array - at the end, unless it
+// has a higher priority - instead of searching the calendar, so a zero
+// delay event costs an append and a pop.
+//
+class CurrentBucket {
+    std::vector<EventNotice *> items; // time/priority/FIFO order, 0 = removed
+    unsigned first;                   // next item to dispatch
+    unsigned count;                   // items not removed
+    double time;                      // activation time of items
+    bool active;                      // time was dispatched by the run
+  public:
+    CurrentBucket(): first(0), count(0), time(SIMLIB_MAXTIME), active(false) {}
+    bool empty() const { return count == 0; }
+    unsigned size() const { return count; }
+    /// activation time of items, time of the last item dispatched if empty
+    double Time() const { return time; }
+    /// items of time t belong to the bucket (t dispatched, not cleared since)
+    bool accepts(double t) const { return active && t == time; }
+    /// first record to dispatch, from the array or calendar c (not both empty),
+    /// the record stays linked with its entity
+    EventNotice *next(Calendar *c);
+    /// dispatch first item of the array
+    EventNotice *pop();
+    /// add record of the same time after items of higher or equal priority
+    void insert(EventNotice *evn);
+    /// remove record (rescheduling)
+    void remove(EventNotice *evn);
+    /// remove all items
+    /// @param destroy  deallocates entities if true
+    void clear(bool destroy);
+#ifndef NDEBUG
+    /// for debugging only
+    void debug_print();
+#endif
+};
+
 /// common interface for all calendar (PES) implementations
 class Calendar { // abstract base class
   public:
@@ -68,8 +116,10 @@ class Calendar { // abstract base class
     unsigned Size()  const { return _size; }
     /// enqueue
     virtual void     ScheduleAt(Entity *e, double t) = 0;
-    /// dequeue first
-    virtual Entity * GetFirst() = 0;
+    /// enqueue n entities sorted by priority (descending) at time t
+    virtual void     ScheduleBatch(Entity *const *e, unsigned long n, double t);
+    /// dequeue first, the record stays linked with its entity
+    virtual EventNotice * ExtractFirst() = 0;
     /// dequeue
     virtual Entity * Get(Entity *e) = 0;
     /// remove all scheduled entities
@@ -80,6 +130,10 @@ class Calendar { // abstract base class
 #endif
     /// time of activation of first item
     double MinTime() const { return mintime; }
+    /// number of reorganizations of the structure (statistics)
+    unsigned long Resizes() const { return resizes; }
+    /// items of the first time taken out for dispatch by SQS
+    CurrentBucket current;
   protected:
     /// set cache for faster access
     void SetMinTime(double t) { mintime=t; }
@@ -88,6 +142,7 @@ class Calendar { // abstract base class
   // data
   protected:
     unsigned _size;     //!< number of scheduled items
+    unsigned long resizes; //!< resize, rung spawn, ... (statistics)
   private:
     double mintime;     //!< activation time of first event
   ///////////////////////////////////////////////////////////////////////////
@@ -99,7 +154,7 @@ class Calendar { // abstract base class
         return _instance != 0;
     }
   protected:
-    Calendar(): _size(0), mintime(SIMLIB_MAXTIME) {}
+    Calendar(): _size(0), resizes(0), mintime(SIMLIB_MAXTIME) {}
     virtual ~Calendar() {} //!< clear is called in derived class dtr
     static void delete_instance();      //!< destroy single instance
   private:
@@ -146,12 +201,18 @@ struct EventNotice : public EventNoticeLinkBase {
     double time;
     /// priority at the time of scheduling
     Entity::Priority_t priority;
+    /// position in the array of CalendarHeap or of the current-time bucket
+    unsigned index;
+    /// in the current-time bucket (taken out of calendar, still scheduled)
+    bool current;
 
     EventNotice(Entity *p, double t) :
         //inherited: pred(this), succ(this), // == NOT linked
         entity(p),              // which entity
         time(t),                // activation time
-        priority(p->Priority)   // current scheduling priority
+        priority(p->Priority),  // current scheduling priority
+        index(0),
+        current(false)
     {
         create_reverse_link();
     }
@@ -178,6 +239,7 @@ struct EventNotice : public EventNoticeLinkBase {
         entity = e;             // which entity
         time = t;               // activation time
         priority = e->Priority; // current scheduling priority
+        current = false;
         create_reverse_link();
     }
 
@@ -243,6 +305,14 @@ class EventNoticeAllocator {
 
 
 
+////////////////////////////////////////////////////////////////////////////
+/// check of batch item: entity is not scheduled (and not twice in batch)
+inline void check_batch_item(Entity *e)
+{
+  if(!e->Idle())
+      SIMLIB_error("ScheduleBatch: entity is already scheduled");
+}
+
 ////////////////////////////////////////////////////////////////////////////
 /// class CalendarListImplementation --- sorted list
 //    +-----------------------------------------------------+
@@ -311,6 +381,25 @@ public:
       evn->insert(*pos); // insert before pos
     }
 
+    /// enqueue of n entities sorted by priority (descending) at time t
+    /// <br> one pass from the back, the batch keeps its order (FIFO)
+    void insert_batch(Entity *const *e, unsigned long n, double t) {
+      iterator pos = end();
+      for(unsigned long i = n; i-- > 0; ) {
+        check_batch_item(e[i]);
+        EventNotice *evn = EventNotice::Create(e[i],t);
+        iterator prev = pos;
+        --prev;
+        while(prev!=end() && ((*prev)->time > t ||             // later time
+              ((*prev)->time==t && (*prev)->priority < evn->priority))) {
+          pos = prev;
+          --prev;
+        }
+        evn->insert(*pos); // insert before pos
+        pos = evn;         // next one goes before it
+      }
+    }
+
     /// special dequeue operation for rescheduling
     Entity *remove(Entity *e) {
       EventNotice::Destroy(e->GetEventNotice());   // disconnect, remove item
@@ -353,6 +442,15 @@ public:
       iterator pos = search(evn);
       evn->insert(*pos); // insert before pos
     }
+    /// unsorted enqueue at the end (buckets of ladder queue)
+    void append(Entity *e, double t) {
+      EventNotice *evn = EventNotice::Create(e,t);
+      evn->insert(*end());
+    }
+    /// unsorted enqueue of extracted record at the end
+    void append_extracted(EventNotice *evn) {
+      evn->insert(*end());
+    }
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -363,11 +461,13 @@ class CalendarList : public Calendar {
   public:
     /// enqueue
     virtual void ScheduleAt(Entity *p, double t);
+    /// enqueue batch in one pass
+    virtual void ScheduleBatch(Entity *const *e, unsigned long n, double t);
 
     /// dequeue
     virtual Entity *Get(Entity *p);              // remove process p from calendar
     /// dequeue first entity
-    virtual Entity *GetFirst();
+    virtual EventNotice *ExtractFirst();
     /// remove all
     virtual void clear(bool destroy=false); // remove/destroy all items
 
@@ -405,6 +505,16 @@ public:
 
 
 
+////////////////////////////////////////////////////////////////////////////
+/// enqueue batch one by one (implementations without a faster way)
+void Calendar::ScheduleBatch(Entity *const *e, unsigned long n, double t)
+{
+  for(unsigned long i = 0; i < n; ++i) {
+      check_batch_item(e[i]);
+      ScheduleAt(e[i], t);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////
 /// creates new EventNotice,
 inline EventNotice *EventNotice::Create(Entity *e, double t)
@@ -434,6 +544,88 @@ inline void EventNotice::Destroy(EventNotice *en)
   allocator.free(en);   // disconnect, remove item
 }
 
+////////////////////////////////////////////////////////////////////////////
+// CurrentBucket implementation
+//
+EventNotice *CurrentBucket::next(Calendar *c)
+{
+  if(count > 0)
+      return pop();
+  time = c->MinTime();
+  active = true;
+  EventNotice *evn = c->ExtractFirst();
+  // other items of the same time wait in the array
+  while(!c->Empty() && c->MinTime() == time) {
+      EventNotice *other = c->ExtractFirst();
+      other->current = true;
+      other->index = items.size();
+      items.push_back(other);
+  }
+  count = items.size();
+  return evn;
+}
+
+EventNotice *CurrentBucket::pop()
+{
+  while(items[first] == 0)  // skip removed
+      ++first;
+  EventNotice *evn = items[first++];
+  evn->current = false;
+  if(--count == 0) {
+      items.clear();
+      first = 0;
+  }
+  return evn;
+}
+
+void CurrentBucket::insert(EventNotice *evn)
+{
+  // search from back, usually the end
+  unsigned pos = items.size();
+  while(pos > first && (items[pos-1] == 0 || items[pos-1]->priority < evn->priority))
+      --pos;
+  evn->current = true;
+  evn->index = pos;
+  if(pos == items.size())
+      items.push_back(evn);
+  else {
+      items.insert(items.begin() + pos, evn);
+      for(unsigned i = pos + 1; i < items.size(); ++i)
+          if(items[i])
+              items[i]->index = i;
+  }
+  ++count;
+}
+
+void CurrentBucket::remove(EventNotice *evn)
+{
+  items[evn->index] = 0;
+  evn->current = false;
+  if(--count == 0) {
+      items.clear();
+      first = 0;
+  }
+}
+
+void CurrentBucket::clear(bool destroy)
+{
+  for(unsigned i = first; i < items.size(); ++i) {
+      EventNotice *evn = items[i];
+      if(evn == 0)
+          continue;
+      Entity *e = evn->entity;
+      evn->current = false;
+      evn->delete_reverse_link();
+      EventNotice::Destroy(evn);
+      if (destroy && e->isAllocated()) delete e; // delete entity
+  }
+  items.clear();
+  first = 0;
+  count = 0;
+  time = SIMLIB_MAXTIME;
+  active = false;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 ///  schedule entity e at time t
 void CalendarList::ScheduleAt(Entity *e, double t)
@@ -448,23 +640,35 @@ void CalendarList::ScheduleAt(Entity *e, double t)
       SetMinTime(l.first_time());
 }
 
+////////////////////////////////////////////////////////////////////////////
+///  schedule batch of entities at time t
+void CalendarList::ScheduleBatch(Entity *const *e, unsigned long n, double t)
+{
+  if(t<Time)
+      SIMLIB_error(SchedulingBeforeTime);
+  l.insert_batch(e,n,t);
+  _size += n;
+  if(t < MinTime())
+      SetMinTime(l.first_time());
+}
+
 ////////////////////////////////////////////////////////////////////////////
 /// delete first entity
-Entity *CalendarList::GetFirst()
+EventNotice *CalendarList::ExtractFirst()
 {
-//  Dprintf(("CalendarList::GetFirst(): size=%u", Size()));
+//  Dprintf(("CalendarList::ExtractFirst(): size=%u", Size()));
 
   if(Empty())
       SIMLIB_error(EmptyCalendar);
 
-  Entity *e = l.remove_first();
+  EventNotice *evn = l.extract_first();
   --_size;
 
   if(Empty())
       SetMinTime(SIMLIB_MAXTIME);
   else
       SetMinTime(l.first_time());
-  return e;
+  return evn;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -580,11 +784,13 @@ class CalendarQueue : public Calendar {
   public:
     /// enqueue
     virtual void ScheduleAt(Entity *p, double t);
+    /// enqueue batch into one bucket
+    virtual void ScheduleBatch(Entity *const *e, unsigned long n, double t);
 
     /// dequeue
     virtual Entity *Get(Entity *p);              // remove process p from calendar
     /// dequeue first
-    virtual Entity *GetFirst();
+    virtual EventNotice *ExtractFirst();
     /// remove all
     virtual void clear(bool destroy=false); // remove/destroy all items
 
@@ -674,12 +880,45 @@ void CalendarQueue::ScheduleAt(Entity *e, double t)
     }
 }
 
+////////////////////////////////////////////////////////////////////////////
+/// schedule batch: all items go to the same bucket, searched once
+void CalendarQueue::ScheduleBatch(Entity *const *e, unsigned long n, double t)
+{
+    Dprintf(("CalendarQueue::ScheduleBatch(%lu,%g)", n, t));
+    if(t<Time)
+        SIMLIB_error(SchedulingBeforeTime);
+
+    // if overgrown
+    if(_size>LIST_MAX && list_impl())
+        switchtocq();
+
+    if(list_impl()) {
+        list.insert_batch(e,n,t);
+    }
+    else {
+        // as many resizes as the items one by one would do
+        while(_size + n > hi_bucket_mark)
+            Resize(+1);
+
+        numop += n;
+        if(numop > MAX_OP) // tune each MAX_OP edit operations
+            Resize();
+
+        buckets[time2bucket(t)].insert_batch(e,n,t);
+    }
+    _size += n;
+    // update mintime
+    if (MinTime() > t) {
+        SetMinTime(t);
+    }
+}
+
 
 ////////////////////////////////////////////////////////////////////////////
 ///  dequeue
-Entity * CalendarQueue::GetFirst()
+EventNotice * CalendarQueue::ExtractFirst()
 {
-//  Dprintf(("CalendarQueue::GetFirst()"));
+//  Dprintf(("CalendarQueue::ExtractFirst()"));
   if(Empty())
       SIMLIB_error(EmptyCalendar);
 
@@ -687,14 +926,14 @@ Entity * CalendarQueue::GetFirst()
       switchtolist();
 
   if(list_impl()) {
-      Entity * e = list.remove_first();
+      EventNotice * evn = list.extract_first();
       // update size
       --_size;
       if(Empty())
           SetMinTime(SIMLIB_MAXTIME);
       else
           SetMinTime(list.first_time());
-      return e;
+      return evn;
   }
 
   // else
@@ -714,7 +953,7 @@ Entity * CalendarQueue::GetFirst()
   nextbucket = time2bucket(min_time); // TODO: optimization
   BucketList & bp = buckets[nextbucket];
   // get first item
-  Entity * e = bp.remove_first();
+  EventNotice * evn = bp.extract_first();
   // update size
   --_size;
   if (_size < low_bucket_mark)
@@ -723,7 +962,7 @@ Entity * CalendarQueue::GetFirst()
       Resize();
   // update mintime
   SearchMinTime(MinTime());
-  return e;
+  return evn;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -955,6 +1194,7 @@ void CalendarQueue::Resize(int grow)  // TODO: is it better to use target size?
 
     if(oldnbuckets == nbuckets && !bucket_width_changed) // no change
         return;
+    ++resizes;
 
     // allocate new bucket array
     buckets = new BucketList[nbuckets];  // initialized by default constructors
@@ -995,6 +1235,7 @@ void CalendarQueue::switchtolist()
 #ifdef MEASURE
   OP_MEASURE |= OP_SWITCH2LIST;
 #endif
+    ++resizes;
 
     // fill list from CQ
     for (unsigned n = 0; n < nbuckets; ++n) {
@@ -1020,6 +1261,7 @@ void CalendarQueue::switchtocq()
 #ifdef MEASURE
   OP_MEASURE |= OP_SWITCH2CQ;
 #endif
+    ++resizes;
 
     // _size does not change
     // MinTime unchanged
@@ -1123,6 +1365,616 @@ CalendarQueue::~CalendarQueue()
 }
 
 
+
+/////////////////////////////////////////////////////////////////////////////
+// CalendarLadder tunable parameters:
+
+// bucket size limit: longer buckets spawn a new rung, shorter go to bottom
+const unsigned LADDER_THRES = 50;
+
+// maximal number of rungs (deeper buckets are sorted into bottom)
+const unsigned LADDER_MAXRUNGS = 8;
+
+////////////////////////////////////////////////////////////////////////////
+/// Ladder queue implementation of calendar [tang2005]
+//
+//  top:    unsorted list of items later than topstart (far future)
+//  rungs:  arrays of unsorted buckets, each rung splits one bucket of the
+//          rung above (rung 0 splits top), current bucket moves forward
+//  bottom: short sorted list of the first items
+//
+// Each item is moved a bounded number of times (at most once per rung) and
+// buckets are only ever sorted when short, so enqueue and dequeue are
+// amortized O(1) without any rehash of the whole calendar. Bucket index is
+// computed by one division, no fmod. Items are routed by their time only,
+// so items with equal time always meet in the same bucket or list and
+// the order time/priority/FIFO of CalendarList is kept.
+//
+class CalendarLadder : public Calendar {
+    typedef CalendarListImplementation BucketList;
+
+    /// rung of the ladder
+    struct Rung {
+        BucketList *buckets;    // bucket array
+        unsigned capacity;      // allocated buckets
+        unsigned nbuckets;      // used buckets
+        unsigned current;       // first bucket not yet moved down
+        double start;           // time of bucket 0 start
+        double width;           // bucket width
+        Rung(): buckets(0), capacity(0), nbuckets(0), current(0), start(0), width(0) {}
+    };
+
+    BucketList top;         // unsorted, items with time > topstart
+    double topstart;        // latest time of rungs and bottom
+    Rung rungs[LADDER_MAXRUNGS];
+    unsigned nrungs;        // rungs in use, rungs[nrungs-1] is the lowest
+    BucketList bottom;      // sorted list, items before the lowest rung
+    unsigned bottom_size;   // items in bottom, may overestimate after Get()
+    unsigned bottom_limit;  // bottom_size to split bottom, higher if it can not be
+
+  private:
+    /// bucket of rung for time t, false if t is before its current bucket
+    bool time2bucket(const Rung &r, double t, unsigned &b) {
+        double d = (t - r.start) / r.width;
+        if (!(d >= r.current))
+            return false;
+        b = d < r.nbuckets ? static_cast<unsigned>(d) : r.nbuckets - 1;
+        if (b < r.current)      // rounding at the bucket boundary
+            return false;
+        return true;
+    }
+
+    void spawn(BucketList &from, unsigned count, double min, double max);
+    void bottom2rung();
+    void refill();
+    void update_mintime();
+
+  public:
+    /// enqueue
+    virtual void ScheduleAt(Entity *p, double t);
+    /// enqueue batch
+    virtual void ScheduleBatch(Entity *const *e, unsigned long n, double t);
+
+    /// dequeue
+    virtual Entity *Get(Entity *p);              // remove process p from calendar
+    /// dequeue first
+    virtual EventNotice *ExtractFirst();
+    /// remove all
+    virtual void clear(bool destroy=false); // remove/destroy all items
+
+    /// create calendar instance
+    static CalendarLadder * create() {  // create instance
+        Dprintf(("CalendarLadder::create()"));
+        CalendarLadder *l = new CalendarLadder;
+        SIMLIB_atexit(delete_instance);     // last SIMLIB module cleanup calls it
+        return l;
+    }
+
+    virtual const char* Name() { return "CalendarLadder"; }
+ private:
+    CalendarLadder();
+    ~CalendarLadder();
+
+public:
+#ifndef NDEBUG
+    virtual void debug_print(); // print of calendar contents - FOR DEBUGGING ONLY
+#endif
+}; // CalendarLadder
+
+/////////////////////////////////////////////////////////////////////////////
+/// Initialize ladder queue
+CalendarLadder::CalendarLadder():
+    topstart(0.0),
+    nrungs(0),
+    bottom_size(0),
+    bottom_limit(LADDER_THRES)
+{
+    Dprintf(("CalendarLadder::CalendarLadder()"));
+    SetMinTime( SIMLIB_MAXTIME ); // empty
+}
+
+/// schedule
+void CalendarLadder::ScheduleAt(Entity *e, double t)
+{
+    Dprintf(("CalendarLadder::ScheduleAt(%s,%g)", e->Name(), t));
+    if(t<Time)
+        SIMLIB_error(SchedulingBeforeTime);
+
+    if(Empty()) {           // new epoch
+        nrungs = 0;
+        topstart = t;
+        bottom.insert(e,t);
+        bottom_size = 1;
+        bottom_limit = LADDER_THRES;
+    }
+    else if(t > topstart)   // far future
+        top.append(e,t);
+    else {
+        unsigned n, b = 0;
+        for(n = 0; n < nrungs; ++n)
+            if(time2bucket(rungs[n], t, b))
+                break;
+        if(n < nrungs)
+            rungs[n].buckets[b].append(e,t);
+        else {              // before the lowest rung
+            bottom.insert(e,t);
+            if(++bottom_size > bottom_limit && nrungs < LADDER_MAXRUNGS)
+                bottom2rung();
+        }
+    }
+    ++_size;
+    update_mintime();
+}
+
+/// schedule batch: items of the same time go to the same place
+void CalendarLadder::ScheduleBatch(Entity *const *e, unsigned long n, double t)
+{
+    Dprintf(("CalendarLadder::ScheduleBatch(%lu,%g)", n, t));
+    if(t<Time)
+        SIMLIB_error(SchedulingBeforeTime);
+    if(n == 0)
+        return;
+
+    unsigned r = 0, b = 0;
+    if(Empty()) {           // new epoch
+        nrungs = 0;
+        topstart = t;
+        bottom_size = 0;
+        bottom_limit = LADDER_THRES;
+    }
+    else if(t > topstart) { // far future
+        for(unsigned long i = 0; i < n; ++i) {
+            check_batch_item(e[i]);
+            top.append(e[i],t);
+        }
+        _size += n;
+        update_mintime();
+        return;
+    }
+    else
+        for(r = 0; r < nrungs; ++r)
+            if(time2bucket(rungs[r], t, b))
+                break;
+
+    if(r < nrungs) {
+        for(unsigned long i = 0; i < n; ++i) {
+            check_batch_item(e[i]);
+            rungs[r].buckets[b].append(e[i],t);
+        }
+    }
+    else {                  // before the lowest rung
+        bottom.insert_batch(e,n,t);
+        bottom_size += n;
+        if(bottom_size > bottom_limit && nrungs < LADDER_MAXRUNGS)
+            bottom2rung();
+    }
+    _size += n;
+    update_mintime();
+}
+
+////////////////////////////////////////////////////////////////////////////
+///  dequeue
+EventNotice * CalendarLadder::ExtractFirst()
+{
+    if(Empty())
+        SIMLIB_error(EmptyCalendar);
+    EventNotice * evn = bottom.extract_first();  // bottom is filled after every operation
+    --_size;
+    if(bottom_size > 0)
+        --bottom_size;
+    update_mintime();
+    return evn;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// remove entity e from calendar
+/// <br>called only if rescheduling
+Entity * CalendarLadder::Get(Entity * e)
+{
+    if(Empty())
+        SIMLIB_error(EmptyCalendar);  // internal use only --> TODO:remove
+    if(e->Idle())
+        SIMLIB_error(EntityIsNotScheduled);
+    bottom.remove(e);       // unlinks the record from any list
+    --_size;
+    update_mintime();
+    return e;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// keep bottom non-empty and mintime valid
+void CalendarLadder::update_mintime()
+{
+    if(Empty()) {
+        nrungs = 0;
+        bottom_size = 0;
+        SetMinTime(SIMLIB_MAXTIME);
+        return;
+    }
+    if(bottom.empty()) {
+        bottom_size = 0;
+        bottom_limit = LADDER_THRES;
+        refill();
+    }
+    SetMinTime(bottom.first_time());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// move the next items into empty bottom
+//
+void CalendarLadder::refill()
+{
+    for(;;) {
+        if(nrungs == 0) {
+            // new epoch: split top
+            unsigned count = 0;
+            double min = SIMLIB_MAXTIME, max = -SIMLIB_MAXTIME;
+            for(BucketList::iterator i = top.begin(); i != top.end(); ++i) {
+                double t = (*i)->time;
+                if(t < min) min = t;
+                if(t > max) max = t;
+                ++count;
+            }
+            if(count == 0)
+                SIMLIB_internal_error();  // size > 0 with no item left
+            topstart = max;
+            spawn(top, count, min, max);
+            if(!bottom.empty())
+                return;
+            continue;
+        }
+
+        // first non-empty bucket of the lowest rung
+        Rung &r = rungs[nrungs-1];
+        while(r.current < r.nbuckets && r.buckets[r.current].empty())
+            ++r.current;
+        if(r.current == r.nbuckets) { // rung exhausted
+            --nrungs;
+            continue;
+        }
+        BucketList &bp = r.buckets[r.current++];
+        unsigned count = 0;
+        double min = SIMLIB_MAXTIME, max = -SIMLIB_MAXTIME;
+        for(BucketList::iterator i = bp.begin(); i != bp.end(); ++i) {
+            double t = (*i)->time;
+            if(t < min) min = t;
+            if(t > max) max = t;
+            ++count;
+        }
+        spawn(bp, count, min, max);
+        if(!bottom.empty())
+            return;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// move items of a list into a new lowest rung, or sort them into bottom
+/// if they are few, all equal, or there is no free rung
+//
+void CalendarLadder::spawn(BucketList &from, unsigned count, double min, double max)
+{
+    double width = (max - min) / count;
+    if(count <= LADDER_THRES || nrungs == LADDER_MAXRUNGS || !(width > 0.0)
+       || width < 1e-12*std::fabs(min)) {
+        while(!from.empty())
+            bottom.insert_extracted(from.extract_first()); // stable
+        bottom_size += count;
+        return;
+    }
+
+    ++resizes;
+    Rung &r = rungs[nrungs++];
+    if(r.capacity < count) {
+        delete [] r.buckets;    // empty
+        r.buckets = new BucketList[count];
+        r.capacity = count;
+    }
+    r.nbuckets = count;
+    r.current = 0;
+    r.start = min;
+    r.width = width;
+    unsigned b = 0;
+    while(!from.empty()) {
+        EventNotice *en = from.extract_first(); // no change of e,t,p
+        time2bucket(r, en->time, b);
+        r.buckets[b].append_extracted(en);      // keeps FIFO
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// long bottom becomes the lowest rung
+void CalendarLadder::bottom2rung()
+{
+    if(bottom.empty())
+        return;
+    unsigned count = 0;
+    for(BucketList::iterator i = bottom.begin(); i != bottom.end(); ++i)
+        ++count;
+    double min = bottom.first_time();
+    double max = (*--bottom.end())->time;
+    // equal times can not be split, try again when bottom doubles
+    if(min == max || count <= LADDER_THRES) {
+        bottom_size = count;
+        bottom_limit = count > LADDER_THRES ? 2 * count : LADDER_THRES;
+        return;
+    }
+    BucketList all;
+    while(!bottom.empty())
+        all.append_extracted(bottom.extract_first());
+    bottom_size = 0;
+    unsigned old = nrungs;
+    spawn(all, count, min, max);
+    bottom_limit = nrungs > old ? LADDER_THRES : 2 * count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// clear ladder queue
+void CalendarLadder::clear(bool destroy)
+{
+    Dprintf(("CalendarLadder::clear(%s)",destroy?"true":"false"));
+    bottom.clear(destroy);
+    for(unsigned n = 0; n < nrungs; ++n)
+        for(unsigned b = rungs[n].current; b < rungs[n].nbuckets; ++b)
+            rungs[n].buckets[b].clear(destroy);
+    top.clear(destroy);
+    nrungs = 0;
+    bottom_size = 0;
+    bottom_limit = LADDER_THRES;
+    _size = 0;
+    SetMinTime(SIMLIB_MAXTIME);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Destroy ladder queue
+CalendarLadder::~CalendarLadder()
+{
+    Dprintf(("CalendarLadder::~CalendarLadder()"));
+    clear(true);
+    for(unsigned n = 0; n < LADDER_MAXRUNGS; ++n)
+        delete [] rungs[n].buckets;
+    allocator.clear(); // clear freelist
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////
+/// Implicit 4-ary heap implementation of calendar
+//
+//  heap: contiguous array of items (time, key, record), the parent of
+//        item i is (i-1)/4 and its children are 4*i+1 ... 4*i+4
+//  key:  inverted priority in the top 8 bits and the sequence number of
+//        scheduling in the rest, so comparing (time, key) of two items
+//        gives the order time/priority/FIFO of CalendarList
+//
+// Comparisons read the array only, activation records are touched just to
+// update their index when an item moves. The four children of an item are
+// adjacent, so a level of sift-down reads about two cache lines and the heap
+// has log4(n) levels. Every record keeps its position in the array, so Get(e)
+// finds the item through Entity::_evn and removes it in O(log n).
+//
+class CalendarHeap : public Calendar {
+    /// heap item
+    struct Item {
+        double time;                // activation time
+        unsigned long long key;     // priority and FIFO order
+        EventNotice *evn;           // activation record
+        bool operator<(const Item &b) const {
+            return time < b.time || (time == b.time && key < b.key);
+        }
+    };
+    static const unsigned long long SEQ_MASK = (1ULL << 56) - 1;
+
+    std::vector<Item> heap;
+    unsigned long long seq;         // sequence number of next scheduling
+
+  private:
+    /// store item at position i and update its record
+    void place(unsigned i, const Item &it) {
+        heap[i] = it;
+        it.evn->index = i;
+    }
+    void sift_up(unsigned i, Item it);
+    void sift_down(unsigned i, Item it);
+    void remove(unsigned i);
+
+  public:
+    /// enqueue
+    virtual void ScheduleAt(Entity *p, double t);
+    /// enqueue batch
+    virtual void ScheduleBatch(Entity *const *e, unsigned long n, double t);
+
+    /// dequeue
+    virtual Entity *Get(Entity *p);              // remove process p from calendar
+    /// dequeue first
+    virtual EventNotice *ExtractFirst();
+    /// remove all
+    virtual void clear(bool destroy=false); // remove/destroy all items
+
+    /// create calendar instance
+    static CalendarHeap * create() {    // create instance
+        Dprintf(("CalendarHeap::create()"));
+        CalendarHeap *h = new CalendarHeap;
+        SIMLIB_atexit(delete_instance);     // last SIMLIB module cleanup calls it
+        return h;
+    }
+
+    virtual const char* Name() { return "CalendarHeap"; }
+ private:
+    CalendarHeap();
+    ~CalendarHeap();
+
+public:
+#ifndef NDEBUG
+    virtual void debug_print(); // print of calendar contents - FOR DEBUGGING ONLY
+#endif
+}; // CalendarHeap
+
+/////////////////////////////////////////////////////////////////////////////
+/// Initialize heap
+CalendarHeap::CalendarHeap():
+    seq(0)
+{
+    Dprintf(("CalendarHeap::CalendarHeap()"));
+    SetMinTime( SIMLIB_MAXTIME ); // empty
+}
+
+/// move item up from position i (hole) to its place
+void CalendarHeap::sift_up(unsigned i, Item it)
+{
+    while(i > 0) {
+        unsigned parent = (i - 1) / 4;
+        if(!(it < heap[parent]))
+            break;
+        place(i, heap[parent]);
+        i = parent;
+    }
+    place(i, it);
+}
+
+/// move item down from position i (hole) to its place
+void CalendarHeap::sift_down(unsigned i, Item it)
+{
+    const unsigned n = heap.size();
+    for(;;) {
+        unsigned child = 4 * i + 1;
+        if(child >= n)
+            break;
+        unsigned last = child + 4 < n ? child + 4 : n;
+        unsigned min = child;
+        for(unsigned c = child + 1; c < last; ++c)
+            if(heap[c] < heap[min])
+                min = c;
+        if(!(heap[min] < it))
+            break;
+        place(i, heap[min]);
+        i = min;
+    }
+    place(i, it);
+}
+
+/// remove item at position i, the last item fills its place
+void CalendarHeap::remove(unsigned i)
+{
+    Item last = heap.back();
+    heap.pop_back();
+    if(i == heap.size())        // removed the last one
+        return;
+    if(i > 0 && last < heap[(i - 1) / 4])
+        sift_up(i, last);
+    else
+        sift_down(i, last);
+}
+
+/// schedule
+void CalendarHeap::ScheduleAt(Entity *e, double t)
+{
+    Dprintf(("CalendarHeap::ScheduleAt(%s,%g)", e->Name(), t));
+    if(t<Time)
+        SIMLIB_error(SchedulingBeforeTime);
+    EventNotice *evn = EventNotice::Create(e,t);
+    Item it;
+    it.time = t;
+    it.key = static_cast<unsigned long long>(127 - evn->priority) << 56 | (seq++ & SEQ_MASK);
+    it.evn = evn;
+    if(heap.size() == heap.capacity())
+        ++resizes;              // reallocation of the array
+    heap.push_back(it);
+    sift_up(heap.size() - 1, it);
+    ++_size;
+    SetMinTime(heap[0].time);
+}
+
+/// schedule batch: sift up of each item or heap rebuild for a large batch
+void CalendarHeap::ScheduleBatch(Entity *const *e, unsigned long n, double t)
+{
+    Dprintf(("CalendarHeap::ScheduleBatch(%lu,%g)", n, t));
+    if(t<Time)
+        SIMLIB_error(SchedulingBeforeTime);
+    const unsigned old = heap.size();
+    if(old + n > heap.capacity())
+        ++resizes;              // reallocation of the array
+    heap.reserve(old + n);
+    for(unsigned long i = 0; i < n; ++i) {
+        check_batch_item(e[i]);
+        EventNotice *evn = EventNotice::Create(e[i],t);
+        Item it;
+        it.time = t;
+        it.key = static_cast<unsigned long long>(127 - evn->priority) << 56 | (seq++ & SEQ_MASK);
+        it.evn = evn;
+        evn->index = heap.size();
+        heap.push_back(it);
+    }
+    _size += n;
+    if(n > old && heap.size() > 1) { // Floyd: sift down of all inner items
+        for(unsigned i = (heap.size() - 2) / 4 + 1; i-- > 0; )
+            sift_down(i, heap[i]);
+    }
+    else
+        for(unsigned i = old; i < heap.size(); ++i)
+            sift_up(i, heap[i]);
+    if(!Empty())
+        SetMinTime(heap[0].time);
+}
+
+////////////////////////////////////////////////////////////////////////////
+///  dequeue
+EventNotice * CalendarHeap::ExtractFirst()
+{
+    if(Empty())
+        SIMLIB_error(EmptyCalendar);
+    EventNotice *evn = heap[0].evn;
+    remove(0);
+    --_size;
+    SetMinTime(Empty() ? SIMLIB_MAXTIME : heap[0].time);
+    return evn;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// remove entity e from calendar
+/// <br>called only if rescheduling
+Entity * CalendarHeap::Get(Entity * e)
+{
+    if(Empty())
+        SIMLIB_error(EmptyCalendar);  // internal use only --> TODO:remove
+    if(e->Idle())
+        SIMLIB_error(EntityIsNotScheduled);
+    EventNotice *evn = e->GetEventNotice();
+    remove(evn->index);
+    --_size;
+    evn->delete_reverse_link();
+    EventNotice::Destroy(evn);
+    SetMinTime(Empty() ? SIMLIB_MAXTIME : heap[0].time);
+    return e;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// clear heap
+void CalendarHeap::clear(bool destroy)
+{
+    Dprintf(("CalendarHeap::clear(%s)",destroy?"true":"false"));
+    while(!heap.empty()) {
+        EventNotice *evn = heap.back().evn;
+        heap.pop_back();
+        Entity *e = evn->entity;
+        evn->delete_reverse_link();
+        EventNotice::Destroy(evn);
+        if (destroy && e->isAllocated()) delete e; // delete entity
+    }
+    _size = 0;
+    seq = 0;
+    SetMinTime(SIMLIB_MAXTIME);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Destroy heap
+CalendarHeap::~CalendarHeap()
+{
+    Dprintf(("CalendarHeap::~CalendarHeap()"));
+    clear(true);
+    allocator.clear(); // clear freelist
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
@@ -1143,6 +1995,17 @@ void CalendarListImplementation::debug_print() // print of list contents
       Print("  <empty>\n");
 }
 ////////////////////////////////////////////////////////////////////////////
+void CurrentBucket::debug_print() // print of current-time bucket contents
+{
+  if(empty())
+      return;
+  Print("CurrentBucket (at=%g):\n", time);
+  for(unsigned i=first; i<items.size(); i++)
+      if(items[i])
+          Print("  [%03u]:\t %s\n", i - first + 1, items[i]->entity->Name());
+  Print("\n");
+}
+////////////////////////////////////////////////////////////////////////////
 void CalendarList::debug_print() // print of calendar contents
 {
   Print("CalendarList:\n");
@@ -1163,6 +2026,39 @@ void CalendarQueue::debug_print() // print of calendar queue contents
   Print("\n");
 }
 ////////////////////////////////////////////////////////////////////////////
+void CalendarLadder::debug_print() // print of ladder queue contents
+{
+  Print("CalendarLadder:\n");
+  if(CalendarLadder::instance_exists()) {
+      Print(" bottom:\n");
+      bottom.debug_print();
+      for(unsigned n=0; n<nrungs; n++)
+          for(unsigned i=rungs[n].current; i<rungs[n].nbuckets; i++) {
+              Print(" rung#%u bucket#%03u:\n", n, i);
+              rungs[n].buckets[i].debug_print();
+          }
+      Print(" top (after %g):\n", topstart);
+      top.debug_print();
+  }
+  Print("\n");
+}
+////////////////////////////////////////////////////////////////////////////
+void CalendarHeap::debug_print() // print of heap contents (array order)
+{
+  Print("CalendarHeap:\n");
+  if(CalendarHeap::instance_exists()) {
+      for(unsigned i=0; i<heap.size(); i++) {
+          Print("  [%03u]:", i );                        // position
+          Print("\t %s", heap[i].evn->entity->Name() );  // print entity ID
+          Print("\t at=%g", heap[i].time );              // schedule time
+          Print("\n");
+      }
+      if(heap.empty())
+          Print("  <empty>\n");
+  }
+  Print("\n");
+}
+////////////////////////////////////////////////////////////////////////////
 /// CalendarQueue::visualize -- output suitable for Gnuplot
 void CalendarQueue::visualize(const char *msg)
 {
@@ -1213,6 +2109,7 @@ inline Calendar * Calendar::instance() {
 void Calendar::delete_instance() {
     Dprintf(("Calendar::delete_instance()"));
     if(_instance) {
+        _instance->current.clear(true);
         delete _instance;           // remove all, free
         _instance = 0;
     }
@@ -1256,6 +2153,10 @@ void SetCalendar(const char *name) {
         Calendar::_instance = CalendarList::create();
     else if(std::strcmp(name,"cq")==0)
         Calendar::_instance = CalendarQueue::create();
+    else if(std::strcmp(name,"ladder")==0)
+        Calendar::_instance = CalendarLadder::create();
+    else if(std::strcmp(name,"heap")==0)
+        Calendar::_instance = CalendarHeap::create();
     else
         SIMLIB_error("SetCalendar: bad argument");
 }
@@ -1275,7 +2176,19 @@ const char * cal_cost_op;
 
 /// empty calendar predicate
 bool SQS::Empty() {                       // used by Run() only
-  return Calendar::instance()->Empty();
+  Calendar *c = Calendar::instance();
+  return c->current.empty() && c->Empty();
+}
+
+namespace {
+/// activation time of first item: current-time bucket or calendar
+inline double next_time(Calendar *c) {
+  return c->current.empty() ? c->MinTime() : c->current.Time();
+}
+/// scheduling at time t goes into the current-time bucket
+inline bool to_current(Calendar *c, double t) {
+  return t == Time && c->current.accepts(t);
+}
 }
 
 /// schedule entity e at given time t using scheduling priority from e
@@ -1284,10 +2197,17 @@ bool SQS::Empty() {                       // used by Run() only
 void SQS::ScheduleAt(Entity *e, double t) { // used by scheduling operations
   if(!e->Idle())
       SIMLIB_error("ScheduleAt call if already scheduled");
+  Calendar *c = Calendar::instance();
 #ifdef MEASURE
   START_T();
 #endif
-  Calendar::instance()->ScheduleAt(e,t);
+  if(to_current(c, t)) {      // zero delay, no calendar search
+      if(t<Time)
+          SIMLIB_error(SchedulingBeforeTime);
+      c->current.insert(EventNotice::Create(e,t));
+  }
+  else
+      c->ScheduleAt(e,t);
 #ifdef MEASURE
   double ttt=STOP_T();
 //  Print("enqueue %d %g %d\n", Calendar::instance()->size(), ttt, OP_MEASURE);
@@ -1298,15 +2218,60 @@ cal_cost_op = "enqueue";
 OP_MEASURE=0;
 //  if(Calendar::instance()->size() < 300) Calendar::instance()->visualize("");
 #endif
-  _SetTime(NextTime, Calendar::instance()->MinTime());
+  _SetTime(NextTime, next_time(c));
+}
+
+namespace {
+/// scheduling priority order of batch
+bool higher_priority(const Entity *a, const Entity *b) {
+  return a->Priority > b->Priority;
+}
+}
+
+/// schedule n entities at time t (none of them scheduled) in one operation,
+/// the same order as ScheduleAt of each one: by priority, then FIFO
+/// @param e entities
+/// @param n number of entities
+/// @param t time of activation
+void SQS::ScheduleBatch(Entity *const *e, unsigned long n, double t) {
+  // sort by priority only if needed (usually all are equal)
+  std::vector<Entity *> sorted;
+  unsigned long i = 1;
+  while(i < n && e[i]->Priority <= e[i-1]->Priority)
+      ++i;
+  if(i < n) {
+      sorted.assign(e, e + n);
+      std::stable_sort(sorted.begin(), sorted.end(), higher_priority);
+      e = &sorted[0];
+  }
+  Calendar *c = Calendar::instance();
+  if(to_current(c, t)) {
+      if(t<Time)
+          SIMLIB_error(SchedulingBeforeTime);
+      for(i = 0; i < n; ++i) {
+          check_batch_item(e[i]);
+          c->current.insert(EventNotice::Create(e[i],t));
+      }
+  }
+  else
+      c->ScheduleBatch(e, n, t);
+  _SetTime(NextTime, next_time(c));
 }
 
 /// remove selected entity activation record from calendar
 void SQS::Get(Entity *e) {             // used by Run() only
+  Calendar *c = Calendar::instance();
 #ifdef MEASURE
   START_T();
 #endif
-  Calendar::instance()->Get(e);
+  EventNotice *evn = e->GetEventNotice();
+  if(evn && evn->current) {   // taken out of calendar already
+      c->current.remove(evn);
+      evn->delete_reverse_link();
+      EventNotice::Destroy(evn);
+  }
+  else
+      c->Get(e);
 #ifdef MEASURE
   double ttt=STOP_T();
 //  Print("dequeue2 %d %g %d\n", Calendar::instance()->size(), ttt, OP_MEASURE);
@@ -1316,16 +2281,23 @@ cal_cost_flag = OP_MEASURE;
 cal_cost_op = "delete";
 OP_MEASURE=0;
 #endif
-  _SetTime(NextTime, Calendar::instance()->MinTime());
+  _SetTime(NextTime, next_time(c));
 }
 
-/// remove entity with minimum activation time
+/// remove entity with minimum activation time,
+/// all items of its time are taken out of calendar at once
 /// @returns pointer to entity
 Entity *SQS::GetFirst() {                  // used by Run()
+  Calendar *c = Calendar::instance();
 #ifdef MEASURE
   START_T();
 #endif
-  Entity * ret = Calendar::instance()->GetFirst();
+  if(c->current.empty() && c->Empty())
+      SIMLIB_error(EmptyCalendar);
+  EventNotice *evn = c->current.next(c);
+  Entity * ret = evn->entity;
+  evn->delete_reverse_link();
+  EventNotice::Destroy(evn);
 #ifdef MEASURE
   double ttt=STOP_T();
 //  Print("dequeue %d %g %d\n", Calendar::instance()->size(), ttt, OP_MEASURE);
@@ -1335,19 +2307,28 @@ cal_cost_flag = OP_MEASURE;
 cal_cost_op = "dequeue";
 OP_MEASURE=0;
 #endif
-  _SetTime(NextTime, Calendar::instance()->MinTime());
+  _SetTime(NextTime, next_time(c));
   return ret;
 }
 
 /// remove all scheduled entities
 void SQS::Clear() {                       // remove all
-  Calendar::instance()->clear(true);
-  _SetTime(NextTime, Calendar::instance()->MinTime());
+  Calendar *c = Calendar::instance();
+  c->current.clear(true);
+  c->clear(true);
+  _SetTime(NextTime, c->MinTime());
+}
+
+/// number of reorganizations of the calendar structure (statistics)
+unsigned long CalendarResizes() {
+  return Calendar::instance()->Resizes();
 }
 
 int SQS::debug_print() {                 // for debugging only
-  Calendar::instance()->debug_print();
-  return Calendar::instance()->Size();
+  Calendar *c = Calendar::instance();
+  c->current.debug_print();
+  c->debug_print();
+  return c->current.size() + c->Size();
 }
 
 /// get activation time of entity - iff scheduled <br>
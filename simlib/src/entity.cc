@@ -62,6 +62,22 @@ void Entity::Activate(double t)
   SQS::ScheduleAt(this,t);
 }
 
+///  activation of entities at given time in one calendar operation
+void ActivateAll(Entity *const *entities, unsigned long n, double t)
+{
+  Dprintf(("ActivateAll(%lu entities, %g)", n, t));
+  for (unsigned long i = 0; i < n; i++)
+    if (entities[i] == SIMLIB_Current) { // Process::Activate of itself switches
+      for (unsigned long j = 0; j < n; j++)
+        entities[j]->Activate(t);
+      return;
+    }
+  for (unsigned long i = 0; i < n; i++)
+    if (!entities[i]->Idle())   // rescheduling
+      SQS::Get(entities[i]);    // remove from calendar
+  SQS::ScheduleBatch(entities, n, t);
+}
+
 
 ////////////////////////////////////////////////////////////////////////////
 //  Passivate - deactivation of process (entity)
@@ -216,6 +216,7 @@ extern double SIMLIB_EndTime;         // time of simulation end
 //! This is for internal use only.
 namespace SQS {
     void ScheduleAt(Entity *e, double t);// time t
+    void ScheduleBatch(Entity *const *e, unsigned long n, double t); // n at time t
     Entity *GetFirst();                  // remove first item
     void Get(Entity *e);                 // remove entity e
     bool Empty();                        // ?empty calendar
@@ -83,7 +83,8 @@ double Optimize_simann(double (*f) (const ParameterVector & p),
             opt = new_x;
             p = new_p;
 #if debug==1                    // optima only
-            Print("%g %g %.12g\n", p["d"].Value(), p["k"].Value(), opt);
+            p.PrintValues();
+            Print("%.12g\n", opt);
 #endif
         }
     }
@@ -47,6 +47,7 @@
 // includes
 #include <cstdlib>      // size_t
 #include <list>         // std::list<>
+#include <vector>       // std::vector<>
 
 // /////////////////////////////////////////////////////////////////////////
 //! \namespace simlib3  Main SIMLIB (version 3+) namespace.
@@ -179,9 +180,13 @@ inline void Init(double t0, double t1=SIMLIB_MAXTIME) {
 }
 
 //! Set calendar implementation.
-//! @param name String identification of calendar: "list", "cq"
+//! @param name String identification of calendar: "list", "cq", "ladder", "heap"
 void SetCalendar(const char *name);
 
+//! Number of reorganizations of the calendar (resize, new rung, ...).
+//! Statistics for benchmarks of calendar implementations.
+unsigned long CalendarResizes();
+
 //! Set integration step interval.
 //! @param dtmin  min. step size
 //! @param dtmax  max. step size (can be slightly increased)
@@ -422,6 +427,18 @@ class Entity : public Link {
 inline void Activate(Entity *e)  { e->Activate(); }   //!< activate entity e
 inline void Passivate(Entity *e) { e->Passivate(); }  //!< passivate entity e
 
+//! Activate n entities at time t, the same as Activate(t) of each one in
+//! the given order, but scheduled by one calendar operation (overriding
+//! Activate methods are not called). Every entity can be in the batch once.
+void ActivateAll(Entity *const *entities, unsigned long n, double t);
+//! Activate all entities of range [first,last) at time t (now by default)
+template <class Iterator>
+void ActivateAll(Iterator first, Iterator last, double t=Time) {
+  std::vector<Entity *> entities(first, last);
+  if(!entities.empty())
+      ActivateAll(&entities[0], entities.size(), t);
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //! Abstract base class for all simulation processes
 //! @ingroup process
@@ -2,24 +2,118 @@
 // SIMLIB/C++ -- basic calendar test
 //
 // simple check: increasing time ordering of event execution
+// all calendar implementations execute the same events in the same order
+// (also with equal times and priorities: time/priority/FIFO)
+// bursts of events activated by ActivateAll are in the same order as
+// activated one by one
+// every event executed is the first one of the expected order of all
+// scheduled events (zero delays, priorities and rescheduling included)
+// an event at SIMLIB_MAXTIME does not hide earlier events
 //
 #include "simlib.h"
 #include <cstdlib>
 #include <cmath>
+#include <map>
+#include <vector>
 
 long     N         = 1000;
 unsigned number    = 0;
 double   Last_Time = 0.0;
 
+// calendar implementations compared, the first one is the reference
+const int N_C = 4;
+const char *calendar[N_C] = { "list", "cq", "ladder", "heap" };
+
+std::vector<unsigned> order;    // event identifiers in order of execution
+unsigned created = 0;           // identifier of next event
+long     hold = 0;              // events to create during simulation
+bool     coarse = false;        // times in steps of 0.25, random priorities
+bool     burst = false;         // events create bursts of events at one time
+bool     batch = false;         // bursts activated by ActivateAll
+
+// expected order of execution: time, priority, order of activation
+struct Key {
+    double time;
+    int priority;               // negative, higher first
+    unsigned long stamp;        // activation number
+    bool operator<(const Key &b) const {
+        if (time != b.time) return time < b.time;
+        if (priority != b.priority) return priority < b.priority;
+        return stamp < b.stamp;
+    }
+};
+std::map<Key, unsigned> scheduled;  // scheduled events by expected order
+unsigned long stamp = 0;
+bool     misordered = false;
+
+double Interval();
+
 class TestEvent : public Event {
+  unsigned id;
+  Key key;
+  bool pending;
   void Behavior() {
       if (Time < Last_Time)
           Error("Bad calendar implementation %g < %g", Time, Last_Time);
       Last_Time = Time;
+      order.push_back(id);
+      if (scheduled.begin()->second != id)
+          misordered = true;
+      scheduled.erase(key);
+      pending = false;
+      // hold model: every event schedules a new one
+      if (burst && hold > 0) {
+          // up to 8 events, some of them created already
+          std::vector<TestEvent*> b(1 + static_cast<int>(8*Random()));
+          for (unsigned k = 0; k < b.size(); ++k) {
+              b[k] = new TestEvent;
+              if (k > 0 && Random() < 0.2)
+                  b[k]->activate(Time + Interval());
+          }
+          hold -= static_cast<long>(b.size());
+          double t = Time + Interval();
+          for (unsigned k = 0; k < b.size(); ++k)
+              b[k]->expect(t);
+          if (batch)
+              ActivateAll(b.begin(), b.end(), t);
+          else
+              for (unsigned k = 0; k < b.size(); ++k)
+                  b[k]->Activate(t);
+      }
+      else if (hold > 0) {
+          --hold;
+          (new TestEvent)->activate(Time + Interval());
+      }
   }
   public:
-  TestEvent() { ++number; }
+  TestEvent() : id(created++), pending(false) {
+      ++number;
+      if (coarse || burst)
+          Priority = Random() < 0.5 ? 0 : 1;
+  }
   ~TestEvent() { --number; }
+  /// record activation at time t in expected order
+  void expect(double t) {
+      if (pending)
+          scheduled.erase(key);
+      key.time = t;
+      key.priority = -Priority;
+      key.stamp = stamp++;
+      scheduled[key] = id;
+      pending = true;
+  }
+  void activate(double t) {
+      expect(t);
+      Activate(t);
+  }
+};
+
+// records its activation time
+class Mark : public Event {
+  double *when;
+  void Behavior() { *when = Time; }
+  public:
+  Mark(double *w) : when(w) {}
 };
 
 // various test distributions of time intervals
@@ -46,7 +140,7 @@ double DistributionTriangular() {
     return x;
 }
 
-// 
+//
 const int N_D = 5;
 double (*distribution[N_D])() = {
     DistributionUni,
@@ -56,7 +150,7 @@ double (*distribution[N_D])() = {
     DistributionTriangular,
 };
 
-// 
+//
 double MAX=0;
 int dd = 0;
 double Distribution() {
@@ -64,14 +158,15 @@ double Distribution() {
     if (x>MAX) MAX=x;
     return x;
 }
+double Interval() {
+    double x = Distribution();
+    return coarse || burst ? std::floor(4*x)/4 : x;
+}
 
 // experiment
 int main(int argc, char *argv[])
 {
     //DebugON();
-#if 1
-    SetCalendar("cq"); // calendar queue
-#endif
     if (argc > 1) {
         N = 0;
         N = std::strtoul(argv[1], 0, 10);
@@ -80,29 +175,78 @@ int main(int argc, char *argv[])
     }
     Print("Calendar size: %ld\n", N);
     int i = 0;
-    for(dd=0; dd < N_D; ++dd) try {
-        Init(0);          // Initialize time, calendar, ...
-        Last_Time=0.0;
-        MAX=0;
-        Print("Run#%d ", dd);
-        // create and activate N events 
-        // we need to:
-        //  - preallocate Events
-        //  - preallocate EventNotices
-        for (i = 0; i < N; i++) {
-            (new TestEvent)->Activate(Distribution());
+    int failures = 0;
+    for(dd=0; dd < N_D; ++dd)
+    for(int c=0; c < 3; ++c) {
+        coarse = c==1;
+        burst = c==2;
+        std::vector<unsigned> reference;
+        Print("Run#%d%s", dd, coarse?" coarse":burst?" burst":"");
+        // bursts: reference is list with Activate of each event
+        for(int k = burst ? -1 : 0; k < N_C; ++k) try {
+            batch = k >= 0;
+            SetCalendar(calendar[k < 0 ? 0 : k]);
+            Init(0);          // Initialize time, calendar, ...
+            RandomSeed(1234567);
+            Last_Time=0.0;
+            MAX=0;
+            order.clear();
+            scheduled.clear();
+            stamp = 0;
+            misordered = false;
+            created = 0;
+            hold = N;
+            // create and activate N events
+            // we need to:
+            //  - preallocate Events
+            //  - preallocate EventNotices
+            for (i = 0; i < N; i++) {
+                (new TestEvent)->activate(Interval());
+            }
+            // Calendar filled
+            //Print("max=%g\n", MAX);
+            // and now dequeue all, every event adds one until hold runs out
+            Run();                  // simulation
+            // delete events automatically by end of Behavior()
+            if (misordered) {
+                Print(" %s:FAILED", k < 0 ? "activate" : calendar[k]);
+                ++failures;
+                continue;
+            }
+            if (k < 0) {
+                reference = order;
+                continue;
+            }
+            if (k == 0 && !burst)
+                reference = order;
+            else if (order != reference) {
+                Print(" %s:FAILED", calendar[k]);
+                ++failures;
+                continue;
+            }
+            Print(" %s:OK", calendar[k]);
         }
-        // Calendar filled
-        //Print("max=%g\n", MAX);
-        // and now dequeue all
-        Run();                  // simulation
-        // delete events automatically by end of Behavior()
-        Print("OK\n");
-    }
-    catch(std::bad_alloc) {
-        Print("No memory after %d created events\n", i);
+        catch(std::bad_alloc) {
+            Print("No memory after %d created events\n", i);
+        }
+        catch(...) {
+            Print("Exception\n");
+        }
+        Print("\n");
     }
-    catch(...) {
-        Print("Exception\n");
+    Print("Maximum time");
+    for(int k = 0; k < N_C; ++k) {
+        SetCalendar(calendar[k]);
+        Init(0, 100);
+        double early = -1, late = -1;
+        (new Mark(&late))->Activate(SIMLIB_MAXTIME);
+        (new Mark(&early))->Activate(5);
+        Run();
+        bool ok = early == 5 && late == -1;
+        Print(" %s:%s", calendar[k], ok ? "OK" : "FAILED");
+        if (!ok)
+            ++failures;
     }
+    Print("\n");
+    return failures == 0 ? 0 : 1;
 }
@@ -0,0 +1,291 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Structure-of-arrays batch of SIR/SEIRD trajectories implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file BatchModel.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/BatchModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Separate multiply and add in every kernel, avx512f lets GCC fuse them into FMA
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_MODEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    // Widest vector is 8 doubles (AVX-512)
+    const size_t laneAlign = 8;
+
+    /**
+     * Portable kernel, every vector kernel performs exactly these operations
+     * in the same order so all kernels give bit-identical results
+     */
+    template<bool SIERD>
+    void stepScalar(const BatchModel::Arrays &a) {
+        for (size_t k = 0; k < a.count; k++) {
+            // Track max infected people and the biggest increment, as Model does
+            double roundI = floor(a.I[k] + 0.5);
+            if (roundI > a.maxInfected[k]) {
+                a.maxInfected[k] = roundI;
+                a.dayMaxInfected[k] = a.day;
+            }
+            double roundDerrI = floor(a.derrI[k] + 0.5);
+            if (roundDerrI > a.maxIncrement[k]) {
+                a.maxIncrement[k] = roundDerrI;
+                a.dayMaxIncrement[k] = a.day;
+            }
+
+            double S = a.S[k], E = a.E[k], I = a.I[k];
+            double newInfected = a.beta[k] * S * I / a.N;
+            bool clamp = newInfected > S;
+            double inflow = clamp ? S : newInfected;
+            double nextI;
+
+            a.S[k] = clamp ? 0.0 : S - newInfected;
+            a.sumInfected[k] += clamp ? 0.0 : newInfected;
+            if (SIERD) {
+                a.E[k] = E + (inflow - a.sigma[k] * E);
+                nextI = I + (a.sigma[k] * E - a.alpha[k] * I - a.omega[k] * I);
+                a.D[k] += a.omega[k] * I;
+            } else {
+                nextI = I + (inflow - a.alpha[k] * I);
+            }
+            a.R[k] += a.alpha[k] * I;
+            a.sumRecovered[k] += a.alpha[k] * I;
+            a.derrI[k] = nextI - I;
+            a.I[k] = nextI;
+        }
+    }
+
+#ifdef BATCH_MODEL_X86
+    template<bool SIERD>
+    __attribute__((target("avx2")))
+    void stepAVX2(const BatchModel::Arrays &a) {
+        const __m256d N = _mm256_set1_pd(a.N), half = _mm256_set1_pd(0.5), zero = _mm256_setzero_pd();
+        const __m256d day = _mm256_set1_pd(a.day);
+        for (size_t k = 0; k < a.count; k += 4) {
+            __m256d S = _mm256_loadu_pd(a.S + k), E = _mm256_loadu_pd(a.E + k), I = _mm256_loadu_pd(a.I + k);
+            __m256d alpha = _mm256_loadu_pd(a.alpha + k);
+
+            // Statistics
+            __m256d value = _mm256_floor_pd(_mm256_add_pd(I, half));
+            __m256d max = _mm256_loadu_pd(a.maxInfected + k);
+            __m256d greater = _mm256_cmp_pd(value, max, _CMP_GT_OQ);
+            _mm256_storeu_pd(a.maxInfected + k, _mm256_blendv_pd(max, value, greater));
+            _mm256_storeu_pd(a.dayMaxInfected + k, _mm256_blendv_pd(_mm256_loadu_pd(a.dayMaxInfected + k), day, greater));
+
+            value = _mm256_floor_pd(_mm256_add_pd(_mm256_loadu_pd(a.derrI + k), half));
+            max = _mm256_loadu_pd(a.maxIncrement + k);
+            greater = _mm256_cmp_pd(value, max, _CMP_GT_OQ);
+            _mm256_storeu_pd(a.maxIncrement + k, _mm256_blendv_pd(max, value, greater));
+            _mm256_storeu_pd(a.dayMaxIncrement + k, _mm256_blendv_pd(_mm256_loadu_pd(a.dayMaxIncrement + k), day, greater));
+
+            // Transmission, clamped to the susceptible left
+            __m256d newInfected = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(a.beta + k), S), I), N);
+            __m256d clamp = _mm256_cmp_pd(newInfected, S, _CMP_GT_OQ);
+            __m256d inflow = _mm256_blendv_pd(newInfected, S, clamp);
+            __m256d nextI;
+
+            _mm256_storeu_pd(a.S + k, _mm256_blendv_pd(_mm256_sub_pd(S, newInfected), zero, clamp));
+            _mm256_storeu_pd(a.sumInfected + k, _mm256_add_pd(_mm256_loadu_pd(a.sumInfected + k), _mm256_andnot_pd(clamp, newInfected)));
+            __m256d recovered = _mm256_mul_pd(alpha, I);
+            if (SIERD) {
+                __m256d sigmaE = _mm256_mul_pd(_mm256_loadu_pd(a.sigma + k), E);
+                __m256d dead = _mm256_mul_pd(_mm256_loadu_pd(a.omega + k), I);
+                _mm256_storeu_pd(a.E + k, _mm256_add_pd(E, _mm256_sub_pd(inflow, sigmaE)));
+                nextI = _mm256_add_pd(I, _mm256_sub_pd(_mm256_sub_pd(sigmaE, recovered), dead));
+                _mm256_storeu_pd(a.D + k, _mm256_add_pd(_mm256_loadu_pd(a.D + k), dead));
+            } else {
+                nextI = _mm256_add_pd(I, _mm256_sub_pd(inflow, recovered));
+            }
+            _mm256_storeu_pd(a.R + k, _mm256_add_pd(_mm256_loadu_pd(a.R + k), recovered));
+            _mm256_storeu_pd(a.sumRecovered + k, _mm256_add_pd(_mm256_loadu_pd(a.sumRecovered + k), recovered));
+            _mm256_storeu_pd(a.derrI + k, _mm256_sub_pd(nextI, I));
+            _mm256_storeu_pd(a.I + k, nextI);
+        }
+    }
+
+    template<bool SIERD>
+    __attribute__((target("avx512f")))
+    void stepAVX512(const BatchModel::Arrays &a) {
+        const __m512d N = _mm512_set1_pd(a.N), half = _mm512_set1_pd(0.5);
+        const __m512d day = _mm512_set1_pd(a.day);
+        const int roundDown = _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC;
+        const __mmask8 all = 0xFF/* maskz form avoids GCC's undefined source register warning */;
+        for (size_t k = 0; k < a.count; k += 8) {
+            __m512d S = _mm512_loadu_pd(a.S + k), E = _mm512_loadu_pd(a.E + k), I = _mm512_loadu_pd(a.I + k);
+            __m512d alpha = _mm512_loadu_pd(a.alpha + k);
+
+            // Statistics
+            __m512d value = _mm512_maskz_roundscale_pd(all, _mm512_add_pd(I, half), roundDown);
+            __mmask8 greater = _mm512_cmp_pd_mask(value, _mm512_loadu_pd(a.maxInfected + k), _CMP_GT_OQ);
+            _mm512_mask_storeu_pd(a.maxInfected + k, greater, value);
+            _mm512_mask_storeu_pd(a.dayMaxInfected + k, greater, day);
+
+            value = _mm512_maskz_roundscale_pd(all, _mm512_add_pd(_mm512_loadu_pd(a.derrI + k), half), roundDown);
+            greater = _mm512_cmp_pd_mask(value, _mm512_loadu_pd(a.maxIncrement + k), _CMP_GT_OQ);
+            _mm512_mask_storeu_pd(a.maxIncrement + k, greater, value);
+            _mm512_mask_storeu_pd(a.dayMaxIncrement + k, greater, day);
+
+            // Transmission, clamped to the susceptible left
+            __m512d newInfected = _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_loadu_pd(a.beta + k), S), I), N);
+            __mmask8 clamp = _mm512_cmp_pd_mask(newInfected, S, _CMP_GT_OQ);
+            __m512d inflow = _mm512_mask_blend_pd(clamp, newInfected, S);
+            __m512d nextI;
+
+            _mm512_storeu_pd(a.S + k, _mm512_maskz_sub_pd(_mm512_knot(clamp), S, newInfected));
+            _mm512_storeu_pd(a.sumInfected + k, _mm512_add_pd(_mm512_loadu_pd(a.sumInfected + k), _mm512_maskz_mov_pd(_mm512_knot(clamp), newInfected)));
+            __m512d recovered = _mm512_mul_pd(alpha, I);
+            if (SIERD) {
+                __m512d sigmaE = _mm512_mul_pd(_mm512_loadu_pd(a.sigma + k), E);
+                __m512d dead = _mm512_mul_pd(_mm512_loadu_pd(a.omega + k), I);
+                _mm512_storeu_pd(a.E + k, _mm512_add_pd(E, _mm512_sub_pd(inflow, sigmaE)));
+                nextI = _mm512_add_pd(I, _mm512_sub_pd(_mm512_sub_pd(sigmaE, recovered), dead));
+                _mm512_storeu_pd(a.D + k, _mm512_add_pd(_mm512_loadu_pd(a.D + k), dead));
+            } else {
+                nextI = _mm512_add_pd(I, _mm512_sub_pd(inflow, recovered));
+            }
+            _mm512_storeu_pd(a.R + k, _mm512_add_pd(_mm512_loadu_pd(a.R + k), recovered));
+            _mm512_storeu_pd(a.sumRecovered + k, _mm512_add_pd(_mm512_loadu_pd(a.sumRecovered + k), recovered));
+            _mm512_storeu_pd(a.derrI + k, _mm512_sub_pd(nextI, I));
+            _mm512_storeu_pd(a.I + k, nextI);
+        }
+    }
+#endif
+}
+
+BatchModel::BatchModel(size_t lanes, bool SIERD) : lanes(lanes), SIERD(SIERD) {
+    size_t padded = (lanes + laneAlign - 1) / laneAlign * laneAlign;
+
+    // Padding lanes stay empty, they compute zeros and never divide by zero
+    S.assign(padded, 0.0);
+    E.assign(padded, 0.0);
+    I.assign(padded, 0.0);
+    R.assign(padded, 0.0);
+    D.assign(padded, 0.0);
+    R0.assign(padded, 0.0);
+    beta.assign(padded, 0.0);
+    alpha.assign(padded, 0.0);
+    sigma.assign(padded, 0.0);
+    omega.assign(padded, 0.0);
+    derrI.assign(padded, 0.0);
+    sumInfected.assign(padded, 0.0);
+    sumRecovered.assign(padded, 0.0);
+    maxInfected.assign(padded, 0.0);
+    maxIncrement.assign(padded, 0.0);
+    dayMaxInfected.assign(padded, 0.0);
+    dayMaxIncrement.assign(padded, 0.0);
+
+    // Initial conditions of Model
+    for (size_t k = 0; k < lanes; k++) {
+        E[k] = 27 * 20.0;
+        I[k] = 27.0;
+        S[k] = N - I[k] - E[k];
+        sumInfected[k] = I[k];
+        setRates(k, 5.6015, 0.0556, 0.1923, 0.0034);
+    }
+
+#ifdef BATCH_MODEL_X86
+    if (!setKernel(AVX512)) {
+        setKernel(AVX2);
+    }
+#endif
+}
+
+void BatchModel::setRates(size_t lane, double R0, double alpha, double sigma, double omega) {
+    this->alpha[lane] = alpha;
+    this->sigma[lane] = sigma;
+    this->omega[lane] = omega;
+    setR0(lane, R0);
+}
+
+void BatchModel::setR0(size_t lane, double R0) {
+    this->R0[lane] = R0;
+    beta[lane] = alpha[lane] * R0;
+}
+
+void BatchModel::setTimeline(size_t lane, const Timeline &timeline) {
+    // Merge into the schedule of all lanes, ordered by day and stable within a day
+    for (const Timeline::Change &change : timeline.getChanges()) {
+        LaneChange laneChange = { change.day, lane, change.parameter, change.value };
+        auto position = upper_bound(schedule.begin() + pending, schedule.end(), laneChange,
+            [](const LaneChange &a, const LaneChange &b) { return a.day < b.day; });
+        schedule.insert(position, laneChange);
+    }
+}
+
+bool BatchModel::setKernel(Kernel kernel) {
+    switch (kernel) {
+        case SCALAR:
+            break;
+#ifdef BATCH_MODEL_X86
+        case AVX2:
+            if (!__builtin_cpu_supports("avx2")) { return false; }
+            break;
+        case AVX512:
+            if (!__builtin_cpu_supports("avx512f")) { return false; }
+            break;
+#endif
+        default:
+            return false;
+    }
+    this->kernel = kernel;
+    return true;
+}
+
+BatchModel::Arrays BatchModel::arrays() {
+    Arrays a;
+    a.count = S.size();
+    a.N = N;
+    a.day = (double)(day + 1);
+    a.S = S.data(); a.E = E.data(); a.I = I.data(); a.R = R.data(); a.D = D.data();
+    a.beta = beta.data(); a.alpha = alpha.data(); a.sigma = sigma.data(); a.omega = omega.data();
+    a.derrI = derrI.data(); a.sumInfected = sumInfected.data(); a.sumRecovered = sumRecovered.data();
+    a.maxInfected = maxInfected.data(); a.maxIncrement = maxIncrement.data();
+    a.dayMaxInfected = dayMaxInfected.data(); a.dayMaxIncrement = dayMaxIncrement.data();
+    return a;
+}
+
+void BatchModel::step() {
+    Arrays a = arrays();
+    switch (kernel) {
+#ifdef BATCH_MODEL_X86
+        case AVX512:
+            SIERD ? stepAVX512<true>(a) : stepAVX512<false>(a);
+            break;
+        case AVX2:
+            SIERD ? stepAVX2<true>(a) : stepAVX2<false>(a);
+            break;
+#endif
+        default:
+            SIERD ? stepScalar<true>(a) : stepScalar<false>(a);
+            break;
+    }
+    day++;
+}
+
+void BatchModel::simulate(unsigned long days) {
+    for (unsigned long i = 0; i < days; i++) {
+        // Interventions of this day, only these touch single lanes
+        while (pending < schedule.size() && schedule[pending].day <= day) {
+            const LaneChange &change = schedule[pending++];
+            const size_t lane = change.lane;
+            Timeline::apply(change, R0[lane], alpha[lane], sigma[lane], omega[lane], beta[lane]);
+        }
+        step();
+    }
+}
@@ -0,0 +1,388 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Fitting of Model rates to observed case data implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Calibration.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Calibration.h"
+#include "headers/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+
+using namespace std;
+using simlib3::Param;
+using simlib3::ParameterVector;
+
+namespace {
+    const char *const parameterNames[] = { "R0", "alpha", "sigma", "omega" };
+    const double missing = numeric_limits<double>::quiet_NaN();
+
+    // SIMLIB optimizers take a plain function, evaluations go through the running calibration;
+    // they also share the SIMLIB random generator, so only one of them runs at a time
+    mutex simlibLock;
+    const Calibration *active = nullptr;
+    size_t activeEvaluations = 0;
+
+    double activeLoss(const ParameterVector &values) {
+        activeEvaluations++;
+        return active->loss(values);
+    }
+
+    vector<string> splitCsv(const string &line) {
+        vector<string> cells;
+        stringstream stream(line);
+        string cell;
+        while (getline(stream, cell, ',')) {
+            cell.erase(0, cell.find_first_not_of(" \t\r"));
+            cell.erase(cell.find_last_not_of(" \t\r") + 1);
+            cells.push_back(cell);
+        }
+        return cells;
+    }
+}
+
+Calibration::Calibration(int experiment) : experiment(experiment) {}
+
+int Calibration::loadCases(const string &path) {
+    ifstream input(path);
+    if (!input) {
+        cerr << "Cannot open cases " << path << endl;
+        return 1;
+    }
+
+    string line;
+    if (!getline(input, line)) {
+        cerr << path << ": missing header" << endl;
+        return 1;
+    }
+    vector<string> header = splitCsv(line);
+    int dayColumn = -1, cumulativeColumn = -1, infectedColumn = -1;
+    for (size_t c = 0; c < header.size(); c++) {
+        if (header[c] == "date" || header[c] == "day") {
+            dayColumn = (int)c;
+        } else if (header[c] == "cumulative") {
+            cumulativeColumn = (int)c;
+        } else if (header[c] == "infected") {
+            infectedColumn = (int)c;
+        }
+    }
+    if (dayColumn < 0 || (cumulativeColumn < 0 && infectedColumn < 0)) {
+        cerr << path << ": header needs date or day and cumulative or infected" << endl;
+        return 1;
+    }
+
+    unsigned long number = 1;
+    while (getline(input, line)) {
+        number++;
+        vector<string> cells = splitCsv(line);
+        if (cells.empty() || (cells.size() == 1 && cells[0].empty())) {
+            continue;
+        }
+        cells.resize(header.size());
+
+        unsigned long day;
+        double values[2] = { missing, missing };
+        bool ok = Timeline::parseDay(cells[dayColumn], day);
+        const int columns[2] = { cumulativeColumn, infectedColumn };
+        for (int k = 0; k < 2 && ok; k++) {
+            if (columns[k] >= 0 && !cells[columns[k]].empty()) {
+                char *end = nullptr;
+                values[k] = strtod(cells[columns[k]].c_str(), &end);
+                ok = *end == '\0' && values[k] >= 0.0;
+            }
+        }
+        if (!ok) {
+            cerr << path << ":" << number << ": bad cases: " << line << endl;
+            return 1;
+        }
+        addObservation(day, values[0], values[1]);
+    }
+    return 0;
+}
+
+void Calibration::addObservation(unsigned long day, double cumulative, double infected) {
+    Observation observation = { day, cumulative, infected };
+    observations.push_back(observation);
+}
+
+int Calibration::loadParameters(const string &path) {
+    ifstream input(path);
+    if (!input) {
+        cerr << "Cannot open parameters " << path << endl;
+        return 1;
+    }
+
+    string line;
+    unsigned long number = 0;
+    while (getline(input, line)) {
+        number++;
+        stringstream tokens(line.substr(0, line.find('#')));
+        vector<string> words;
+        string word;
+        while (tokens >> word) {
+            words.push_back(word);
+        }
+        if (words.empty()) {
+            continue;
+        }
+
+        unsigned long day;
+        int parameter = -1;
+        double min = 0.0, max = 0.0, start = missing;
+        bool ok = (words.size() == 4 || words.size() == 5) && Timeline::parseDay(words[0], day);
+        for (int i = 0; ok && i < 4; i++) {
+            if (words[1] == parameterNames[i]) {
+                parameter = i;
+            }
+        }
+        char *end = nullptr;
+        ok = ok && parameter >= 0;
+        ok = ok && (min = strtod(words[2].c_str(), &end), *end == '\0');
+        ok = ok && (max = strtod(words[3].c_str(), &end), *end == '\0') && min < max;
+        if (ok && words.size() == 5) {
+            start = strtod(words[4].c_str(), &end);
+            ok = *end == '\0';
+        }
+        if (!ok) {
+            cerr << path << ":" << number << ": bad parameter: " << line << endl;
+            return 1;
+        }
+        addParameter(day, (Timeline::Parameter)parameter, min, max, start);
+    }
+    return 0;
+}
+
+void Calibration::addParameter(unsigned long day, Timeline::Parameter parameter, double min, double max, double start) {
+    Fitted item = { day, parameter, min, max, std::isnan(start) ? (min + max) / 2 : start };
+    fitted.push_back(item);
+
+    // Name shown by SIMLIB, e.g. R0@23
+    names.push_back(string(parameterNames[parameter]) + "@" + to_string(day));
+}
+
+void Calibration::addHubeiParameters() {
+    addParameter(0, Timeline::R0, 1.0, 10.0, 5.6015);
+    Timeline hubei = Timeline::hubei(experiment % 2 == 0);
+    for (const Timeline::Change &change : hubei.getChanges()) {
+        addParameter(change.day, change.parameter, 0.01, 10.0, change.value);
+    }
+}
+
+ParameterVector Calibration::getParameters() const {
+    vector<Param> items;
+    for (size_t i = 0; i < fitted.size(); i++) {
+        items.push_back(Param(names[i].c_str(), fitted[i].min, fitted[i].max));
+        items.back() = fitted[i].value;
+    }
+    return ParameterVector((int)items.size(), items.data());
+}
+
+Timeline Calibration::timeline(const ParameterVector &values) const {
+    // Interventions not fitted stay as in the experiment
+    Timeline result, hubei = Timeline::hubei(experiment % 2 == 0);
+    for (const Timeline::Change &change : hubei.getChanges()) {
+        bool replaced = false;
+        for (const Fitted &item : fitted) {
+            replaced = replaced || (item.day == change.day && item.parameter == change.parameter);
+        }
+        if (!replaced) {
+            result.add(change.day, change.parameter, change.value);
+        }
+    }
+    for (size_t i = 0; i < fitted.size(); i++) {
+        if (fitted[i].day > 0) {
+            result.add(fitted[i].day, fitted[i].parameter, values[(int)i].Value());
+        }
+    }
+    return result;
+}
+
+Model::Parameters Calibration::modelParameters(const ParameterVector &values) const {
+    // Initial rates of the experiment unless fitted
+    Model::Parameters parameters = Model::Parameters::experiment(experiment);
+    double *rates[4] = { &parameters.rates.R0, &parameters.rates.alpha, &parameters.rates.sigma, &parameters.rates.omega };
+    for (size_t i = 0; i < fitted.size(); i++) {
+        if (fitted[i].day == 0) {
+            *rates[fitted[i].parameter] = values[(int)i].Value();
+        }
+    }
+    parameters.rates.beta = parameters.rates.alpha * parameters.rates.R0;
+    parameters.timeline = timeline(values);
+    return parameters;
+}
+
+double Calibration::loss(const ParameterVector &values) const {
+    unsigned long days = 0;
+    for (const Observation &observation : observations) {
+        days = max(days, observation.day + 1);
+    }
+
+    // Rounded as in the data file of the experiment
+    Model model(modelParameters(values));
+    const int I = model.compartment("I");
+    vector<double> cumulative(days), infected(days);
+    for (unsigned long day = 0; day < days; day++) {
+        cumulative[day] = round(model.getStats().sumInfected);
+        infected[day] = round(model.getState()[I]);
+        model.step();
+    }
+
+    double sum = 0.0;
+    size_t count = 0;
+    for (const Observation &observation : observations) {
+        if (!std::isnan(observation.cumulative)) {
+            double error = log1p(cumulative[observation.day]) - log1p(observation.cumulative);
+            sum += error * error;
+            count++;
+        }
+        if (!std::isnan(observation.infected)) {
+            double error = log1p(infected[observation.day]) - log1p(observation.infected);
+            sum += error * error;
+            count++;
+        }
+    }
+    return count > 0 ? sum / count : 0.0;
+}
+
+double Calibration::fit(Method method, unsigned threads, int iterations) {
+    ParameterVector values = getParameters();
+    double best;
+    if (method == NELDER_MEAD) {
+        best = nelderMead(values, threads, iterations);
+    } else {
+        lock_guard<mutex> guard(simlibLock);
+        active = this;
+        activeEvaluations = 0;
+        best = method == HOOKE
+            ? simlib3::Optimize_hooke(activeLoss, values, 0.5, 1e-6, iterations)
+            : simlib3::Optimize_simann(activeLoss, values, iterations);
+        evaluations += activeEvaluations;
+        active = nullptr;
+    }
+
+    for (size_t i = 0; i < fitted.size(); i++) {
+        fitted[i].value = values[(int)i].Value();
+    }
+    return best;
+}
+
+double Calibration::nelderMead(ParameterVector &values, unsigned threads, int iterations) {
+    const size_t n = fitted.size();
+    ThreadPool pool(threads);
+    ParameterVector start = values;
+
+    // Points are clamped to the bounds by Param before they are evaluated
+    auto evaluate = [&](vector<vector<double>> &points, vector<double> &losses, const vector<size_t> &which) {
+        pool.parallelFor(which.size(), [&](size_t k) {
+            ParameterVector point = start;
+            vector<double> &x = points[which[k]];
+            for (size_t i = 0; i < n; i++) {
+                point[(int)i] = x[i];
+                x[i] = point[(int)i].Value();
+            }
+            losses[which[k]] = loss(point);
+        }, 1);
+        evaluations += which.size();
+    };
+
+    // Initial simplex, a tenth of the range along every axis
+    vector<vector<double>> simplex(n + 1, vector<double>(n));
+    vector<double> losses(n + 1);
+    for (size_t v = 0; v <= n; v++) {
+        for (size_t i = 0; i < n; i++) {
+            simplex[v][i] = values[(int)i].Value();
+        }
+        if (v > 0) {
+            double step = values[(int)(v - 1)].Range() / 10;
+            double &x = simplex[v][v - 1];
+            x = x + step <= values[(int)(v - 1)].Max() ? x + step : x - step;
+        }
+    }
+    vector<size_t> all(n + 1);
+    iota(all.begin(), all.end(), 0);
+    evaluate(simplex, losses, all);
+
+    vector<vector<double>> trials(4, vector<double>(n));
+    vector<double> trialLosses(4);
+    const vector<size_t> allTrials = { 0, 1, 2, 3 };
+    const double coefficients[4] = { 1.0, 2.0, 0.5, -0.5 }/* Reflection, expansion, outside, inside contraction */;
+
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        vector<size_t> order(n + 1);
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) { return losses[a] < losses[b]; });
+        size_t best = order[0], worst = order[n], second = order[n - (n > 0 ? 1 : 0)];
+
+        // Converged when all vertices are within a millionth of the ranges
+        double size = 0.0;
+        for (size_t v = 0; v <= n; v++) {
+            for (size_t i = 0; i < n; i++) {
+                size = max(size, fabs(simplex[v][i] - simplex[best][i]) / values[(int)i].Range());
+            }
+        }
+        if (size < 1e-6) {
+            break;
+        }
+
+        // All trial points along the line through the worst vertex at once
+        vector<double> centroid(n, 0.0);
+        for (size_t v = 0; v <= n; v++) {
+            if (v != worst) {
+                for (size_t i = 0; i < n; i++) {
+                    centroid[i] += simplex[v][i] / n;
+                }
+            }
+        }
+        for (size_t t = 0; t < 4; t++) {
+            for (size_t i = 0; i < n; i++) {
+                trials[t][i] = centroid[i] + coefficients[t] * (centroid[i] - simplex[worst][i]);
+            }
+        }
+        evaluate(trials, trialLosses, allTrials);
+
+        int accepted = -1;
+        if (trialLosses[0] < losses[best]) {
+            accepted = trialLosses[1] < trialLosses[0] ? 1 : 0;
+        } else if (trialLosses[0] < losses[second]) {
+            accepted = 0;
+        } else if (trialLosses[0] < losses[worst]) {
+            accepted = trialLosses[2] <= trialLosses[0] ? 2 : -1;
+        } else {
+            accepted = trialLosses[3] < losses[worst] ? 3 : -1;
+        }
+
+        if (accepted >= 0) {
+            simplex[worst] = trials[accepted];
+            losses[worst] = trialLosses[accepted];
+        } else {
+            // Shrink towards the best vertex
+            vector<size_t> moved;
+            for (size_t v = 0; v <= n; v++) {
+                if (v != best) {
+                    for (size_t i = 0; i < n; i++) {
+                        simplex[v][i] = simplex[best][i] + 0.5 * (simplex[v][i] - simplex[best][i]);
+                    }
+                    moved.push_back(v);
+                }
+            }
+            evaluate(simplex, losses, moved);
+        }
+    }
+
+    size_t best = min_element(losses.begin(), losses.end()) - losses.begin();
+    for (size_t i = 0; i < n; i++) {
+        values[(int)i] = simplex[best][i];
+    }
+    return losses[best];
+}
@@ -0,0 +1,252 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Compartment graph engine implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Compartments.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Compartments.h"
+#include "headers/Dual.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+    int find(const vector<string> &names, const string &name) {
+        for (size_t i = 0; i < names.size(); i++) {
+            if (names[i] == name) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+    bool parseNumber(const string &text, long double &value) {
+        char *end = nullptr;
+        value = strtold(text.c_str(), &end);
+        return !text.empty() && *end == '\0';
+    }
+}
+
+template<typename T>
+CompartmentModel<T>::CompartmentModel(T N) : N(N), state(1, T(1)) {}
+
+template<typename T>
+int CompartmentModel<T>::addCompartment(const string &name, T initial) {
+    // Keep the constant one slot last
+    names.push_back(name);
+    state.insert(state.end() - 1, initial);
+    compiled = false;
+    return (int)names.size() - 1;
+}
+
+template<typename T>
+int CompartmentModel<T>::addParameter(const string &name, T value) {
+    parameterNames.push_back(name);
+    parameters.push_back(value);
+    return (int)parameters.size() - 1;
+}
+
+template<typename T>
+int CompartmentModel<T>::addFlow(const string &from, const string &to, const string &parameter, const string &contact) {
+    Flow flow;
+    flow.from = compartment(from);
+    flow.to = compartment(to);
+    flow.parameter = this->parameter(parameter);
+    flow.contact = contact.empty() ? -1 : compartment(contact);
+    if (flow.from < 0 || flow.to < 0 || flow.parameter < 0 || (!contact.empty() && flow.contact < 0)) {
+        return -1;
+    }
+    flows.push_back(flow);
+    cumulative.push_back(T(0));
+    compiled = false;
+    return (int)flows.size() - 1;
+}
+
+template<typename T>
+int CompartmentModel<T>::compartment(const string &name) const {
+    return find(names, name);
+}
+
+template<typename T>
+int CompartmentModel<T>::parameter(const string &name) const {
+    return find(parameterNames, name);
+}
+
+template<typename T>
+int CompartmentModel<T>::flow(const string &from, const string &to) const {
+    int source = compartment(from), target = compartment(to);
+    for (size_t i = 0; i < flows.size(); i++) {
+        if (flows[i].from == source && flows[i].to == target) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+template<typename T>
+void CompartmentModel<T>::compile() {
+    size_t count = flows.size();
+    int one = (int)names.size();
+
+    from.resize(count);
+    to.resize(count);
+    rate.resize(count);
+    factor.resize(count);
+    divisor.resize(count);
+    flux.resize(count);
+    delta.assign(names.size(), T(0));
+
+    // Linear flows use the constant one slot as contact and divide by one
+    for (size_t i = 0; i < count; i++) {
+        from[i] = flows[i].from;
+        to[i] = flows[i].to;
+        rate[i] = flows[i].parameter;
+        factor[i] = flows[i].contact < 0 ? one : flows[i].contact;
+        divisor[i] = flows[i].contact < 0 ? T(1) : N;
+    }
+    compiled = true;
+}
+
+template<typename T>
+void CompartmentModel<T>::step() {
+    if (!compiled) {
+        compile();
+    }
+    const size_t count = flows.size();
+    const size_t size = names.size();
+    T *x = state.data();
+
+    // Fluxes from the current state, never more than the source holds
+    for (size_t i = 0; i < count; i++) {
+        T value = parameters[rate[i]] * x[from[i]] * x[factor[i]] / divisor[i];
+        flux[i] = min(value, x[from[i]]);
+    }
+
+    // Changes in declaration order
+    fill(delta.begin(), delta.end(), T(0));
+    for (size_t i = 0; i < count; i++) {
+        delta[from[i]] -= flux[i];
+        delta[to[i]] += flux[i];
+        cumulative[i] += flux[i];
+    }
+    for (size_t c = 0; c < size; c++) {
+        x[c] += delta[c];
+    }
+}
+
+template<typename T>
+int CompartmentModel<T>::load(const string &path) {
+    ifstream input(path);
+    if (!input) {
+        cerr << "Cannot open model " << path << endl;
+        return 1;
+    }
+
+    int restCompartment = -1;
+    string line;
+    unsigned long number = 0;
+    while (getline(input, line)) {
+        number++;
+        stringstream tokens(line.substr(0, line.find('#')));
+        vector<string> words;
+        string word;
+        while (tokens >> word) {
+            words.push_back(word);
+        }
+        if (words.empty()) {
+            continue;
+        }
+
+        long double value = 0;
+        bool ok = false;
+        if (words[0] == "population" && words.size() == 2) {
+            ok = parseNumber(words[1], value);
+            N = value;
+        } else if (words[0] == "compartment" && words.size() == 3 && compartment(words[1]) < 0) {
+            if (words[2] == "rest" && restCompartment < 0) {
+                restCompartment = addCompartment(words[1], T(0));
+                ok = true;
+            } else if (parseNumber(words[2], value)) {
+                addCompartment(words[1], value);
+                ok = true;
+            }
+        } else if (words[0] == "parameter" && words.size() == 3 && parameter(words[1]) < 0) {
+            ok = parseNumber(words[2], value);
+            addParameter(words[1], value);
+        } else if (words[0] == "flow" && words.size() >= 8 && words[2] == "->" && words[4] == ":" && words[6] == "*"
+                   && words[7] == words[1]) {
+            // <parameter> * <from> or <parameter> * <from> * <contact> / N
+            if (words.size() == 8) {
+                ok = addFlow(words[1], words[3], words[5]) >= 0;
+            } else if (words.size() == 12 && words[8] == "*" && words[10] == "/" && words[11] == "N") {
+                ok = addFlow(words[1], words[3], words[5], words[9]) >= 0;
+            }
+        }
+        if (!ok) {
+            cerr << path << ":" << number << ": bad declaration: " << line << endl;
+            return 1;
+        }
+    }
+
+    // The rest of the population goes to the marked compartment
+    if (restCompartment >= 0) {
+        T rest = N;
+        for (size_t c = 0; c < names.size(); c++) {
+            if ((int)c != restCompartment) {
+                rest -= state[c];
+            }
+        }
+        state[restCompartment] = rest;
+    }
+    return 0;
+}
+
+template<typename T>
+CompartmentModel<T> CompartmentModel<T>::sir(T N, T infected, T exposed) {
+    CompartmentModel<T> model(N);
+
+    // Exposed people are not modelled but still missing from the susceptible
+    model.addCompartment("S", N - infected - exposed);
+    model.addCompartment("I", infected);
+    model.addCompartment("R", T(0));
+    model.addParameter("beta", T(0));
+    model.addParameter("alpha", T(0));
+    model.addParameter("sigma", T(0));
+    model.addParameter("omega", T(0));
+    model.addFlow("S", "I", "beta", "I");
+    model.addFlow("I", "R", "alpha");
+    return model;
+}
+
+template<typename T>
+CompartmentModel<T> CompartmentModel<T>::seird(T N, T infected, T exposed) {
+    CompartmentModel<T> model(N);
+    model.addCompartment("S", N - infected - exposed);
+    model.addCompartment("E", exposed);
+    model.addCompartment("I", infected);
+    model.addCompartment("R", T(0));
+    model.addCompartment("D", T(0));
+    model.addParameter("beta", T(0));
+    model.addParameter("alpha", T(0));
+    model.addParameter("sigma", T(0));
+    model.addParameter("omega", T(0));
+    model.addFlow("S", "E", "beta", "I");
+    model.addFlow("E", "I", "sigma");
+    model.addFlow("I", "R", "alpha");
+    model.addFlow("I", "D", "omega");
+    return model;
+}
+
+// Supported precisions and the derivatives by four rates
+template class CompartmentModel<float>;
+template class CompartmentModel<double>;
+template class CompartmentModel<long double>;
+template class CompartmentModel<Dual<4>>;
@@ -0,0 +1,257 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Continuous-time SIR/SEIRD model on SIMLIB integrators implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Continuous.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Continuous.h"
+
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+#include "simlib.h"
+
+using namespace std;
+
+namespace {
+    const char *const methodNames[] = { "rkf5", "rkf8", "euler" };
+
+    // SIMLIB runs one simulation at a time
+    mutex simulator;
+
+    // Blocks of one simulation, the rates change at interventions
+    struct Equations {
+        Variable beta, alpha, sigma, omega;
+        Integrator S, E, I, R, D, Isum, Rsum;
+
+        Equations(bool SIERD, double N) {
+            Input infection = beta * S * I / N;
+            S.SetInput(-infection);
+            if (SIERD) {
+                E.SetInput(infection - sigma * E);
+                I.SetInput(sigma * E - (alpha + omega) * I);
+                D.SetInput(omega * I);
+            } else {
+                I.SetInput(infection - alpha * I);
+            }
+            R.SetInput(alpha * I);
+            Isum.SetInput(infection);
+            Rsum.SetInput(alpha * I);
+        }
+
+        void setRates(const Model::Rates &rates) {
+            beta = rates.beta;
+            alpha = rates.alpha;
+            sigma = rates.sigma;
+            omega = rates.omega;
+        }
+    };
+
+    // Work of the daily Sampler, which takes a plain function
+    struct Daily {
+        Equations &equations;
+        const vector<Timeline::Change> &changes;
+        size_t &pending;
+        Model::Rates &rates;
+        Model::Stats &stats;
+        double &previousI;
+        vector<Integrator *> columns;
+        vector<double> row;
+        TrajectorySink *sink = nullptr;
+        unsigned long until = 0;
+
+        Daily(Equations &equations, const vector<Timeline::Change> &changes, size_t &pending,
+              Model::Rates &rates, Model::Stats &stats, double &previousI)
+            : equations(equations), changes(changes), pending(pending), rates(rates), stats(stats), previousI(previousI) {}
+
+        void sample() {
+            unsigned long day = (unsigned long)llround(Time);
+            if (day >= until) {
+                return;
+            }
+
+            // Interventions of this day, changes are sorted by day
+            bool changed = false;
+            while (pending < changes.size() && changes[pending].day <= day) {
+                const Timeline::Change &change = changes[pending++];
+                Timeline::apply(change, rates);
+                changed = true;
+            }
+            if (changed) {
+                equations.setRates(rates);
+            }
+
+            // Statistics of Model
+            double infected = equations.I.Value();
+            if (round(infected) > stats.maxInfected) {
+                stats.maxInfected = round(infected);
+                stats.dayMaxInfected = day + 1ul;
+            }
+            if (round(infected - previousI) > stats.maxIncrement) {
+                stats.maxIncrement = round(infected - previousI);
+                stats.dayMaxIncrement = day + 1ul;
+            }
+            previousI = infected;
+
+            if (sink) {
+                for (size_t c = 0; c < columns.size(); c++) {
+                    row[c] = columns[c]->Value();
+                }
+                sink->write(row.data());
+            }
+        }
+    };
+
+    Daily *active = nullptr;
+
+    void sampleActive() {
+        active->sample();
+    }
+}
+
+ContinuousModel::ContinuousModel(const Model::Parameters &parameters) : parameters(parameters) {
+    names = parameters.SIERD ? vector<string>{ "S", "E", "I", "R", "D" } : vector<string>{ "S", "I", "R" };
+    reset();
+}
+
+void ContinuousModel::setAccuracy(double relative, double absolute) {
+    this->relative = relative;
+    this->absolute = absolute;
+}
+
+void ContinuousModel::setStep(double min, double max) {
+    minStep = min;
+    maxStep = max;
+}
+
+void ContinuousModel::reset() {
+    // Susceptible = Population - Infected - Exposed, as in Model
+    state.assign(names.size(), 0.0);
+    state[0] = parameters.N - parameters.I - parameters.E;
+    if (parameters.SIERD) {
+        state[1] = parameters.E;
+        state[2] = parameters.I;
+    } else {
+        state[1] = parameters.I;
+    }
+    rates = parameters.rates;
+    pending = 0;
+    today = 0;
+    previousI = parameters.I;
+    stats = Model::Stats();
+    stats.sumInfected = parameters.I;
+    steps = 0;
+}
+
+int ContinuousModel::advance(unsigned long day, TrajectorySink *sink) {
+    lock_guard<mutex> lock(simulator);
+
+    Equations equations(parameters.SIERD, parameters.N);
+    Daily daily(equations, parameters.timeline.getChanges(), pending, rates, stats, previousI);
+    Integrator *all[] = { &equations.S, &equations.E, &equations.I, &equations.R, &equations.D };
+    for (const string &name : names) {
+        daily.columns.push_back(all[string("SEIRD").find(name)]);
+    }
+    daily.columns.push_back(&equations.Isum);
+    daily.columns.push_back(&equations.Rsum);
+    daily.row.resize(daily.columns.size());
+    daily.sink = sink;
+    daily.until = day;
+
+    if (sink) {
+        vector<string> columns = names;
+        columns.push_back("Isum");
+        columns.push_back("Rsum");
+        if (sink->open(columns) != 0) {
+            return 1;
+        }
+    }
+    if (day <= today) {
+        return sink ? sink->close() : 0;
+    }
+
+    Sampler sampler(sampleActive, 1.0);
+    active = &daily;
+    SetMethod(methodNames[method]);
+    Init((double)today, (double)day);
+    for (size_t c = 0; c < names.size(); c++) {
+        daily.columns[c]->Init(state[c]);
+    }
+    equations.Isum.Init(stats.sumInfected);
+    equations.Rsum.Init(stats.sumRecovered);
+    equations.setRates(rates);
+    SetStep(minStep, maxStep);
+    if (method == EULER) {
+        // Fixed step, the error estimate of SIMLIB euler would only warn at the minimal step
+        SetAccuracy(numeric_limits<double>::max(), 1.0);
+    } else {
+        SetAccuracy(absolute, relative);
+    }
+    Run();
+    active = nullptr;
+    steps += SIMLIB_statistics.StepCount;
+
+    for (size_t c = 0; c < names.size(); c++) {
+        state[c] = daily.columns[c]->Value();
+    }
+    stats.sumInfected = equations.Isum.Value();
+    stats.sumRecovered = equations.Rsum.Value();
+    today = day;
+    return sink ? sink->close() : 0;
+}
+
+int ContinuousModel::simulate(unsigned long days, TrajectorySink *sink) {
+    reset();
+    return advance(days, sink);
+}
+
+void ContinuousModel::save(Snapshot &snapshot) const {
+    snapshot.tag("continuous");
+    snapshot.put((uint32_t)state.size());
+    snapshot.put(state.data(), state.size());
+    const double values[] = { rates.R0, rates.alpha, rates.beta, rates.sigma, rates.omega, previousI,
+                              stats.maxInfected, stats.maxIncrement, stats.sumInfected, stats.sumRecovered };
+    snapshot.put(values, 10);
+    const uint64_t days[] = { stats.dayMaxInfected, stats.dayMaxIncrement, today };
+    snapshot.put(days, 3);
+}
+
+int ContinuousModel::restore(Snapshot &snapshot) {
+    uint32_t compartments = 0;
+    if (!snapshot.expect("continuous") || !snapshot.get(compartments) || compartments != state.size()) {
+        return 1;
+    }
+    vector<double> restored(compartments);
+    double values[10];
+    uint64_t days[3];
+    if (!snapshot.get(restored.data(), compartments) || !snapshot.get(values, 10) || !snapshot.get(days, 3)) {
+        return 1;
+    }
+
+    state = restored;
+    rates.R0 = values[0];
+    rates.alpha = values[1];
+    rates.beta = values[2];
+    rates.sigma = values[3];
+    rates.omega = values[4];
+    previousI = values[5];
+    stats.maxInfected = values[6];
+    stats.maxIncrement = values[7];
+    stats.sumInfected = values[8];
+    stats.sumRecovered = values[9];
+    stats.dayMaxInfected = days[0];
+    stats.dayMaxIncrement = days[1];
+    today = days[2];
+
+    // Changes of the simulated days are in the rates already
+    const vector<Timeline::Change> &changes = parameters.timeline.getChanges();
+    pending = 0;
+    while (pending < changes.size() && changes[pending].day < today) {
+        pending++;
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Stochastic SIR/SEIRD ensemble implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Ensemble.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Ensemble.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using namespace std;
+
+namespace {
+    // Replicates per task
+    const size_t replicateBlock = 64;
+
+    // Quantiles written for every compartment
+    const double quantiles[] = { 0.05, 0.5, 0.95 };
+    const char *const quantileNames[] = { "_q05", "_q50", "_q95" };
+
+    size_t quantileRank(size_t count, double q) {
+        return (size_t)floor(q * (count - 1) + 0.5);
+    }
+}
+
+Ensemble::Ensemble(size_t replicates, bool SIERD)
+    : replicates(replicates), SIERD(SIERD) {
+    setSeed(0);
+}
+
+void Ensemble::setRates(double R0, double alpha, double sigma, double omega) {
+    this->R0 = R0;
+    this->alpha = alpha;
+    this->beta = alpha * R0;
+    this->sigma = sigma;
+    this->omega = omega;
+}
+
+void Ensemble::setTimeline(const Timeline &timeline) {
+    this->timeline = timeline;
+    pending = 0;
+}
+
+void Ensemble::setSeed(uint64_t seed) {
+    this->seed = seed;
+    day = 0;
+    pending = 0;
+
+    // Susceptible = Population - Infected - Exposed, as in Model
+    S.assign(replicates, N - initialI - initialE);
+    E.assign(replicates, SIERD ? initialE : 0);
+    I.assign(replicates, initialI);
+    R.assign(replicates, 0);
+    D.assign(replicates, 0);
+    sumInfected.assign(replicates, initialI);
+    streams.clear();
+    for (size_t k = 0; k < replicates; k++) {
+        streams.push_back(RandomStream(seed, k));
+    }
+}
+
+void Ensemble::setThreads(unsigned threads) {
+    this->threads = threads;
+    pool.reset();
+}
+
+void Ensemble::setSink(unique_ptr<TrajectorySink> sink) {
+    this->sink = move(sink);
+}
+
+void Ensemble::stepReplicates(size_t begin, size_t end) {
+    // Daily probabilities of leaving a compartment, constant within a day
+    const double leaveE = -expm1(-sigma);
+    const double leaveI = -expm1(-(alpha + (SIERD ? omega : 0.0)));
+    const double deadShare = SIERD ? omega / (alpha + omega) : 0.0;
+
+    for (size_t k = begin; k < end; k++) {
+        RandomStream &random = streams[k];
+        uint64_t s = S[k], e = E[k], infected = I[k];
+        uint64_t newInfected, incubated = 0, recovered, dead = 0;
+
+        if (method == CHAIN_BINOMIAL) {
+            newInfected = binomial(random, s, -expm1(-beta * infected / N));
+            if (SIERD) {
+                incubated = binomial(random, e, leaveE);
+            }
+            uint64_t leaving = binomial(random, infected, leaveI);
+            dead = binomial(random, leaving, deadShare);
+            recovered = leaving - dead;
+        } else {
+            newInfected = min(s, poisson(random, beta * s * infected / N));
+            if (SIERD) {
+                incubated = min(e, poisson(random, sigma * e));
+                dead = min(infected, poisson(random, omega * infected));
+            }
+            recovered = min(infected - dead, poisson(random, alpha * infected));
+        }
+
+        S[k] = s - newInfected;
+        if (SIERD) {
+            E[k] = e + newInfected - incubated;
+            I[k] = infected + incubated - recovered - dead;
+            D[k] += dead;
+        } else {
+            I[k] = infected + newInfected - recovered;
+        }
+        R[k] += recovered;
+        sumInfected[k] += newInfected;
+    }
+}
+
+void Ensemble::step() {
+    size_t blocks = (replicates + replicateBlock - 1) / replicateBlock;
+    if (threads == 1 || blocks <= 1) {
+        stepReplicates(0, replicates);
+    } else {
+        if (!pool) {
+            pool.reset(new ThreadPool(threads));
+        }
+        pool->parallelFor(blocks, [this](size_t block) {
+            stepReplicates(block * replicateBlock, min(replicates, (block + 1) * replicateBlock));
+        }, 1);
+    }
+    day++;
+}
+
+double Ensemble::quantile(const uint64_t *values, double q) {
+    scratch.assign(values, values + replicates);
+    auto nth = scratch.begin() + quantileRank(replicates, q);
+    nth_element(scratch.begin(), nth, scratch.end());
+    return *nth;
+}
+
+void Ensemble::writeQuantiles() {
+    vector<const uint64_t *> columns = { S.data() };
+    if (SIERD) {
+        columns.push_back(E.data());
+    }
+    columns.push_back(I.data());
+    columns.push_back(R.data());
+    if (SIERD) {
+        columns.push_back(D.data());
+    }
+    columns.push_back(sumInfected.data());
+
+    row.clear();
+    for (const uint64_t *values : columns) {
+        // Ranks ascend, so each selection only partitions the part above the previous one
+        scratch.assign(values, values + replicates);
+        auto from = scratch.begin();
+        for (double q : quantiles) {
+            auto nth = scratch.begin() + quantileRank(replicates, q);
+            nth_element(from, nth, scratch.end());
+            row.push_back(*nth);
+            from = nth;
+        }
+    }
+    sink->write(row.data());
+}
+
+int Ensemble::simulate(unsigned long days) {
+    if (sink) {
+        vector<string> names = SIERD
+            ? vector<string>{ "S", "E", "I", "R", "D", "Isum" }
+            : vector<string>{ "S", "I", "R", "Isum" };
+        vector<string> columns;
+        for (const string &name : names) {
+            for (const char *suffix : quantileNames) {
+                columns.push_back(name + suffix);
+            }
+        }
+        if (replicates == 0 || sink->open(columns) != 0) {
+            sink.reset();
+            return 1;
+        }
+    }
+
+    const vector<Timeline::Change> &changes = timeline.getChanges();
+    for (unsigned long i = 0; i < days; i++) {
+        // Interventions of this day, changes are sorted by day
+        while (pending < changes.size() && changes[pending].day <= day) {
+            const Timeline::Change &change = changes[pending++];
+            Timeline::apply(change, R0, alpha, sigma, omega, beta);
+        }
+
+        if (sink) {
+            writeQuantiles();
+        }
+        step();
+    }
+
+    int status = 0;
+    if (sink) {
+        status = sink->close();
+        sink.reset();
+    }
+    return status;
+}
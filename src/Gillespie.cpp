@@ -0,0 +1,228 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Exact stochastic simulation of compartment models implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Gillespie.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Gillespie.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace {
+    const double never = numeric_limits<double>::infinity();
+
+    // Events between full sums of the propensities, bounds rounding drift of the total
+    const uint64_t resumPeriod = 1 << 16;
+}
+
+Gillespie::Gillespie(const CompartmentModel<double> &model, uint64_t seed, Method method)
+    : method(method), random(seed), names(model.getNames()) {
+    for (size_t c = 0; c < model.compartments(); c++) {
+        state.push_back(llround(model.get((int)c)));
+    }
+    for (const CompartmentModel<double>::Flow &flow : model.getFlows()) {
+        Reaction reaction;
+        reaction.from = flow.from;
+        reaction.to = flow.to;
+        reaction.contact = flow.contact;
+        reaction.rate = model.getParameter(flow.parameter) / (flow.contact < 0 ? 1.0 : model.getPopulation());
+        reactions.push_back(reaction);
+    }
+    buildDependencies();
+
+    for (size_t r = 0; r < reactions.size(); r++) {
+        propensity.push_back(evaluate((int)r));
+        total += propensity.back();
+    }
+
+    if (method == NEXT_REACTION) {
+        for (size_t r = 0; r < reactions.size(); r++) {
+            firing.push_back(propensity[r] > 0.0 ? exponential() / propensity[r] : never);
+            position.push_back(heap.size());
+            heap.push_back((int)r);
+            siftUp(heap.size() - 1);
+        }
+    }
+}
+
+double Gillespie::evaluate(int reaction) const {
+    const Reaction &r = reactions[reaction];
+    double value = r.rate * state[r.from];
+    return r.contact < 0 ? value : value * state[r.contact];
+}
+
+void Gillespie::buildDependencies() {
+    // A reaction changes its source and target, every reaction reading either depends on it
+    dependentStart.push_back(0);
+    for (const Reaction &fired : reactions) {
+        for (size_t s = 0; s < reactions.size(); s++) {
+            const Reaction &other = reactions[s];
+            if (other.from == fired.from || other.from == fired.to
+                || other.contact == fired.from || other.contact == fired.to) {
+                dependents.push_back((int)s);
+            }
+        }
+        dependentStart.push_back(dependents.size());
+    }
+}
+
+void Gillespie::fire(int reaction) {
+    state[reactions[reaction].from]--;
+    state[reactions[reaction].to]++;
+    events++;
+}
+
+bool Gillespie::stepDirect(double until) {
+    if (total <= 0.0) {
+        return false;
+    }
+    // Exponential waiting time, an event past the limit is dropped (memoryless)
+    double next = time + exponential() / total;
+    if (next > until) {
+        return false;
+    }
+
+    // Reaction picked proportionally to its propensity
+    double target = random.uniform() * total;
+    int chosen = -1;
+    for (size_t r = 0; r < reactions.size(); r++) {
+        if (propensity[r] > 0.0) {
+            chosen = (int)r;
+            target -= propensity[r];
+            if (target < 0.0) {
+                break;
+            }
+        }
+    }
+    if (chosen < 0) {
+        return false;
+    }
+
+    time = next;
+    fire(chosen);
+    for (size_t k = dependentStart[chosen]; k < dependentStart[chosen + 1]; k++) {
+        int d = dependents[k];
+        double value = evaluate(d);
+        total += value - propensity[d];
+        propensity[d] = value;
+    }
+    if (events % resumPeriod == 0 || total < 0.0) {
+        total = 0.0;
+        for (double value : propensity) {
+            total += value;
+        }
+    }
+    return true;
+}
+
+bool Gillespie::stepNextReaction(double until) {
+    if (heap.empty() || firing[heap[0]] > until) {
+        return false;
+    }
+    int chosen = heap[0];
+    time = firing[chosen];
+    fire(chosen);
+
+    for (size_t k = dependentStart[chosen]; k < dependentStart[chosen + 1]; k++) {
+        int d = dependents[k];
+        double old = propensity[d], value = evaluate(d);
+        propensity[d] = value;
+
+        double next = never;
+        if (value > 0.0) {
+            // Other reactions keep their waiting time rescaled to the new propensity
+            next = (d != chosen && old > 0.0)
+                ? time + (old / value) * (firing[d] - time)
+                : time + exponential() / value;
+        }
+        heapUpdate(d, next);
+    }
+    return true;
+}
+
+uint64_t Gillespie::advance(double until) {
+    uint64_t before = events;
+    if (method == DIRECT) {
+        while (stepDirect(until)) {}
+    } else {
+        while (stepNextReaction(until)) {}
+    }
+    time = max(time, until);
+    return events - before;
+}
+
+int Gillespie::simulate(unsigned long days, TrajectorySink &sink) {
+    if (sink.open(names) != 0) {
+        return 1;
+    }
+    vector<double> row(state.size());
+    double start = time;
+    for (unsigned long i = 0; i < days; i++) {
+        for (size_t c = 0; c < state.size(); c++) {
+            row[c] = (double)state[c];
+        }
+        sink.write(row.data());
+        advance(start + i + 1.0);
+    }
+    return sink.close();
+}
+
+double Gillespie::propensityError() const {
+    double error = 0.0;
+    for (size_t r = 0; r < reactions.size(); r++) {
+        error = max(error, fabs(propensity[r] - evaluate((int)r)));
+    }
+    return error;
+}
+
+void Gillespie::heapUpdate(int reaction, double next) {
+    double previous = firing[reaction];
+    firing[reaction] = next;
+    if (next < previous) {
+        siftUp(position[reaction]);
+    } else {
+        siftDown(position[reaction]);
+    }
+}
+
+void Gillespie::siftUp(size_t slot) {
+    int reaction = heap[slot];
+    while (slot > 0) {
+        size_t parent = (slot - 1) / 2;
+        if (firing[heap[parent]] <= firing[reaction]) {
+            break;
+        }
+        heap[slot] = heap[parent];
+        position[heap[slot]] = slot;
+        slot = parent;
+    }
+    heap[slot] = reaction;
+    position[reaction] = slot;
+}
+
+void Gillespie::siftDown(size_t slot) {
+    int reaction = heap[slot];
+    for (;;) {
+        size_t child = 2 * slot + 1;
+        if (child >= heap.size()) {
+            break;
+        }
+        if (child + 1 < heap.size() && firing[heap[child + 1]] < firing[heap[child]]) {
+            child++;
+        }
+        if (firing[reaction] <= firing[heap[child]]) {
+            break;
+        }
+        heap[slot] = heap[child];
+        position[heap[slot]] = slot;
+        slot = child;
+    }
+    heap[slot] = reaction;
+    position[reaction] = slot;
+}
@@ -0,0 +1,236 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Region and age stratified SEIRD metapopulation implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Metapopulation.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Metapopulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+    // Rows per task, large enough to keep the scheduling cost negligible
+    const size_t rowBlock = 512;
+}
+
+Metapopulation::Metapopulation(size_t regions, size_t groups)
+    : regions(regions), groups(groups),
+      S(regions * groups), E(regions * groups), I(regions * groups), R(regions * groups), D(regions * groups),
+      N(regions * groups), sumInfected(regions * groups),
+      prevalence(regions * groups), nextPrevalence(regions * groups) {}
+
+void Metapopulation::setPopulation(size_t patch, double N, double exposed, double infected) {
+    this->N[patch] = N;
+    S[patch] = N - infected - exposed;
+    E[patch] = exposed;
+    I[patch] = infected;
+    R[patch] = D[patch] = 0.0;
+    sumInfected[patch] = infected;
+    prevalence[patch] = N > 0.0 ? infected / N : 0.0;
+}
+
+void Metapopulation::addContact(size_t row, size_t column, double contacts) {
+    Entry entry = { (uint32_t)row, (uint32_t)column, contacts };
+    entries.push_back(entry);
+    compiled = false;
+}
+
+int Metapopulation::loadContacts(const string &path) {
+    ifstream input(path);
+    if (!input) {
+        cerr << "Cannot open contacts " << path << endl;
+        return 1;
+    }
+
+    string line;
+    unsigned long number = 0;
+    while (getline(input, line)) {
+        number++;
+        string text = line.substr(0, line.find('#'));
+        if (text.find_first_not_of(" \t\r") == string::npos) {
+            continue;
+        }
+        stringstream tokens(text);
+
+        size_t region, group, contactRegion, contactGroup;
+        double contacts;
+        string rest;
+        if (!(tokens >> region >> group >> contactRegion >> contactGroup >> contacts) || tokens >> rest
+            || region >= regions || contactRegion >= regions || group >= groups || contactGroup >= groups
+            || contacts < 0.0) {
+            cerr << path << ":" << number << ": bad contact: " << line << endl;
+            return 1;
+        }
+        addContact(patch(region, group), patch(contactRegion, contactGroup), contacts);
+    }
+    return 0;
+}
+
+void Metapopulation::setRates(double R0, double alpha, double sigma, double omega) {
+    this->R0 = R0;
+    this->alpha = alpha;
+    this->beta = alpha * R0;
+    this->sigma = sigma;
+    this->omega = omega;
+}
+
+void Metapopulation::setTimeline(const Timeline &timeline) {
+    this->timeline = timeline;
+    pending = 0;
+}
+
+void Metapopulation::setThreads(unsigned threads) {
+    this->threads = threads;
+    pool.reset();
+}
+
+void Metapopulation::setSink(unique_ptr<TrajectorySink> sink) {
+    this->sink = move(sink);
+}
+
+size_t Metapopulation::nonZeros() {
+    if (!compiled) {
+        compile();
+    }
+    return columns.size();
+}
+
+void Metapopulation::compile() {
+    // Row major order, duplicates next to each other
+    sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.row != b.row ? a.row < b.row : a.column < b.column;
+    });
+    size_t merged = 0;
+    for (size_t k = 0; k < entries.size(); k++) {
+        if (merged > 0 && entries[merged - 1].row == entries[k].row && entries[merged - 1].column == entries[k].column) {
+            entries[merged - 1].contacts += entries[k].contacts;
+        } else {
+            entries[merged++] = entries[k];
+        }
+    }
+    entries.resize(merged);
+
+    rowStart.assign(patches() + 1, 0);
+    columns.resize(merged);
+    weights.resize(merged);
+    for (size_t k = 0; k < merged; k++) {
+        rowStart[entries[k].row + 1]++;
+        columns[k] = entries[k].column;
+        weights[k] = entries[k].contacts;
+    }
+    for (size_t i = 0; i < patches(); i++) {
+        rowStart[i + 1] += rowStart[i];
+    }
+    compiled = true;
+}
+
+void Metapopulation::stepRows(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        // Force of infection, row i of C times the prevalence, four partial
+        // sums so consecutive additions do not wait for each other
+        const size_t first = rowStart[i], last = rowStart[i + 1];
+        double partial[4] = { 0.0, 0.0, 0.0, 0.0 };
+        size_t k = first;
+        for (; k + 4 <= last; k += 4) {
+            partial[0] += weights[k] * prevalence[columns[k]];
+            partial[1] += weights[k + 1] * prevalence[columns[k + 1]];
+            partial[2] += weights[k + 2] * prevalence[columns[k + 2]];
+            partial[3] += weights[k + 3] * prevalence[columns[k + 3]];
+        }
+        for (; k < last; k++) {
+            partial[0] += weights[k] * prevalence[columns[k]];
+        }
+        double force = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+
+        // SEIRD equations of Model, transmission clamped to the susceptible left
+        double s = S[i], e = E[i], infected = I[i];
+        double newInfected = beta * force * s;
+        double inflow = newInfected;
+        if (newInfected > s) {
+            inflow = s;
+            S[i] = 0.0;
+        } else {
+            S[i] = s - newInfected;
+            sumInfected[i] += newInfected;
+        }
+        double incubated = sigma * e, recovered = alpha * infected, dead = omega * infected;
+        E[i] = e + (inflow - incubated);
+        I[i] = infected + (incubated - recovered - dead);
+        R[i] += recovered;
+        D[i] += dead;
+        nextPrevalence[i] = N[i] > 0.0 ? I[i] / N[i] : 0.0;
+    }
+}
+
+void Metapopulation::step() {
+    if (!compiled) {
+        compile();
+    }
+
+    size_t blocks = (patches() + rowBlock - 1) / rowBlock;
+    if (threads == 1 || blocks <= 1) {
+        stepRows(0, patches());
+    } else {
+        if (!pool) {
+            pool.reset(new ThreadPool(threads));
+        }
+        pool->parallelFor(blocks, [this](size_t block) {
+            stepRows(block * rowBlock, min(patches(), (block + 1) * rowBlock));
+        }, 1);
+    }
+    prevalence.swap(nextPrevalence);
+    day++;
+}
+
+void Metapopulation::writeTotals() {
+    double total[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for (size_t i = 0; i < patches(); i++) {
+        total[0] += S[i];
+        total[1] += E[i];
+        total[2] += I[i];
+        total[3] += R[i];
+        total[4] += D[i];
+        total[5] += sumInfected[i];
+    }
+    for (double &value : total) {
+        value = round(value);
+    }
+    sink->write(total);
+}
+
+int Metapopulation::simulate(unsigned long days) {
+    if (sink && sink->open({ "S", "E", "I", "R", "D", "Isum" }) != 0) {
+        sink.reset();
+        return 1;
+    }
+
+    const vector<Timeline::Change> &changes = timeline.getChanges();
+    for (unsigned long i = 0; i < days; i++) {
+        // Interventions of this day, changes are sorted by day
+        while (pending < changes.size() && changes[pending].day <= day) {
+            const Timeline::Change &change = changes[pending++];
+            Timeline::apply(change, R0, alpha, sigma, omega, beta);
+        }
+
+        if (sink) {
+            writeTotals();
+        }
+        step();
+    }
+
+    int status = 0;
+    if (sink) {
+        status = sink->close();
+        sink.reset();
+    }
+    return status;
+}
@@ -9,234 +9,344 @@
  * @date 13. 11. 2020
  */
 #include "headers/Model.h"
+#include "headers/Report.h"
 
-using namespace std;
-
-int Model::simulate() {
-    curr.S = next.S = (N - next.I - next.E);  // Susceptible = Population - Infected - Exposed
-    stats.sumInfected = next.I;
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
-    printHeader();
+using namespace std;
 
-    // Handle output file
-    output.open("statistics/data.csv");
-    if (SIERD) {
-        output << "S,E,I,R,D,Isum,Rsum\n";
-    } else {
-        output << "S,I,R,Isum,Rsum\n";
-    }
-
-    // Simulation start
-    for (unsigned long i = 0; i < days; i++) {
-        // Chinese new year celebration epidemic spot
-        if(i == simulationDays(2020, 1, 23)){ // 23.1.2020
-            rates.R0 = 6.6037;
-            rates.beta = rates.alpha * rates.R0;
+namespace {
+    // Writes the state of every day followed by the sums of infected and recovered
+    template<typename T>
+    class SinkWriter : public BasicModel<T>::Observer {
+    public:
+        explicit SinkWriter(TrajectorySink &sink) : sink(sink) {}
+
+        int open(const BasicModel<T> &model) {
+            vector<string> columns = model.getNames();
+            columns.push_back("Isum");
+            columns.push_back("Rsum");
+            row.resize(columns.size());
+            return sink.open(columns);
         }
 
-        // China province Hubei took drastic government measures in January 27th with all cities quarantined
-        if(i == simulationDays(2020, 1, 27) && restrictions){ // 27.1.2020
-            rates.R0 = 3.7732;
-            rates.beta = rates.alpha * rates.R0;
+        void day(const BasicModel<T> &model) override {
+            Span<const T> state = model.getState();
+            for (size_t c = 0; c < state.size(); c++) {
+                row[c] = (double)round(state[c]);
+            }
+            row[state.size()] = (double)round(model.getStats().sumInfected);
+            row[state.size() + 1] = (double)round(model.getStats().sumRecovered);
+            sink.write(row.data());
         }
 
-        // Approximately after 12th February Covid19 spreading in Hubei was postponed
-        // due to radical lockdown of the province and large-scale case-screening
-        // Basic reproduction number(R0) according to studies dropped to 0.2020
-        if(i == simulationDays(2020, 2, 12) && restrictions){
-            rates.R0 = 0.2020;
-            rates.beta = rates.alpha * rates.R0;
-        }
+    private:
+        TrajectorySink &sink;
+        vector<double> row;
+    };
+}
 
-        // Track max infected people (graph spike)
-        if (round(curr.I) > stats.maxInfected) {
-            stats.maxInfected = round(curr.I);
-            stats.dayMaxInfected = i + 1ul;
-        }
+template<typename T>
+typename BasicModel<T>::Parameters BasicModel<T>::Parameters::experiment(int num) {
+    Parameters parameters;
+    parameters.SIERD = num == 3 || num == 4;
+    parameters.restrictions = num == 2 || num == 4;
+    parameters.timeline = Timeline::hubei(parameters.restrictions);
+    return parameters;
+}
 
-        // Track the biggest increment in infected people
-        if (round(derrI) > stats.maxIncrement) {
-            stats.maxIncrement = round(derrI);
-            stats.dayMaxIncrement = i + 1ul;
-        }
+template<typename T>
+BasicModel<T>::BasicModel() {
+    reset();
+}
 
-        if (SIERD) {
-            output
-                << round(curr.S) << ","
-                << round(curr.E) << ","
-                << round(curr.I) << ","
-                << round(curr.R) << ","
-                << round(curr.D) << ","
-                << round(stats.sumInfected) << ","
-                << round(stats.sumRecovered) << endl;
-            nextStep();
-        } else {
-            output
-                << round(curr.S) << ","
-                << round(curr.I) << ","
-                << round(curr.R) << ","
-                << round(stats.sumInfected) << ","
-                << round(stats.sumRecovered) << endl;
-            nextStep();
-        }
-    }
+template<typename T>
+BasicModel<T>::BasicModel(const Parameters &parameters) : parameters(parameters) {
+    reset();
+}
 
-    printFooter();
-    output.close();
-    return 0;
+template<typename T>
+void BasicModel<T>::reset() {
+    rates = parameters.rates;
+    buildGraph();  // Susceptible = Population - Infected - Exposed
+    stats = Stats();
+    stats.sumInfected = parameters.I;
+    derrI = 0.0;
+    today = 0;
+    pending = 0;
 }
 
-void Model::nextStep() {
-    // Calculate new values
-    long double newInfected = (rates.beta * curr.S * curr.I) / N;
-    if (SIERD) {
-        if (newInfected > next.S) {
-            next.S = 0;
-            next.E += curr.S - (rates.sigma * curr.E);
-        } else {
-            next.S += -newInfected;
-            next.E += newInfected - (rates.sigma * curr.E);
-            stats.sumInfected += newInfected;
-        }
-        next.I += (rates.sigma * curr.E - rates.alpha * curr.I - rates.omega * curr.I);
-        next.D += rates.omega * curr.I;
-
-        // Update values
-        curr.E = next.E;
-        curr.D = next.D;
-    } else {
-        if (newInfected > next.S) {
-            next.S = 0;
-            next.I += curr.S - (rates.alpha * curr.I);
-        } else {
-            next.S += -newInfected;
-            next.I += newInfected - rates.alpha * curr.I;
-            stats.sumInfected += newInfected;
-        }
+template<typename T>
+void BasicModel<T>::reset(const Parameters &parameters) {
+    this->parameters = parameters;
+    reset();
+}
+
+template<typename T>
+void BasicModel<T>::step() {
+    // Interventions of this day, changes are sorted by day
+    const vector<Timeline::Change> &changes = parameters.timeline.getChanges();
+    while (pending < changes.size() && changes[pending].day <= today) {
+        applyChange(changes[pending++]);
     }
 
-    // Recover
-    next.R +=  rates.alpha * curr.I;
-    stats.sumRecovered += rates.alpha * curr.I;
+    // Track max infected people (graph spike)
+    T infected = graph.get(index.I);
+    if (round(infected) > stats.maxInfected) {
+        stats.maxInfected = round(infected);
+        stats.dayMaxInfected = today + 1ul;
+    }
 
-    // Calculate change in current step
-    derrI = next.I - curr.I;
+    // Track the biggest increment in infected people
+    if (round(derrI) > stats.maxIncrement) {
+        stats.maxIncrement = round(derrI);
+        stats.dayMaxIncrement = today + 1ul;
+    }
 
-    // Update values
-    curr.S = next.S;
-    curr.I = next.I;
-    curr.R = next.R;
+    for (Observer *observer : observers) {
+        observer->day(*this);
+    }
+    nextStep();
+    today++;
 }
 
-unsigned long Model::simulationDays(int yearEnd, int monthEnd, int dayEnd) {
-    const int monthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-
-    // start of Covid19 in chinese province Hubei
-    int yearStart = 2019;
-    int monthStart = 12;
-    int dayStart = 31;
-
-    // simulating until
-    auto n1 = yearStart * 365 + dayStart;
-    for (int i = 0; i < monthStart - 1; i++) n1 += monthDays[i];
+template<typename T>
+void BasicModel<T>::runTo(unsigned long day) {
+    for (Observer *observer : observers) {
+        observer->started(*this, day);
+    }
+    while (today < day) {
+        step();
+    }
+    for (Observer *observer : observers) {
+        observer->finished(*this);
+    }
+}
 
-    auto n2 = yearEnd * 365 + dayEnd;
-    for (int i = 0; i < monthEnd - 1; i++) n2 += monthDays[i];
+template<typename T>
+void BasicModel<T>::addObserver(Observer &observer) {
+    observers.push_back(&observer);
+}
 
-    return (n2 - n1);
+template<typename T>
+void BasicModel<T>::removeObserver(Observer &observer) {
+    observers.erase(remove(observers.begin(), observers.end(), &observer), observers.end());
 }
 
-void Model::printHeader() {
-    cout << fixed;
-    cout.precision(5);
-    cout << "------------------------------------------------------------------------------------------" << endl;
-    cout << "|Simulation of SIR and SIERD epidemic models of COVID19 disease in chinese province Hubei|" << endl;
-    cout << "------------------------------------------------------------------------------------------" << endl;
-    cout << endl << "Input: " << endl;
-    cout << "\tPopulation count = " << (int)N << endl;
-    cout << "\tInfected = " << (int)round(curr.I) << endl;
-    if (SIERD) {
-        cout << "\tExposed = " << (int)round(curr.E) << endl;
+template<typename T>
+void BasicModel<T>::save(Snapshot &snapshot) const {
+    const size_t flows = graph.getFlows().size();
+    snapshot.tag("model");
+    snapshot.put((uint32_t)sizeof(T));
+    snapshot.put((uint32_t)graph.compartments());
+    snapshot.put((uint32_t)flows);
+    snapshot.put(graph.getState(), graph.compartments());
+    for (size_t f = 0; f < flows; f++) {
+        snapshot.put(graph.getCumulative((int)f));
     }
-    cout << "\tBasic reproduction number(R0) of COVID19 = " << rates.R0 << endl;
-    cout << "\tTransmission rate = " << rates.beta << endl;
-    cout << "\tRecovery rate = " << rates.alpha << endl;
-    if (SIERD) {
-        cout << "\tInfectivity = " << rates.sigma << endl;
-        cout << "\tFatality rate = " << rates.omega << endl;
-    }
-    cout << "\tGovernment takes measures = " << (restrictions ? "YES" : "NO") << endl;
-    cout << "\tFirst reported COVID19 case was in 31 December 2019" << endl;
-    cout << "\tDays of simulation until 7 December 2020 = " << days << endl;
+    const T values[] = { rates.R0, rates.alpha, rates.beta, rates.sigma, rates.omega,
+                         stats.maxInfected, stats.maxIncrement, stats.sumInfected, stats.sumRecovered, derrI };
+    snapshot.put(values, 10);
+    const uint64_t days[] = { stats.dayMaxInfected, stats.dayMaxIncrement, today };
+    snapshot.put(days, 3);
 }
 
-void Model::printFooter() {
-    cout << fixed;
-    cout.precision(5);
-    cout << "Output: " << endl;
-    cout
-        << "\tSum of all the recovered = " << (int)round(stats.sumRecovered)
-        << "(" << stats.sumRecovered / N * 100 << "% of total population of Hubei)" << endl;
+template<typename T>
+int BasicModel<T>::restore(Snapshot &snapshot) {
+    uint32_t size = 0, compartments = 0, flows = 0;
+    if (!snapshot.expect("model") || !snapshot.get(size) || !snapshot.get(compartments) || !snapshot.get(flows)
+        || size != sizeof(T) || compartments != graph.compartments() || flows != graph.getFlows().size()) {
+        return 1;
+    }
+    vector<T> state(compartments), cumulative(flows);
+    T values[10];
+    uint64_t days[3];
+    if (!snapshot.get(state.data(), compartments) || !snapshot.get(cumulative.data(), flows)
+        || !snapshot.get(values, 10) || !snapshot.get(days, 3)) {
+        return 1;
+    }
 
-    cout
-        << "\tSum of all the infected = " << (int)round(stats.sumInfected)
-        << "(" << stats.sumInfected / N * 100 << "% of total population of Hubei)" << endl;
+    for (size_t c = 0; c < compartments; c++) {
+        graph.set((int)c, state[c]);
+    }
+    for (size_t f = 0; f < flows; f++) {
+        graph.setCumulative((int)f, cumulative[f]);
+    }
+    rates.R0 = values[0];
+    rates.alpha = values[1];
+    rates.beta = values[2];
+    rates.sigma = values[3];
+    rates.omega = values[4];
+    updateParameters();
+    stats.maxInfected = values[5];
+    stats.maxIncrement = values[6];
+    stats.sumInfected = values[7];
+    stats.sumRecovered = values[8];
+    derrI = values[9];
+    stats.dayMaxInfected = days[0];
+    stats.dayMaxIncrement = days[1];
+    today = days[2];
+
+    // Changes of the simulated days are in the rates already
+    const vector<Timeline::Change> &changes = parameters.timeline.getChanges();
+    pending = 0;
+    while (pending < changes.size() && changes[pending].day < today) {
+        pending++;
+    }
+    return 0;
+}
 
-    cout
-        << "\tBiggest daily increment = " << (int)round(stats.maxIncrement)
-        << "(day No. " << stats.dayMaxIncrement << ")" << endl;
+template<typename T>
+int BasicModel<T>::simulate() {
+    // Interventions, the Hubei experiment timeline unless a custom one is set
+    if (!customTimeline) {
+        parameters.timeline = Timeline::hubei(parameters.restrictions);
+    }
+    reset();
 
-    cout
-        << "\tMost infected people at single moment = " << (int)round(stats.maxInfected)
-        << "(day No. " << stats.dayMaxInfected << ")" << endl;
+    // Handle output file
+    if (!sink && !outputPath.empty()) {
+        sink = makeSink(outputPath);
+    }
+    unique_ptr<SinkWriter<T>> writer;
+    if (sink) {
+        writer.reset(new SinkWriter<T>(*sink));
+        if (writer->open(*this) != 0) {
+            sink.reset();
+            return 1;
+        }
+    }
 
-    if(restrictions) {
-        cout << "\tBasic reproduction number(R0) of COVID19 dropped to : "<< rates.R0 << endl;
+    ConsoleReport<T> report(cout);
+    if (verbose) {
+        addObserver(report);
+    }
+    if (writer) {
+        addObserver(*writer);
     }
-    if (SIERD) {
-        cout << "\tDead = " << (int)round(curr.D) << endl;
+    runTo(days);
+    removeObserver(report);
+    if (writer) {
+        removeObserver(*writer);
+    }
+
+    int status = 0;
+    if (sink) {
+        status = sink->close();
+        sink.reset();
     }
-    cout << "------------------------------------------------------------------------------------------" << endl;
-    cout << "|########################################################################################|" << endl;
-    cout << "------------------------------------------------------------------------------------------" << endl;
+    return status;
 }
 
-int Model::exp1() {
-    return simulate();
+template<typename T>
+void BasicModel<T>::applyChange(const Timeline::Change &change) {
+    Timeline::apply(change, rates);
+    updateParameters();
 }
 
-int Model::exp2() {
-    restrictions = true;
-    return simulate();
+template<typename T>
+void BasicModel<T>::buildGraph() {
+    const T N = parameters.N, I = parameters.I, E = parameters.E;
+    graph = parameters.SIERD ? CompartmentModel<T>::seird(N, I, E) : CompartmentModel<T>::sir(N, I, E);
+
+    index.S = graph.compartment("S");
+    index.E = graph.compartment("E");
+    index.I = graph.compartment("I");
+    index.R = graph.compartment("R");
+    index.D = graph.compartment("D");
+    index.infection = graph.flow("S", parameters.SIERD ? "E" : "I");
+    index.recovery = graph.flow("I", "R");
+    index.beta = graph.parameter("beta");
+    index.alpha = graph.parameter("alpha");
+    index.sigma = graph.parameter("sigma");
+    index.omega = graph.parameter("omega");
+
+    // Sum of all the infected starts with case 0
+    graph.setCumulative(index.infection, parameters.I);
+    updateParameters();
 }
 
-int Model::exp3() {
-    SIERD = true;
-    return simulate();
+template<typename T>
+void BasicModel<T>::updateParameters() {
+    graph.setParameter(index.beta, rates.beta);
+    graph.setParameter(index.alpha, rates.alpha);
+    graph.setParameter(index.sigma, rates.sigma);
+    graph.setParameter(index.omega, rates.omega);
 }
 
-int Model::exp4() {
-    restrictions = true;
-    SIERD = true;
-    return simulate();
+template<typename T>
+void BasicModel<T>::nextStep() {
+    T infected = graph.get(index.I);
+
+    // Calculate new values
+    graph.step();
+
+    // Flows into the infected and recovered compartments so far
+    stats.sumInfected = graph.getCumulative(index.infection);
+    stats.sumRecovered = graph.getCumulative(index.recovery);
+
+    // Calculate change in current step
+    derrI = graph.get(index.I) - infected;
+}
+
+template<typename T>
+void BasicModel<T>::setRates(T R0, T alpha, T sigma, T omega) {
+    parameters.rates.R0 = R0;
+    parameters.rates.alpha = alpha;
+    parameters.rates.beta = alpha * R0;
+    parameters.rates.sigma = sigma;
+    parameters.rates.omega = omega;
 }
 
-int Model::performExp(int num) {
-    days = simulationDays(2020, 12, 7);
-    switch (num) {
-        case 1:
-            return exp1();
+template<typename T>
+void BasicModel<T>::setTimeline(const Timeline &timeline) {
+    parameters.timeline = timeline;
+    customTimeline = true;
+}
 
-        case 2:
-            return exp2();
+template<typename T>
+void BasicModel<T>::setOutput(const std::string &path) {
+    outputPath = path;
+    sink.reset();
+}
 
-        case 3:
-            return exp3();
+template<typename T>
+void BasicModel<T>::setSink(unique_ptr<TrajectorySink> sink) {
+    this->sink = move(sink);
+}
 
-        case 4:
-            return exp4();
+template<typename T>
+void BasicModel<T>::setVerbose(bool enabled) {
+    verbose = enabled;
+}
 
-        default:
-            return 1;
+template<typename T>
+int BasicModel<T>::performExp(int num, unsigned long days) {
+    if (num < 1 || num > 4) {
+        return 1;
     }
+    this->days = days > 0 ? days : Date::reportDays;
+    Parameters setup = Parameters::experiment(num);
+    parameters.SIERD = setup.SIERD;
+    parameters.restrictions = setup.restrictions;
+    return simulate();
+}
+
+SensitivityModel::Parameters sensitivityParameters(int experiment) {
+    SensitivityModel::Parameters parameters = SensitivityModel::Parameters::experiment(experiment);
+    SensitivityModel::Rates &rates = parameters.rates;
+    rates.R0 = Dual<4>::variable(rates.R0.value, 0);
+    rates.alpha = Dual<4>::variable(rates.alpha.value, 1);
+    rates.sigma = Dual<4>::variable(rates.sigma.value, 2);
+    rates.omega = Dual<4>::variable(rates.omega.value, 3);
+    rates.beta = rates.alpha * rates.R0;
+    return parameters;
 }
+
+// Supported precisions and the derivatives by four rates
+template class BasicModel<float>;
+template class BasicModel<double>;
+template class BasicModel<long double>;
+template class BasicModel<Dual<4>>;
@@ -0,0 +1,239 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Incremental nowcasting by an ensemble Kalman filter implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Nowcast.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Nowcast.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+    // Value below which lies the fraction q of the values (nearest rank), reorders them
+    double quantile(vector<double> &values, double q) {
+        auto nth = values.begin() + (size_t)floor(q * (values.size() - 1) + 0.5);
+        nth_element(values.begin(), nth, values.end());
+        return *nth;
+    }
+
+    double average(const vector<double> &values) {
+        double sum = 0.0;
+        for (double value : values) {
+            sum += value;
+        }
+        return sum / values.size();
+    }
+}
+
+Nowcast::Nowcast(const Model::Parameters &parameters, size_t members, uint64_t seed)
+    : parameters(parameters), members(max(members, (size_t)2)), random(seed) {
+    const Model::Rates &rates = parameters.rates;
+    graph = parameters.SIERD
+        ? CompartmentModel<double>::seird(parameters.N, parameters.I, parameters.E)
+        : CompartmentModel<double>::sir(parameters.N, parameters.I, parameters.E);
+    infection = graph.flow("S", parameters.SIERD ? "E" : "I");
+    beta = graph.parameter("beta");
+    graph.setParameter(graph.parameter("alpha"), rates.alpha);
+    graph.setParameter(graph.parameter("sigma"), rates.sigma);
+    graph.setParameter(graph.parameter("omega"), rates.omega);
+
+    width = graph.compartments() + 2;
+    states.resize(this->members * width);
+    predicted.assign(this->members, 0.0);
+    setR0Noise(prior, drift);
+}
+
+void Nowcast::setR0Noise(double prior, double drift) {
+    this->prior = prior;
+    this->drift = drift;
+    if (today > 0) {
+        return;
+    }
+
+    // Initial state of Model, the sum of infected starts with case 0
+    const size_t compartments = width - 2;
+    for (size_t m = 0; m < members; m++) {
+        double *state = &states[m * width];
+        copy(graph.getState(), graph.getState() + compartments, state);
+        state[compartments] = parameters.I;
+        state[compartments + 1] = log(parameters.rates.R0) + prior * normal(random);
+    }
+}
+
+void Nowcast::setReportError(double relative, double absolute) {
+    this->relative = relative;
+    this->absolute = absolute;
+}
+
+double Nowcast::step(double *state) const {
+    const size_t compartments = width - 2;
+    for (size_t c = 0; c < compartments; c++) {
+        graph.set((int)c, state[c]);
+    }
+    graph.setCumulative(infection, state[compartments]);
+    graph.setParameter(beta, parameters.rates.alpha * exp(state[compartments + 1]));
+    graph.step();
+
+    for (size_t c = 0; c < compartments; c++) {
+        state[c] = graph.get((int)c);
+    }
+    const double cases = graph.getCumulative(infection) - state[compartments];
+    state[compartments] = graph.getCumulative(infection);
+    return cases;
+}
+
+void Nowcast::advance(unsigned long day) {
+    for (; today < day; today++) {
+        for (size_t m = 0; m < members; m++) {
+            double *state = &states[m * width];
+            predicted[m] = step(state);
+            state[width - 1] += drift * normal(random);
+        }
+    }
+}
+
+int Nowcast::assimilate(unsigned long day, double cases) {
+    if (day <= today) {
+        return 1;
+    }
+    advance(day);
+    if (std::isnan(cases)) {
+        return 0;
+    }
+
+    // Covariances of every state variable with the predicted report
+    const double predictedMean = average(predicted);
+    vector<double> means(width, 0.0), covariance(width, 0.0);
+    for (size_t m = 0; m < members; m++) {
+        for (size_t w = 0; w < width; w++) {
+            means[w] += states[m * width + w] / members;
+        }
+    }
+    double variance = 0.0;
+    for (size_t m = 0; m < members; m++) {
+        const double h = predicted[m] - predictedMean;
+        variance += h * h / (members - 1);
+        for (size_t w = 0; w < width; w++) {
+            covariance[w] += (states[m * width + w] - means[w]) * h / (members - 1);
+        }
+    }
+
+    // Every member moves towards its own perturbed report
+    const double deviation = relative * cases + absolute;
+    const double gain = 1.0 / (variance + deviation * deviation);
+    for (size_t m = 0; m < members; m++) {
+        double *state = &states[m * width];
+        const double innovation = cases + deviation * normal(random) - predicted[m];
+        for (size_t w = 0; w < width; w++) {
+            state[w] += covariance[w] * gain * innovation;
+        }
+        for (size_t c = 0; c + 2 < width; c++) {
+            state[c] = max(state[c], 0.0);
+        }
+    }
+    return 0;
+}
+
+vector<Nowcast::Day> Nowcast::forecast(unsigned long days) const {
+    vector<double> copies = states, cases(members), infected(members);
+    const int I = graph.compartment("I");
+    vector<Day> result;
+    for (unsigned long d = 1; d <= days; d++) {
+        for (size_t m = 0; m < members; m++) {
+            cases[m] = step(&copies[m * width]);
+            infected[m] = copies[m * width + I];
+        }
+        Day day;
+        day.day = today + d;
+        day.cases = average(cases);
+        day.casesLow = quantile(cases, 0.05);
+        day.casesHigh = quantile(cases, 0.95);
+        day.infected = average(infected);
+        day.infectedLow = quantile(infected, 0.05);
+        day.infectedHigh = quantile(infected, 0.95);
+        result.push_back(day);
+    }
+    return result;
+}
+
+double Nowcast::getR0() const {
+    double sum = 0.0;
+    for (size_t m = 0; m < members; m++) {
+        sum += exp(states[m * width + width - 1]);
+    }
+    return sum / members;
+}
+
+double Nowcast::mean(int compartment) const {
+    const size_t column = compartment < 0 ? width - 2 : (size_t)compartment;
+    double sum = 0.0;
+    for (size_t m = 0; m < members; m++) {
+        sum += states[m * width + column];
+    }
+    return sum / members;
+}
+
+int Nowcast::serve(istream &reports, ostream &status, unsigned long horizon, const string &forecastPath) {
+    const vector<string> columns = { "day", "cases", "cases_q05", "cases_q95", "I", "I_q05", "I_q95" };
+    string line;
+    unsigned long number = 0;
+    while (getline(reports, line)) {
+        number++;
+        line = line.substr(0, line.find('#'));
+        replace(line.begin(), line.end(), ',', ' ');
+
+        stringstream tokens(line);
+        string when;
+        if (!(tokens >> when)) {
+            continue;
+        }
+        unsigned long day;
+        double cases;
+        if (!Timeline::parseDay(when, day) || !(tokens >> cases) || cases < 0.0) {
+            cerr << "reports:" << number << ": bad report: " << line << endl;
+            return 1;
+        }
+
+        auto start = chrono::steady_clock::now();
+        if (assimilate(day, cases) != 0) {
+            cerr << "reports:" << number << ": day " << day << " is not after day " << today << endl;
+            return 1;
+        }
+        vector<Day> ahead = forecast(horizon);
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        // One line per report, flushed for a reader at the other end of a pipe
+        status << "day " << day << ": R0 " << getR0() << ", infected " << round(mean(graph.compartment("I")));
+        if (!ahead.empty()) {
+            const Day &last = ahead.back();
+            status << ", cases on day " << last.day << " " << round(last.cases)
+                   << " [" << round(last.casesLow) << ", " << round(last.casesHigh) << "]";
+        }
+        status << " (" << milliseconds << " ms)" << endl;
+
+        if (!forecastPath.empty()) {
+            unique_ptr<TrajectorySink> sink = makeSink(forecastPath);
+            if (sink->open(columns) != 0) {
+                return 1;
+            }
+            for (const Day &next : ahead) {
+                const double row[] = { (double)next.day, next.cases, next.casesLow, next.casesHigh,
+                                       next.infected, next.infectedLow, next.infectedHigh };
+                sink->write(row);
+            }
+            if (sink->close() != 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,564 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Buffered trajectory output implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Output.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Output.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+    // Rows are collected up to this size before a single write
+    const size_t csvBlock = 1 << 16;
+
+    struct BinaryHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t columns;
+        uint64_t rows;
+    };
+
+    struct DeltaHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t columns;
+        uint32_t blockRows;
+        uint32_t reserved;
+    };
+
+    struct DeltaTrailer {
+        uint64_t index;
+        uint64_t rows;
+        char magic[8];
+    };
+
+    // Encoding of a column within a block
+    enum DeltaEncoding { INTEGER = 0, XOR = 1 };
+
+    void putVarint(string &out, uint64_t value) {
+        while (value >= 0x80) {
+            out += (char)(value | 0x80);
+            value >>= 7;
+        }
+        out += (char)value;
+    }
+
+    bool getVarint(const string &in, size_t &at, uint64_t &value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && at < in.size(); shift += 7) {
+            uint8_t byte = (uint8_t)in[at++];
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t zigzag(int64_t value) {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    int64_t unzigzag(uint64_t value) {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    // Whole number exactly representable as int64 and back, -0.0 keeps its sign only with XOR
+    bool whole(double value) {
+        return value == floor(value) && fabs(value) < 9007199254740992.0 && !(value == 0.0 && signbit(value));
+    }
+
+    uint64_t bitsOf(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    double fromBits(uint64_t bits) {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    bool endsWith(const string &text, const string &suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+CsvSink::CsvSink(const string &path, int precision) : path(path), precision(precision) {}
+
+CsvSink::~CsvSink() {
+    close();
+}
+
+int CsvSink::open(const vector<string> &columns) {
+    file.open(path);
+    if (!file) {
+        cerr << "Cannot open data file " << path << endl;
+        return 1;
+    }
+    this->columns = columns.size();
+    buffer.reserve(csvBlock + 256);
+    for (size_t i = 0; i < columns.size(); i++) {
+        buffer += columns[i];
+        buffer += i + 1 < columns.size() ? ',' : '\n';
+    }
+    return 0;
+}
+
+void CsvSink::write(const double *row) {
+    // With precision 6 this matches the default formatting of operator<< on std::ostream
+    char number[32];
+    for (size_t i = 0; i < columns; i++) {
+        int length = snprintf(number, sizeof(number), "%.*g", precision, row[i]);
+        buffer.append(number, length);
+        buffer += i + 1 < columns ? ',' : '\n';
+    }
+    if (buffer.size() >= csvBlock) {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+int CsvSink::close() {
+    if (!file.is_open()) {
+        return 0;
+    }
+    file.write(buffer.data(), buffer.size());
+    buffer.clear();
+    bool ok = (bool)file;
+    file.close();
+    return ok ? 0 : 1;
+}
+
+const char BinarySink::magic[8] = { 'I', 'M', 'S', 'T', 'R', 'A', 'J', '\0' };
+const uint32_t BinarySink::version;
+const size_t BinarySink::nameSize;
+const size_t BinarySink::alignment;
+
+BinarySink::BinarySink(const string &path) : path(path) {}
+
+BinarySink::~BinarySink() {
+    close();
+}
+
+size_t BinarySink::dataOffset(size_t columns) {
+    size_t header = sizeof(BinaryHeader) + columns * nameSize;
+    return (header + alignment - 1) / alignment * alignment;
+}
+
+size_t BinarySink::columnStride(size_t rows) {
+    return (rows * sizeof(double) + alignment - 1) / alignment * alignment;
+}
+
+int BinarySink::open(const vector<string> &columns) {
+    for (const string &name : columns) {
+        if (name.size() >= nameSize) {
+            cerr << "Column name too long for binary output: " << name << endl;
+            return 1;
+        }
+    }
+    names = columns;
+    data.assign(columns.size(), vector<double>());
+    opened = true;
+    return 0;
+}
+
+void BinarySink::write(const double *row) {
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i].push_back(row[i]);
+    }
+}
+
+int BinarySink::close() {
+    if (!opened) {
+        return 0;
+    }
+    opened = false;
+
+    ofstream file(path, ios::binary);
+    if (!file) {
+        cerr << "Cannot open data file " << path << endl;
+        return 1;
+    }
+
+    BinaryHeader header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.columns = (uint32_t)names.size();
+    header.rows = data.empty() ? 0 : data[0].size();
+    file.write((const char *)&header, sizeof(header));
+
+    for (const string &name : names) {
+        char padded[nameSize] = {};
+        memcpy(padded, name.data(), name.size());
+        file.write(padded, nameSize);
+    }
+    string padding(dataOffset(names.size()) - sizeof(header) - names.size() * nameSize, '\0');
+    file.write(padding.data(), padding.size());
+
+    const size_t bytes = header.rows * sizeof(double);
+    padding.assign(columnStride(header.rows) - bytes, '\0');
+    for (const vector<double> &column : data) {
+        file.write((const char *)column.data(), bytes);
+        file.write(padding.data(), padding.size());
+    }
+    data.clear();
+    return file ? 0 : 1;
+}
+
+TrajectoryReader::~TrajectoryReader() {
+    close();
+}
+
+int TrajectoryReader::open(const string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "Cannot open data file " << path << endl;
+        return 1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(BinaryHeader)) {
+        ::close(fd);
+        cerr << "Not a binary trajectory: " << path << endl;
+        return 1;
+    }
+    mapSize = info.st_size;
+    map = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        map = nullptr;
+        cerr << "Cannot map data file " << path << endl;
+        return 1;
+    }
+
+    // Validate the header before trusting any offset in it
+    const char *bytes = (const char *)map;
+    BinaryHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    size_t offset = BinarySink::dataOffset(header.columns);
+    if (memcmp(header.magic, BinarySink::magic, sizeof(header.magic)) != 0 || header.version != BinarySink::version
+        || offset > mapSize || (mapSize - offset) / sizeof(double) < header.rows
+        || (header.rows && (mapSize - offset) / BinarySink::columnStride(header.rows) < header.columns)) {
+        close();
+        cerr << "Not a binary trajectory: " << path << endl;
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < header.columns; i++) {
+        const char *name = bytes + sizeof(header) + i * BinarySink::nameSize;
+        names.push_back(string(name, strnlen(name, BinarySink::nameSize)));
+    }
+    rowCount = header.rows;
+    stride = BinarySink::columnStride(rowCount) / sizeof(double);
+    values = (const double *)(bytes + offset);
+    return 0;
+}
+
+void TrajectoryReader::close() {
+    if (map) {
+        munmap(map, mapSize);
+    }
+    map = nullptr;
+    mapSize = 0;
+    rowCount = 0;
+    stride = 0;
+    names.clear();
+    values = nullptr;
+}
+
+const double *TrajectoryReader::column(const string &name) const {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) {
+            return values + i * stride;
+        }
+    }
+    return nullptr;
+}
+
+const char DeltaSink::magic[8] = { 'I', 'M', 'S', 'D', 'L', 'O', 'G', '\0' };
+const uint32_t DeltaSink::version;
+
+DeltaSink::DeltaSink(const string &path, size_t blockRows) : path(path), blockRows(blockRows ? blockRows : 1) {}
+
+DeltaSink::~DeltaSink() {
+    close();
+}
+
+int DeltaSink::open(const vector<string> &columns) {
+    file.open(path, ios::binary);
+    if (!file) {
+        cerr << "Cannot open data file " << path << endl;
+        return 1;
+    }
+    this->columns = columns.size();
+    block.assign(this->columns * blockRows, 0.0);
+    rows = 0;
+    total = 0;
+    offsets.clear();
+
+    DeltaHeader header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.columns = (uint32_t)columns.size();
+    header.blockRows = (uint32_t)blockRows;
+    header.reserved = 0;
+    file.write((const char *)&header, sizeof(header));
+
+    buffer.clear();
+    for (const string &name : columns) {
+        putVarint(buffer, name.size());
+        buffer += name;
+    }
+    file.write(buffer.data(), buffer.size());
+    return 0;
+}
+
+void DeltaSink::write(const double *row) {
+    for (size_t c = 0; c < columns; c++) {
+        block[c * blockRows + rows] = row[c];
+    }
+    total++;
+    if (++rows == blockRows) {
+        flush();
+    }
+}
+
+void DeltaSink::flush() {
+    if (rows == 0) {
+        return;
+    }
+    offsets.push_back((uint64_t)file.tellp());
+    buffer.clear();
+    for (size_t c = 0; c < columns; c++) {
+        const double *values = &block[c * blockRows];
+        bool integers = true;
+        for (size_t r = 0; r < rows && integers; r++) {
+            integers = whole(values[r]);
+        }
+
+        buffer += (char)(integers ? INTEGER : XOR);
+        if (integers) {
+            // Daily changes of smooth curves change slowly, their differences are the smallest
+            int64_t previous = 0, change = 0;
+            for (size_t r = 0; r < rows; r++) {
+                const int64_t value = (int64_t)values[r];
+                putVarint(buffer, zigzag(value - previous - change));
+                change = value - previous;
+                previous = value;
+            }
+            continue;
+        }
+
+        // Count byte: zero low bytes in the high nibble, stored bytes in the low one
+        uint64_t previous = 0;
+        for (size_t r = 0; r < rows; r++) {
+            uint64_t bits = bitsOf(values[r]), difference = bits ^ previous;
+            previous = bits;
+            unsigned low = 0, stored = 0;
+            if (difference != 0) {
+                low = __builtin_ctzll(difference) / 8;
+                stored = 8 - __builtin_clzll(difference) / 8 - low;
+            }
+            buffer += (char)(low << 4 | stored);
+            for (unsigned b = 0; b < stored; b++) {
+                buffer += (char)(difference >> (8 * (low + b)));
+            }
+        }
+    }
+    file.write(buffer.data(), buffer.size());
+    rows = 0;
+}
+
+int DeltaSink::close() {
+    if (!file.is_open()) {
+        return 0;
+    }
+    flush();
+
+    DeltaTrailer trailer;
+    trailer.index = (uint64_t)file.tellp();
+    trailer.rows = total;
+    memcpy(trailer.magic, magic, sizeof(magic));
+    file.write((const char *)offsets.data(), offsets.size() * sizeof(uint64_t));
+    file.write((const char *)&trailer, sizeof(trailer));
+
+    bool ok = (bool)file;
+    file.close();
+    offsets.clear();
+    return ok ? 0 : 1;
+}
+
+int DeltaReader::open(const string &path) {
+    close();
+    file.open(path, ios::binary);
+    if (!file) {
+        cerr << "Cannot open data file " << path << endl;
+        return 1;
+    }
+
+    DeltaHeader header;
+    DeltaTrailer trailer;
+    file.read((char *)&header, sizeof(header));
+    bool ok = file && memcmp(header.magic, DeltaSink::magic, sizeof(header.magic)) == 0
+        && header.version == DeltaSink::version && header.blockRows > 0;
+
+    // Names are read byte by byte, the varints have no fixed size
+    for (uint32_t c = 0; ok && c < header.columns; c++) {
+        string length;
+        int byte;
+        while ((byte = file.get()) != EOF && length.size() < 10) {
+            length += (char)byte;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        size_t at = 0;
+        uint64_t size = 0;
+        ok = getVarint(length, at, size) && size < (1u << 16);
+        string name(ok ? size : 0, '\0');
+        ok = ok && file.read(&name[0], size);
+        names.push_back(name);
+    }
+
+    // Trailer and index at the end of the file
+    ok = ok && file.seekg(-(streamoff)sizeof(trailer), ios::end) && file.read((char *)&trailer, sizeof(trailer));
+    const uint64_t end = ok ? (uint64_t)file.tellg() - sizeof(trailer) : 0;
+    const uint64_t blocks = ok ? (trailer.rows + header.blockRows - 1) / header.blockRows : 0;
+    ok = ok && memcmp(trailer.magic, DeltaSink::magic, sizeof(trailer.magic)) == 0
+        && trailer.index <= end && (end - trailer.index) == blocks * sizeof(uint64_t);
+    if (ok) {
+        offsets.resize(blocks);
+        file.seekg(trailer.index);
+        ok = blocks == 0 || file.read((char *)offsets.data(), blocks * sizeof(uint64_t));
+        offsets.push_back(trailer.index);
+    }
+    for (size_t b = 0; ok && b + 1 < offsets.size(); b++) {
+        ok = offsets[b] < offsets[b + 1];
+    }
+    if (!ok) {
+        close();
+        cerr << "Not a trajectory log: " << path << endl;
+        return 1;
+    }
+    rowCount = trailer.rows;
+    blockRows = header.blockRows;
+    cache.assign(names.size() * blockRows, 0.0);
+    return 0;
+}
+
+void DeltaReader::close() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    names.clear();
+    rowCount = 0;
+    blockRows = 0;
+    offsets.clear();
+    cached = 0;
+    cache.clear();
+}
+
+int DeltaReader::load(size_t index) {
+    if (cached == index + 1) {
+        return 0;
+    }
+    cached = 0;
+    bytes.resize(offsets[index + 1] - offsets[index]);
+    file.clear();
+    file.seekg(offsets[index]);
+    bool ok = (bool)file.read(&bytes[0], bytes.size());
+
+    const size_t rows = min(blockRows, rowCount - index * blockRows);
+    size_t at = 0;
+    for (size_t c = 0; ok && c < names.size(); c++) {
+        double *values = &cache[c * blockRows];
+        ok = at < bytes.size();
+        const int encoding = ok ? bytes[at++] : -1;
+        if (encoding == INTEGER) {
+            int64_t previous = 0, change = 0;
+            uint64_t delta;
+            for (size_t r = 0; ok && r < rows; r++) {
+                ok = getVarint(bytes, at, delta);
+                change += unzigzag(delta);
+                previous += change;
+                values[r] = (double)previous;
+            }
+        } else if (encoding == XOR) {
+            uint64_t previous = 0;
+            for (size_t r = 0; ok && r < rows; r++) {
+                ok = at < bytes.size();
+                const unsigned count = ok ? (uint8_t)bytes[at++] : 0, low = count >> 4, stored = count & 0xf;
+                ok = ok && low + stored <= 8 && at + stored <= bytes.size();
+                uint64_t difference = 0;
+                for (unsigned b = 0; ok && b < stored; b++) {
+                    difference |= (uint64_t)(uint8_t)bytes[at++] << (8 * (low + b));
+                }
+                previous ^= difference;
+                values[r] = fromBits(previous);
+            }
+        } else {
+            ok = false;
+        }
+    }
+    if (!ok || at != bytes.size()) {
+        cerr << "Damaged trajectory log block " << index << endl;
+        return 1;
+    }
+    cached = index + 1;
+    return 0;
+}
+
+int DeltaReader::row(size_t day, double *values) {
+    if (day >= rowCount || load(day / blockRows) != 0) {
+        return 1;
+    }
+    for (size_t c = 0; c < names.size(); c++) {
+        values[c] = cache[c * blockRows + day % blockRows];
+    }
+    return 0;
+}
+
+int DeltaReader::column(const string &name, vector<double> &values) {
+    size_t c = find(names.begin(), names.end(), name) - names.begin();
+    if (c == names.size()) {
+        return 1;
+    }
+    values.clear();
+    for (size_t b = 0; b + 1 < offsets.size(); b++) {
+        if (load(b) != 0) {
+            return 1;
+        }
+        const double *begin = &cache[c * blockRows];
+        values.insert(values.end(), begin, begin + min(blockRows, rowCount - b * blockRows));
+    }
+    return 0;
+}
+
+unique_ptr<TrajectorySink> makeSink(const string &path) {
+    if (endsWith(path, ".bin")) {
+        return unique_ptr<TrajectorySink>(new BinarySink(path));
+    }
+    if (endsWith(path, ".delta")) {
+        return unique_ptr<TrajectorySink>(new DeltaSink(path));
+    }
+    return unique_ptr<TrajectorySink>(new CsvSink(path));
+}
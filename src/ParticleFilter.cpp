@@ -0,0 +1,233 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Particle filter over the stochastic SIR/SEIRD model implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file ParticleFilter.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/ParticleFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // Particles per task
+    const size_t particleBlock = 256;
+
+    // Smallest mean of a report, no report has zero likelihood
+    const double smallestMean = 0.5;
+
+    // ln of sum of exp of the values, without overflow
+    double logSumExp(const vector<double> &values) {
+        double top = *max_element(values.begin(), values.end());
+        if (std::isinf(top)) {
+            return top;
+        }
+        double sum = 0.0;
+        for (double value : values) {
+            sum += exp(value - top);
+        }
+        return top + log(sum);
+    }
+}
+
+ParticleFilter::ParticleFilter(const Model::Parameters &parameters, size_t particles, uint64_t seed)
+    : parameters(parameters), particles(max(particles, (size_t)1)), seed(seed),
+      resampling(seed, (uint64_t)-1) {
+    counts.resize(this->particles);
+    slots.resize(this->particles);
+    setR0Noise(prior, drift);
+}
+
+void ParticleFilter::setR0Noise(double prior, double drift) {
+    this->prior = prior;
+    this->drift = drift;
+    day = 0;
+    logLikelihood = 0.0;
+    last = Step();
+    resampling = RandomStream(seed, (uint64_t)-1);
+
+    // Susceptible = Population - Infected - Exposed, as in Model
+    const uint64_t N = llround(parameters.N), infected = llround(parameters.I), exposed = llround(parameters.E);
+    S.assign(particles, N - infected - exposed);
+    E.assign(particles, parameters.SIERD ? exposed : 0);
+    I.assign(particles, infected);
+    R.assign(particles, 0);
+    D.assign(particles, 0);
+    sumInfected.assign(particles, infected);
+    newInfected.assign(particles, 0);
+    logWeight.assign(particles, -log((double)particles));
+    logR0.resize(particles);
+    streams.clear();
+    for (size_t k = 0; k < particles; k++) {
+        streams.push_back(RandomStream(seed, k));
+        logR0[k] = log(parameters.rates.R0) + prior * normal(streams[k]);
+    }
+}
+
+void ParticleFilter::setThreads(unsigned threads) {
+    this->threads = threads;
+    pool.reset();
+}
+
+template<class Body>
+void ParticleFilter::forBlocks(const Body &body) {
+    size_t blocks = (particles + particleBlock - 1) / particleBlock;
+    if (threads == 1 || blocks <= 1) {
+        body(0, particles);
+        return;
+    }
+    if (!pool) {
+        pool.reset(new ThreadPool(threads));
+    }
+    pool->parallelFor(blocks, [this, &body](size_t block) {
+        body(block * particleBlock, min(particles, (block + 1) * particleBlock));
+    }, 1);
+}
+
+void ParticleFilter::stepParticles(size_t begin, size_t end) {
+    // Daily probabilities of leaving a compartment, as in Ensemble
+    const Model::Rates &rates = parameters.rates;
+    const bool SIERD = parameters.SIERD;
+    const double N = parameters.N;
+    const double leaveE = -expm1(-rates.sigma);
+    const double leaveI = -expm1(-(rates.alpha + (SIERD ? rates.omega : 0.0)));
+    const double deadShare = SIERD ? rates.omega / (rates.alpha + rates.omega) : 0.0;
+
+    for (size_t k = begin; k < end; k++) {
+        RandomStream &random = streams[k];
+        const double beta = rates.alpha * exp(logR0[k]);
+        uint64_t s = S[k], e = E[k], infected = I[k];
+
+        uint64_t infections = binomial(random, s, -expm1(-beta * infected / N));
+        uint64_t incubated = SIERD ? binomial(random, e, leaveE) : 0;
+        uint64_t leaving = binomial(random, infected, leaveI);
+        uint64_t dead = binomial(random, leaving, deadShare);
+
+        S[k] = s - infections;
+        if (SIERD) {
+            E[k] = e + infections - incubated;
+            I[k] = infected + incubated - leaving;
+            D[k] += dead;
+        } else {
+            I[k] = infected + infections - leaving;
+        }
+        R[k] += leaving - dead;
+        sumInfected[k] += infections;
+        newInfected[k] = infections;
+        logR0[k] += drift * normal(random);
+    }
+}
+
+void ParticleFilter::advance(unsigned long day) {
+    for (; this->day < day; this->day++) {
+        forBlocks([this](size_t begin, size_t end) { stepParticles(begin, end); });
+    }
+}
+
+int ParticleFilter::assimilate(unsigned long day, double cases) {
+    if (day <= this->day) {
+        return 1;
+    }
+    advance(day);
+    last = Step();
+    last.day = day;
+    if (std::isnan(cases)) {
+        last.effectiveSize = effectiveSize();
+        return 0;
+    }
+
+    // Negative binomial, the terms without the mean are the same for every particle
+    const double k = dispersion;
+    const double constant = lgamma(cases + k) - lgamma(k) - lgamma(cases + 1.0);
+    forBlocks([&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; p++) {
+            const double mean = max((double)newInfected[p], smallestMean);
+            logWeight[p] += constant + k * log(k / (k + mean)) + cases * log(mean / (k + mean));
+        }
+    });
+
+    // Weights before the report sum to 1, so their new sum is the likelihood of the report
+    const double total = logSumExp(logWeight);
+    for (double &value : logWeight) {
+        value -= total;
+    }
+    last.logLikelihood = total;
+    logLikelihood += total;
+    last.effectiveSize = effectiveSize();
+
+    if (last.effectiveSize < threshold * particles) {
+        resample();
+        last.resampled = true;
+    }
+    return 0;
+}
+
+void ParticleFilter::resample() {
+    // Copies of every particle, one uniform places all the N equally spaced pointers
+    const double spacing = 1.0 / particles;
+    const double start = resampling.uniform() * spacing;
+    double cumulative = 0.0;
+    size_t drawn = 0;
+    for (size_t p = 0; p < particles; p++) {
+        cumulative += exp(logWeight[p]);
+        counts[p] = 0;
+        while (drawn < particles && start + drawn * spacing < cumulative) {
+            counts[p]++;
+            drawn++;
+        }
+    }
+    // Rounding may leave the last pointers past the sum
+    counts[particles - 1] += (uint32_t)(particles - drawn);
+
+    // Particles not drawn free their slots for the extra copies
+    size_t free = 0;
+    for (size_t p = 0; p < particles; p++) {
+        if (counts[p] == 0) {
+            slots[free++] = (uint32_t)p;
+        }
+    }
+    size_t next = 0;
+    for (size_t p = 0; p < particles; p++) {
+        for (uint32_t copy = 1; copy < counts[p]; copy++) {
+            const size_t slot = slots[next++];
+            S[slot] = S[p];
+            E[slot] = E[p];
+            I[slot] = I[p];
+            R[slot] = R[p];
+            D[slot] = D[p];
+            sumInfected[slot] = sumInfected[p];
+            newInfected[slot] = newInfected[p];
+            logR0[slot] = logR0[p];
+        }
+    }
+    fill(logWeight.begin(), logWeight.end(), -log((double)particles));
+}
+
+double ParticleFilter::effectiveSize() const {
+    double squares = 0.0;
+    for (double value : logWeight) {
+        squares += exp(2.0 * value);
+    }
+    return 1.0 / squares;
+}
+
+double ParticleFilter::mean(const uint64_t *values) const {
+    double sum = 0.0;
+    for (size_t p = 0; p < particles; p++) {
+        sum += exp(logWeight[p]) * values[p];
+    }
+    return sum;
+}
+
+double ParticleFilter::getR0() const {
+    double sum = 0.0;
+    for (size_t p = 0; p < particles; p++) {
+        sum += exp(logWeight[p] + logR0[p]);
+    }
+    return sum;
+}
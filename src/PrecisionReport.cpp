@@ -0,0 +1,84 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Accuracy report of Model precisions implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file PrecisionReport.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/PrecisionReport.h"
+#include "headers/Model.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+    // Final statistics converted to the reference precision
+    struct Outcome {
+        long double sumInfected, maxInfected, dead;
+        unsigned long dayMaxInfected;
+        double seconds/* Mean wall time of one run */;
+    };
+
+    template<typename T>
+    Outcome run(int experiment, unsigned repeats) {
+        Outcome outcome = Outcome();
+        chrono::steady_clock::time_point start;
+        // The first run only warms up caches and is not timed
+        for (unsigned i = 0; i <= repeats; i++) {
+            if (i == 1) {
+                start = chrono::steady_clock::now();
+            }
+            BasicModel<T> model;
+            model.setVerbose(false);
+            model.setOutput("");
+            model.performExp(experiment);
+            outcome.sumInfected = model.getStats().sumInfected;
+            outcome.maxInfected = model.getStats().maxInfected;
+            outcome.dayMaxInfected = model.getStats().dayMaxInfected;
+            outcome.dead = model.getDead();
+        }
+        outcome.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / repeats;
+        return outcome;
+    }
+
+    double relative(long double value, long double reference) {
+        return reference == 0 ? 0.0 : (double)fabsl((value - reference) / reference);
+    }
+}
+
+int precisionReport(ostream &out, unsigned repeats) {
+    const char *const names[] = { "long double", "double", "float" };
+    char line[256];
+
+    out << "Model precision report: final statistics per experiment and arithmetic type\n";
+    out << "rel. err. is relative to long double, time is the mean of " << repeats << " runs without data file\n\n";
+    snprintf(line, sizeof(line), "%-4s %-12s %16s %14s %8s %14s %12s %12s %12s %10s\n",
+             "exp", "type", "sumInfected", "maxInfected", "dayMax", "dead",
+             "err(sumInf)", "err(maxInf)", "err(dead)", "time[us]");
+    out << line;
+
+    for (int experiment = 1; experiment <= 4; experiment++) {
+        Outcome outcomes[] = {
+            run<long double>(experiment, repeats),
+            run<double>(experiment, repeats),
+            run<float>(experiment, repeats),
+        };
+        const Outcome &reference = outcomes[0];
+        for (int i = 0; i < 3; i++) {
+            const Outcome &o = outcomes[i];
+            snprintf(line, sizeof(line), "%-4d %-12s %16.3Lf %14.0Lf %8lu %14.3Lf %12.3e %12.3e %12.3e %10.1f\n",
+                     experiment, names[i], o.sumInfected, o.maxInfected, o.dayMaxInfected, o.dead,
+                     relative(o.sumInfected, reference.sumInfected),
+                     relative(o.maxInfected, reference.maxInfected),
+                     relative(o.dead, reference.dead),
+                     o.seconds * 1e6);
+            out << line;
+        }
+    }
+    return out ? 0 : 1;
+}
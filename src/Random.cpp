@@ -0,0 +1,160 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Counter-based random streams and samplers implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Random.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Random.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // Philox4x32 multipliers and Weyl key increments
+    const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+    const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+    // Below this mean the simple samplers are faster than the rejection ones
+    const double smallMean = 10.0;
+}
+
+RandomStream::RandomStream(uint64_t seed, uint64_t stream) {
+    // Seed and stream are mixed into the key so any pair gives a distinct stream
+    key[0] = (uint32_t)seed ^ (uint32_t)(stream * 0x9E3779B97F4A7C15ull >> 32);
+    key[1] = (uint32_t)(seed >> 32) ^ (uint32_t)stream;
+    counter[2] = (uint32_t)stream;
+    counter[3] = (uint32_t)(stream >> 32);
+}
+
+void RandomStream::generate(const uint32_t in[4], uint32_t out[4]) const {
+    uint32_t c0 = in[0], c1 = in[1], c2 = in[2], c3 = in[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; round++) {
+        uint64_t product0 = (uint64_t)M0 * c0, product1 = (uint64_t)M1 * c2;
+        uint32_t hi0 = (uint32_t)(product0 >> 32), lo0 = (uint32_t)product0;
+        uint32_t hi1 = (uint32_t)(product1 >> 32), lo1 = (uint32_t)product1;
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += W0;
+        k1 += W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+void RandomStream::refill() {
+    generate(counter, block);
+    used = 0;
+
+    // 64-bit position, the upper half of the counter holds the stream number
+    if (++counter[0] == 0) {
+        counter[1]++;
+    }
+}
+
+uint64_t binomial(RandomStream &random, uint64_t n, double p) {
+    if (n == 0 || p <= 0.0) {
+        return 0;
+    }
+    if (p >= 1.0) {
+        return n;
+    }
+    if (p > 0.5) {
+        return n - binomial(random, n, 1.0 - p);
+    }
+
+    double q = 1.0 - p;
+    if (n * p < smallMean) {
+        // Inversion, walking the probabilities from zero successes
+        double s = p / q, a = (n + 1) * s, first = pow(q, (double)n);
+        for (;;) {
+            double u = random.uniform(), r = first;
+            uint64_t k = 0;
+            while (u > r && k < n) {
+                u -= r;
+                k++;
+                r *= a / k - s;
+            }
+            if (u <= r) {
+                return k;
+            }
+        }
+    }
+
+    // BTRS, the exact test needs logarithms only for the few samples outside the quick acceptance
+    double spq = sqrt(n * p * q);
+    double b = 1.15 + 2.53 * spq, a = -0.0873 + 0.0248 * b + 0.01 * p, c = n * p + 0.5;
+    double vr = 0.92 - 4.2 / b;
+    double alpha = 0.0, lpq = 0.0, m = 0.0, h = 0.0;
+    for (;;) {
+        double u = random.uniform() - 0.5, v = random.uniform();
+        double us = 0.5 - fabs(u);
+        double k = floor((2.0 * a / us + b) * u + c);
+        if (k < 0.0 || k > n) {
+            continue;
+        }
+        if (us >= 0.07 && v <= vr) {
+            return (uint64_t)k;
+        }
+        if (alpha == 0.0) {
+            alpha = (2.83 + 5.1 / b) * spq;
+            lpq = log(p / q);
+            m = floor((n + 1) * p);
+            h = lgamma(m + 1.0) + lgamma(n - m + 1.0);
+        }
+        v = log(v * alpha / (a / (us * us) + b));
+        if (v <= h - lgamma(k + 1.0) - lgamma(n - k + 1.0) + (k - m) * lpq) {
+            return (uint64_t)k;
+        }
+    }
+}
+
+uint64_t poisson(RandomStream &random, double mean) {
+    if (mean <= 0.0) {
+        return 0;
+    }
+    if (mean < smallMean) {
+        // Multiplication of uniforms until the product drops below exp(-mean)
+        double limit = exp(-mean), product = random.uniform();
+        uint64_t k = 0;
+        while (product > limit) {
+            product *= random.uniform();
+            k++;
+        }
+        return k;
+    }
+
+    // PTRS
+    double smu = sqrt(mean), logMean = log(mean);
+    double b = 0.931 + 2.53 * smu, a = -0.059 + 0.02483 * b;
+    double logInvAlpha = log(1.1239 + 1.1328 / (b - 3.4)), vr = 0.9277 - 3.6224 / (b - 2.0);
+    for (;;) {
+        double u = random.uniform() - 0.5, v = random.uniform();
+        double us = 0.5 - fabs(u);
+        double k = floor((2.0 * a / us + b) * u + mean + 0.43);
+        if (us >= 0.07 && v <= vr) {
+            return (uint64_t)k;
+        }
+        if (k < 0.0 || (us < 0.013 && v > us)) {
+            continue;
+        }
+        if (log(v) + logInvAlpha - log(a / (us * us) + b) <= -mean + k * logMean - lgamma(k + 1.0)) {
+            return (uint64_t)k;
+        }
+    }
+}
+
+double normal(RandomStream &random) {
+    // The second variable of the pair is not kept, the sampler has no state of its own
+    const double radius = random.uniform();
+    const double angle = random.uniform();
+    return sqrt(-2.0 * log(radius)) * cos(6.283185307179586 * angle);
+}
@@ -0,0 +1,85 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Console report of a simulation implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Report.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Report.h"
+
+#include <cmath>
+
+using namespace std;
+
+template<typename T>
+void ConsoleReport<T>::started(const BasicModel<T> &model, unsigned long until) {
+    const typename BasicModel<T>::Parameters &parameters = model.getParameters();
+    const typename BasicModel<T>::Rates &rates = model.getRates();
+    Span<const T> state = model.getState();
+
+    out << fixed;
+    out.precision(5);
+    out << "------------------------------------------------------------------------------------------" << endl;
+    out << "|Simulation of SIR and SIERD epidemic models of COVID19 disease in chinese province Hubei|" << endl;
+    out << "------------------------------------------------------------------------------------------" << endl;
+    out << endl << "Input: " << endl;
+    out << "\tPopulation count = " << (int)(double)parameters.N << endl;
+    out << "\tInfected = " << (int)(double)round(state[model.compartment("I")]) << endl;
+    if (parameters.SIERD) {
+        out << "\tExposed = " << (int)(double)round(state[model.compartment("E")]) << endl;
+    }
+    out << "\tBasic reproduction number(R0) of COVID19 = " << rates.R0 << endl;
+    out << "\tTransmission rate = " << rates.beta << endl;
+    out << "\tRecovery rate = " << rates.alpha << endl;
+    if (parameters.SIERD) {
+        out << "\tInfectivity = " << rates.sigma << endl;
+        out << "\tFatality rate = " << rates.omega << endl;
+    }
+    out << "\tGovernment takes measures = " << (parameters.restrictions ? "YES" : "NO") << endl;
+    out << "\tFirst reported COVID19 case was in 31 December 2019" << endl;
+    out << "\tDays of simulation until 7 December 2020 = " << until << endl;
+}
+
+template<typename T>
+void ConsoleReport<T>::finished(const BasicModel<T> &model) {
+    const typename BasicModel<T>::Parameters &parameters = model.getParameters();
+    const typename BasicModel<T>::Stats &stats = model.getStats();
+    const T N = parameters.N;
+
+    out << fixed;
+    out.precision(5);
+    out << "Output: " << endl;
+    out
+        << "\tSum of all the recovered = " << (int)(double)round(stats.sumRecovered)
+        << "(" << stats.sumRecovered / N * 100 << "% of total population of Hubei)" << endl;
+
+    out
+        << "\tSum of all the infected = " << (int)(double)round(stats.sumInfected)
+        << "(" << stats.sumInfected / N * 100 << "% of total population of Hubei)" << endl;
+
+    out
+        << "\tBiggest daily increment = " << (int)(double)round(stats.maxIncrement)
+        << "(day No. " << stats.dayMaxIncrement << ")" << endl;
+
+    out
+        << "\tMost infected people at single moment = " << (int)(double)round(stats.maxInfected)
+        << "(day No. " << stats.dayMaxInfected << ")" << endl;
+
+    if(parameters.restrictions) {
+        out << "\tBasic reproduction number(R0) of COVID19 dropped to : "<< model.getRates().R0 << endl;
+    }
+    if (parameters.SIERD) {
+        out << "\tDead = " << (int)(double)round(model.getDead()) << endl;
+    }
+    out << "------------------------------------------------------------------------------------------" << endl;
+    out << "|########################################################################################|" << endl;
+    out << "------------------------------------------------------------------------------------------" << endl;
+}
+
+// Supported precisions and the derivatives by four rates
+template class ConsoleReport<float>;
+template class ConsoleReport<double>;
+template class ConsoleReport<long double>;
+template class ConsoleReport<Dual<4>>;
@@ -0,0 +1,86 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Binary snapshot of a simulation state implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Snapshot.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Snapshot.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t size;
+    };
+}
+
+const char Snapshot::magic[8] = "IMSSNAP";
+
+bool Snapshot::expect(const char *kind) {
+    size_t length = strlen(kind) + 1;
+    if (bytes.size() - position < length || memcmp(bytes.data() + position, kind, length) != 0) {
+        return false;
+    }
+    position += length;
+    return true;
+}
+
+int Snapshot::save(const string &path) const {
+    ofstream file(path, ios::binary);
+    if (!file) {
+        cerr << "Cannot open snapshot " << path << endl;
+        return 1;
+    }
+    SnapshotHeader header = SnapshotHeader();
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.size = bytes.size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(bytes.data(), bytes.size());
+    if (!file) {
+        cerr << "Cannot write snapshot " << path << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Snapshot::load(const string &path) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        cerr << "Cannot open snapshot " << path << endl;
+        return 1;
+    }
+    SnapshotHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+        cerr << "Not a snapshot: " << path << endl;
+        return 1;
+    }
+
+    // A corrupt size must not allocate more than the file holds
+    const streampos start = file.tellg();
+    file.seekg(0, ios::end);
+    const uint64_t remaining = (uint64_t)(file.tellg() - start);
+    file.seekg(start);
+    if (header.size > remaining) {
+        cerr << "Truncated snapshot " << path << endl;
+        return 1;
+    }
+    vector<char> payload(header.size);
+    if (!file.read(payload.data(), payload.size())) {
+        cerr << "Truncated snapshot " << path << endl;
+        return 1;
+    }
+    bytes.swap(payload);
+    position = 0;
+    return 0;
+}
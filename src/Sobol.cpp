@@ -0,0 +1,255 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Variance-based global sensitivity analysis implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Sobol.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Sobol.h"
+#include "headers/Random.h"
+#include "headers/ThreadPool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+using simlib3::ParameterVector;
+
+namespace {
+    // Samples evaluated together, bounds the memory of the outputs
+    const size_t sampleBlock = 256;
+
+    // Primitive polynomial of degree s with inner coefficients a and the initial direction numbers
+    struct Primitive {
+        unsigned s, a;
+        uint32_t m[8];
+    };
+
+    // Joe and Kuo, dimensions 2 to 40, the first dimension is the van der Corput sequence
+    const Primitive primitives[SobolSequence::maxDimensions - 1] = {
+        { 1, 0, { 1 } },
+        { 2, 1, { 1, 3 } },
+        { 3, 1, { 1, 3, 1 } },
+        { 3, 2, { 1, 1, 1 } },
+        { 4, 1, { 1, 1, 3, 3 } },
+        { 4, 4, { 1, 3, 5, 13 } },
+        { 5, 2, { 1, 1, 5, 5, 17 } },
+        { 5, 4, { 1, 1, 5, 5, 5 } },
+        { 5, 7, { 1, 1, 7, 11, 19 } },
+        { 5, 11, { 1, 1, 5, 1, 1 } },
+        { 5, 13, { 1, 1, 1, 3, 11 } },
+        { 5, 14, { 1, 3, 5, 5, 31 } },
+        { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+        { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+        { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+        { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+        { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+        { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+        { 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+        { 7, 4, { 1, 3, 7, 13, 13, 15, 69 } },
+        { 7, 7, { 1, 1, 3, 13, 7, 35, 63 } },
+        { 7, 8, { 1, 3, 5, 9, 1, 25, 53 } },
+        { 7, 14, { 1, 3, 1, 13, 9, 35, 107 } },
+        { 7, 19, { 1, 3, 1, 5, 27, 61, 31 } },
+        { 7, 21, { 1, 1, 5, 11, 19, 41, 61 } },
+        { 7, 28, { 1, 3, 5, 3, 3, 13, 69 } },
+        { 7, 31, { 1, 1, 7, 13, 1, 19, 1 } },
+        { 7, 32, { 1, 3, 7, 5, 13, 19, 59 } },
+        { 7, 37, { 1, 1, 3, 9, 25, 29, 41 } },
+        { 7, 41, { 1, 3, 5, 13, 23, 1, 55 } },
+        { 7, 42, { 1, 3, 7, 3, 13, 59, 17 } },
+        { 7, 50, { 1, 3, 1, 3, 5, 53, 69 } },
+        { 7, 55, { 1, 1, 5, 5, 23, 33, 13 } },
+        { 7, 56, { 1, 1, 7, 7, 1, 61, 123 } },
+        { 7, 59, { 1, 1, 7, 9, 13, 61, 49 } },
+        { 7, 62, { 1, 3, 3, 5, 3, 55, 33 } },
+        { 8, 14, { 1, 3, 1, 15, 31, 13, 49, 245 } },
+        { 8, 21, { 1, 3, 5, 15, 31, 59, 63, 97 } },
+        { 8, 22, { 1, 3, 1, 11, 11, 11, 77, 249 } },
+    };
+
+    /**
+     * Random permutation of [0, count) keyed by the stream, a dimension and a
+     * design: Feistel network on the next even power of two, values outside
+     * the range walk the cycle until they are back inside
+     */
+    uint64_t permute(const RandomStream &random, uint64_t value, uint64_t count, uint32_t dimension, uint32_t design) {
+        unsigned half = 1;
+        while ((uint64_t)1 << (2 * half) < count) {
+            half++;
+        }
+        const uint64_t mask = ((uint64_t)1 << half) - 1;
+        do {
+            uint64_t left = value >> half, right = value & mask;
+            for (uint32_t round = 0; round < 4; round++) {
+                const uint32_t counter[4] = { (uint32_t)right, dimension, design, round };
+                uint32_t out[4];
+                random.generate(counter, out);
+                uint64_t next = left ^ (out[0] & mask);
+                left = right;
+                right = next;
+            }
+            value = left << half | right;
+        } while (value >= count);
+        return value;
+    }
+}
+
+const size_t SobolSequence::maxDimensions;
+
+SobolSequence::SobolSequence(size_t dimensions) : directions(32 * min(dimensions, maxDimensions)) {
+    for (unsigned k = 0; k < 32 && !directions.empty(); k++) {
+        directions[k] = (uint32_t)1 << (31 - k);
+    }
+    for (size_t d = 1; d < this->dimensions(); d++) {
+        const Primitive &p = primitives[d - 1];
+        uint32_t *v = &directions[32 * d];
+        for (unsigned k = 0; k < 32; k++) {
+            if (k < p.s) {
+                v[k] = p.m[k] << (31 - k);
+                continue;
+            }
+            v[k] = v[k - p.s] ^ (v[k - p.s] >> p.s);
+            for (unsigned j = 1; j < p.s; j++) {
+                if ((p.a >> (p.s - 1 - j)) & 1) {
+                    v[k] ^= v[k - j];
+                }
+            }
+        }
+    }
+}
+
+void SobolSequence::point(uint64_t index, double *coordinates) const {
+    // Gray code order gives the same points as the recurrence of Antonov and Saleev
+    const uint64_t gray = index ^ (index >> 1);
+    for (size_t d = 0; d < dimensions(); d++) {
+        uint32_t x = 0;
+        for (unsigned k = 0; k < 32; k++) {
+            if ((gray >> k) & 1) {
+                x ^= directions[32 * d + k];
+            }
+        }
+        coordinates[d] = x * (1.0 / 4294967296.0);
+    }
+}
+
+SobolAnalysis::SobolAnalysis(const ParameterVector &parameters, size_t outputs, Evaluation evaluation)
+    : parameters(parameters), outputs(outputs), evaluation(evaluation) {
+    clear();
+}
+
+void SobolAnalysis::clear() {
+    const size_t n = parameters.size();
+    samples = 0;
+    designs = 0;
+    shift.assign(outputs, 0.0);
+    means.assign(outputs, 0.0);
+    squares.assign(outputs, 0.0);
+    first.assign(n * outputs, 0.0);
+    total.assign(n * outputs, 0.0);
+}
+
+void SobolAnalysis::latinPoint(size_t sample, size_t count, double *coordinates) const {
+    // Stratum of the sample in every coordinate, then a uniform position within it
+    const RandomStream random(seed, 0);
+    for (size_t d = 0; d < 2 * (size_t)parameters.size(); d++) {
+        uint64_t stratum = permute(random, sample, count, (uint32_t)d, (uint32_t)designs);
+        const uint32_t counter[4] = { (uint32_t)sample, (uint32_t)d, (uint32_t)designs, 4 };
+        uint32_t out[4];
+        random.generate(counter, out);
+        coordinates[d] = (stratum + out[0] * (1.0 / 4294967296.0)) / count;
+    }
+}
+
+int SobolAnalysis::run(size_t count) {
+    const size_t n = parameters.size(), runs = n + 2;
+    if (design == SOBOL && 2 * n > SobolSequence::maxDimensions) {
+        cerr << "Sobol sequence supports at most " << SobolSequence::maxDimensions / 2 << " parameters" << endl;
+        return 1;
+    }
+    SobolSequence sequence(design == SOBOL ? 2 * n : 0);
+    unique_ptr<ThreadPool> pool;
+    if (threads != 1) {
+        pool.reset(new ThreadPool(threads));
+    }
+
+    const size_t start = samples;
+    vector<double> coordinates(sampleBlock * 2 * n), results(sampleBlock * runs * outputs);
+    for (size_t begin = 0; begin < count; begin += sampleBlock) {
+        const size_t block = min(sampleBlock, count - begin);
+        for (size_t j = 0; j < block; j++) {
+            if (design == SOBOL) {
+                sequence.point(start + begin + j, &coordinates[j * 2 * n]);
+            } else {
+                latinPoint(begin + j, count, &coordinates[j * 2 * n]);
+            }
+        }
+
+        // Run r of a sample: 0 is A, 1 is B, 2 + i is A with the parameter i of B
+        auto evaluate = [&](size_t k) {
+            const size_t j = k / runs, r = k % runs;
+            const double *a = &coordinates[j * 2 * n], *b = a + n;
+            ParameterVector values = parameters;
+            for (size_t i = 0; i < n; i++) {
+                const double u = r == 1 || r == i + 2 ? b[i] : a[i];
+                values[(int)i] = values[(int)i].Min() + u * values[(int)i].Range();
+            }
+            evaluation(values, &results[k * outputs]);
+        };
+        if (pool) {
+            pool->parallelFor(block * runs, evaluate);
+        } else {
+            for (size_t k = 0; k < block * runs; k++) {
+                evaluate(k);
+            }
+        }
+
+        // Folded in sample order, the sums do not depend on the threads
+        for (size_t j = 0; j < block; j++) {
+            const double *f = &results[j * runs * outputs];
+            for (size_t o = 0; o < outputs; o++) {
+                if (samples == 0) {
+                    shift[o] = f[o];
+                }
+                const double a = f[o] - shift[o], b = f[outputs + o] - shift[o];
+                const double pair[2] = { a, b };
+                for (size_t t = 0; t < 2; t++) {
+                    const double delta = pair[t] - means[o];
+                    means[o] += delta / (2 * samples + t + 1);
+                    squares[o] += delta * (pair[t] - means[o]);
+                }
+                for (size_t i = 0; i < n; i++) {
+                    const double ab = f[(i + 2) * outputs + o] - shift[o];
+                    first[i * outputs + o] += b * (ab - a);
+                    total[i * outputs + o] += (a - ab) * (a - ab);
+                }
+            }
+            samples++;
+        }
+    }
+    if (design == LATIN_HYPERCUBE) {
+        designs++;
+    }
+    return 0;
+}
+
+double SobolAnalysis::mean(size_t output) const {
+    return shift[output] + means[output];
+}
+
+double SobolAnalysis::variance(size_t output) const {
+    return samples > 0 ? squares[output] / (2 * samples) : 0.0;
+}
+
+double SobolAnalysis::firstOrder(size_t parameter, size_t output) const {
+    const double v = variance(output);
+    return v > 0.0 ? first[parameter * outputs + output] / samples / v : 0.0;
+}
+
+double SobolAnalysis::totalEffect(size_t parameter, size_t output) const {
+    const double v = variance(output);
+    return v > 0.0 ? total[parameter * outputs + output] / (2 * samples) / v : 0.0;
+}
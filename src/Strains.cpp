@@ -0,0 +1,236 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Multi-strain SIR/SEIRD model implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Strains.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Strains.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using namespace std;
+
+namespace {
+    /**
+     * Scales the outflows of a compartment down proportionally if together
+     * they take more than it holds, a single outflow becomes the whole value
+     *
+     * @return true if the outflows empty the compartment
+     */
+    bool limit(double *flux, size_t count, double value) {
+        double total = 0.0;
+        for (size_t k = 0; k < count; k++) {
+            total += flux[k];
+        }
+        if (total <= value) {
+            return false;
+        }
+        for (size_t k = 0; k < count; k++) {
+            flux[k] = value * (flux[k] / total);
+        }
+        return true;
+    }
+}
+
+StrainModel::StrainModel(const Model::Parameters &parameters)
+    : parameters(parameters), rates(parameters.rates) {
+    // Susceptible = Population - Infected - Exposed, as in Model
+    S = parameters.N - parameters.I - parameters.E;
+    addStrain(1.0, 0, 0.0);
+    E[0] = parameters.SIERD ? parameters.E : 0.0;
+    I[0] = parameters.I;
+    sumInfected[0] = parameters.I;
+    updateBeta();
+}
+
+size_t StrainModel::addStrain(double transmissibility, unsigned long arrival, double seeds) {
+    const size_t old = strains(), count = old + 1;
+    E.push_back(0.0);
+    I.push_back(0.0);
+    R.push_back(0.0);
+    sumInfected.push_back(0.0);
+    sumRecovered.push_back(0.0);
+    this->transmissibility.push_back(transmissibility);
+    beta.push_back(rates.beta * transmissibility);
+    this->seeds.push_back(seeds);
+    this->arrival.push_back(arrival);
+
+    // New row and column of full protection
+    vector<double> grown(count * count, 0.0);
+    for (size_t from = 0; from < old; from++) {
+        copy(&escape[from * old], &escape[from * old] + old, &grown[from * count]);
+    }
+    escape.swap(grown);
+
+    infection.resize(count);
+    incubation.resize(count);
+    recovery.resize(count);
+    death.resize(count);
+    reinfection.resize(count * count);
+    emptiedR.resize(count);
+    return old;
+}
+
+void StrainModel::setCrossImmunity(size_t from, size_t to, double protection) {
+    escape[from * strains() + to] = 1.0 - protection;
+}
+
+void StrainModel::setSink(unique_ptr<TrajectorySink> sink) {
+    this->sink = move(sink);
+}
+
+void StrainModel::updateBeta() {
+    for (size_t k = 0; k < strains(); k++) {
+        beta[k] = rates.beta * transmissibility[k];
+    }
+}
+
+void StrainModel::step() {
+    // Interventions of this day, changes are sorted by day
+    const vector<Timeline::Change> &changes = parameters.timeline.getChanges();
+    while (pending < changes.size() && changes[pending].day <= today) {
+        const Timeline::Change &change = changes[pending++];
+        Timeline::apply(change, rates);
+        updateBeta();
+    }
+
+    const size_t K = strains();
+    const bool SIERD = parameters.SIERD;
+    const double N = parameters.N;
+    for (size_t k = 0; k < K; k++) {
+        if (seeds[k] > 0.0 && arrival[k] <= today) {
+            // Never more seeds than susceptible people left
+            const double seeded = min(seeds[k], S);
+            S -= seeded;
+            I[k] += seeded;
+            sumInfected[k] += seeded;
+            seeds[k] = 0.0;
+        }
+    }
+
+    // Fluxes from the current state, never more than the source holds, as in CompartmentModel.
+    // All strains leave S and every R_j together, their sum is limited to the value.
+    for (size_t k = 0; k < K; k++) {
+        infection[k] = beta[k] * S * I[k] / N;
+        recovery[k] = min(rates.alpha * I[k], I[k]);
+    }
+    const bool emptiedS = limit(infection.data(), K, S);
+    if (SIERD) {
+        for (size_t k = 0; k < K; k++) {
+            incubation[k] = min(rates.sigma * E[k], E[k]);
+            death[k] = min(rates.omega * I[k], I[k]);
+        }
+    }
+    for (size_t j = 0; j < K; j++) {
+        const double *open = &escape[j * K];
+        double *flux = &reinfection[j * K];
+        for (size_t k = 0; k < K; k++) {
+            flux[k] = open[k] * beta[k] * R[j] * I[k] / N;
+        }
+        emptiedR[j] = limit(flux, K, R[j]);
+    }
+
+    // Changes of every compartment summed from zero in the order of the Model flows
+    double deltaS = 0.0, deltaD = 0.0;
+    for (size_t k = 0; k < K; k++) {
+        deltaS -= infection[k];
+    }
+    for (size_t k = 0; k < K; k++) {
+        double deltaE = 0.0, deltaI = 0.0, deltaR = 0.0, reinfected = 0.0;
+        for (size_t j = 0; j < K; j++) {
+            reinfected += reinfection[j * K + k];
+            deltaR -= reinfection[k * K + j];
+        }
+        if (emptiedR[k]) {
+            // Rounding of the scaled fluxes must not leave a negative rest
+            deltaR = -R[k];
+        }
+        if (SIERD) {
+            deltaE += infection[k];
+            deltaE -= incubation[k];
+            deltaE += reinfected;
+            deltaI += incubation[k];
+            deltaI -= recovery[k];
+            deltaI -= death[k];
+            deltaD += death[k];
+        } else {
+            deltaI += infection[k];
+            deltaI -= recovery[k];
+            deltaI += reinfected;
+        }
+        deltaR += recovery[k];
+        E[k] += deltaE;
+        I[k] += deltaI;
+        R[k] += deltaR;
+        sumInfected[k] += infection[k];
+        sumInfected[k] += reinfected;
+        sumRecovered[k] += recovery[k];
+    }
+    S = emptiedS ? 0.0 : S + deltaS;
+    D += deltaD;
+    today++;
+}
+
+void StrainModel::write() {
+    size_t column = 0;
+    double infected = 0.0, recovered = 0.0;
+    row[column++] = round(S);
+    for (size_t k = 0; k < strains(); k++) {
+        if (parameters.SIERD) {
+            row[column++] = round(E[k]);
+        }
+        row[column++] = round(I[k]);
+        row[column++] = round(R[k]);
+        infected += sumInfected[k];
+        recovered += sumRecovered[k];
+    }
+    if (parameters.SIERD) {
+        row[column++] = round(D);
+    }
+    row[column++] = round(infected);
+    row[column++] = round(recovered);
+    sink->write(row.data());
+}
+
+int StrainModel::simulate(unsigned long days) {
+    if (sink) {
+        vector<string> columns = { "S" };
+        for (size_t k = 0; k < strains(); k++) {
+            const string suffix = k == 0 ? "" : to_string(k + 1);
+            if (parameters.SIERD) {
+                columns.push_back("E" + suffix);
+            }
+            columns.push_back("I" + suffix);
+            columns.push_back("R" + suffix);
+        }
+        if (parameters.SIERD) {
+            columns.push_back("D");
+        }
+        columns.push_back("Isum");
+        columns.push_back("Rsum");
+        row.resize(columns.size());
+        if (sink->open(columns) != 0) {
+            sink.reset();
+            return 1;
+        }
+    }
+
+    while (today < days) {
+        if (sink) {
+            write();
+        }
+        step();
+    }
+
+    int status = 0;
+    if (sink) {
+        status = sink->close();
+        sink.reset();
+    }
+    return status;
+}
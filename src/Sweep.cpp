@@ -0,0 +1,274 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Parallel parameter sweep implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Sweep.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Sweep.h"
+#include "headers/ThreadPool.h"
+
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    const char *const fieldNames[] = { "experiment", "R0", "alpha", "sigma", "omega" };
+    const int fieldCount = 5;
+
+    string trim(const string &text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == string::npos) {
+            return "";
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    vector<string> split(const string &text, char separator) {
+        vector<string> parts;
+        stringstream stream(text);
+        string part;
+        while (getline(stream, part, separator)) {
+            parts.push_back(trim(part));
+        }
+        return parts;
+    }
+
+    int fieldIndex(const string &name) {
+        for (int i = 0; i < fieldCount; i++) {
+            if (name == fieldNames[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void setField(Sweep::Run &run, int field, double value) {
+        switch (field) {
+            case 0: run.experiment = (int)value; break;
+            case 1: run.R0 = value; break;
+            case 2: run.alpha = value; break;
+            case 3: run.sigma = value; break;
+            case 4: run.omega = value; break;
+        }
+    }
+
+    bool parseNumber(const string &text, double &value) {
+        char *end = nullptr;
+        value = strtod(text.c_str(), &end);
+        return !text.empty() && *end == '\0';
+    }
+
+    // Comma separated values or start:stop:step range with start <= stop
+    bool parseValues(const string &text, vector<double> &values) {
+        vector<string> range = split(text, ':');
+        if (range.size() == 3) {
+            double start, stop, step;
+            if (!parseNumber(range[0], start) || !parseNumber(range[1], stop) || !parseNumber(range[2], step)) {
+                return false;
+            }
+            // Ascending ranges only, a reversed or infinite one has no step count
+            if (step <= 0 || !(start <= stop) || !isfinite(stop - start)) {
+                return false;
+            }
+            // Count steps instead of accumulating to avoid drifting past stop
+            unsigned long count = (unsigned long)floor((stop - start) / step + 1e-9) + 1;
+            for (unsigned long i = 0; i < count; i++) {
+                values.push_back(start + i * step);
+            }
+            return true;
+        }
+
+        for (const string &item : split(text, ',')) {
+            double value;
+            if (!parseNumber(item, value)) {
+                return false;
+            }
+            values.push_back(value);
+        }
+        return !values.empty();
+    }
+
+    bool isComment(const string &line) {
+        return line.empty() || line[0] == '#';
+    }
+}
+
+int Sweep::load(const string &path) {
+    ifstream input(path);
+    if (!input) {
+        cerr << "Cannot open sweep file " << path << endl;
+        return 1;
+    }
+
+    // The first meaningful line decides between grid and list format
+    string line;
+    while (getline(input, line)) {
+        line = trim(line);
+        if (isComment(line)) {
+            continue;
+        }
+        if (line.find('=') != string::npos) {
+            input.seekg(0);
+            return loadGrid(input);
+        }
+        return loadList(input, line);
+    }
+    cerr << "Sweep file " << path << " is empty" << endl;
+    return 1;
+}
+
+int Sweep::loadGrid(ifstream &input) {
+    vector<vector<double>> values(fieldCount);
+    string line;
+    while (getline(input, line)) {
+        line = trim(line);
+        if (isComment(line)) {
+            continue;
+        }
+        size_t eq = line.find('=');
+        int field = eq == string::npos ? -1 : fieldIndex(trim(line.substr(0, eq)));
+        if (field < 0 || !parseValues(trim(line.substr(eq + 1)), values[field])) {
+            cerr << "Bad sweep grid line: " << line << endl;
+            return 1;
+        }
+    }
+
+    // Unspecified parameters keep the defaults of Run
+    Run defaults;
+    const double defaultValues[] = { (double)defaults.experiment, defaults.R0, defaults.alpha, defaults.sigma, defaults.omega };
+    size_t total = 1;
+    for (int i = 0; i < fieldCount; i++) {
+        if (values[i].empty()) {
+            values[i].push_back(defaultValues[i]);
+        }
+        total *= values[i].size();
+    }
+
+    // Cartesian product, the last parameter changes fastest
+    runs.reserve(runs.size() + total);
+    for (size_t k = 0; k < total; k++) {
+        Run run;
+        size_t rest = k;
+        for (int i = fieldCount - 1; i >= 0; i--) {
+            setField(run, i, values[i][rest % values[i].size()]);
+            rest /= values[i].size();
+        }
+        runs.push_back(run);
+    }
+    return 0;
+}
+
+int Sweep::loadList(ifstream &input, const string &header) {
+    vector<int> columns;
+    for (const string &name : split(header, ',')) {
+        int field = fieldIndex(name);
+        if (field < 0) {
+            cerr << "Unknown sweep parameter: " << name << endl;
+            return 1;
+        }
+        columns.push_back(field);
+    }
+
+    string line;
+    while (getline(input, line)) {
+        line = trim(line);
+        if (isComment(line)) {
+            continue;
+        }
+        vector<string> cells = split(line, ',');
+        if (cells.size() != columns.size()) {
+            cerr << "Bad sweep list row: " << line << endl;
+            return 1;
+        }
+        Run run;
+        for (size_t i = 0; i < cells.size(); i++) {
+            double value;
+            if (!parseNumber(cells[i], value)) {
+                cerr << "Bad sweep list row: " << line << endl;
+                return 1;
+            }
+            setField(run, columns[i], value);
+        }
+        runs.push_back(run);
+    }
+    return 0;
+}
+
+void Sweep::add(const Run &run) {
+    runs.push_back(run);
+}
+
+void Sweep::setTimeline(const Timeline &timeline) {
+    this->timeline = timeline;
+    customTimeline = true;
+}
+
+int Sweep::execute(unsigned threads, const string &outDir, bool trajectories, bool binary) {
+    if (mkdir(outDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        cerr << "Cannot create sweep directory " << outDir << endl;
+        return 1;
+    }
+
+    const string extension = binary ? ".bin" : ".csv";
+
+    // Every run owns its Model and result slot, workers share nothing else
+    results.assign(runs.size(), Result());
+    {
+        ThreadPool pool(threads);
+        pool.parallelFor(runs.size(), [&](size_t i) {
+            const Run &run = runs[i];
+            Model model;
+            model.setVerbose(false);
+            model.setRates(run.R0, run.alpha, run.sigma, run.omega);
+            if (customTimeline) {
+                model.setTimeline(timeline);
+            }
+            model.setOutput(trajectories ? outDir + "/run_" + to_string(i) + extension : "");
+            results[i].status = model.performExp(run.experiment);
+            results[i].stats = model.getStats();
+            results[i].dead = model.getDead();
+        });
+    }
+
+    int failed = writeSummary(outDir + "/sweep" + extension, binary);
+    for (const Result &result : results) {
+        if (result.status != 0) {
+            failed = 1;
+        }
+    }
+    return failed;
+}
+
+int Sweep::writeSummary(const string &path, bool binary) const {
+    // Full precision, the summary is an input of further analysis
+    unique_ptr<TrajectorySink> summary(binary ? (TrajectorySink *)new BinarySink(path) : new CsvSink(path, 10));
+    const vector<string> columns = {
+        "run", "experiment", "R0", "alpha", "sigma", "omega", "status",
+        "sumInfected", "sumRecovered", "maxInfected", "dayMaxInfected", "maxIncrement", "dayMaxIncrement", "dead"
+    };
+    if (summary->open(columns) != 0) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < runs.size(); i++) {
+        const Run &run = runs[i];
+        const Result &result = results[i];
+        const double row[] = {
+            (double)i, (double)run.experiment, run.R0, run.alpha, run.sigma, run.omega, (double)result.status,
+            round(result.stats.sumInfected), round(result.stats.sumRecovered), round(result.stats.maxInfected),
+            (double)result.stats.dayMaxInfected, round(result.stats.maxIncrement), (double)result.stats.dayMaxIncrement,
+            round(result.dead)
+        };
+        summary->write(row);
+    }
+    return summary->close();
+}
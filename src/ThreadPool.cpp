@@ -0,0 +1,207 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Work-stealing thread pool implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file ThreadPool.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/ThreadPool.h"
+
+using namespace std;
+
+namespace {
+    // Pool and index of the worker running on this thread
+    thread_local const ThreadPool *currentPool = nullptr;
+    thread_local unsigned currentIndex = 0;
+
+    // Initial slots of a deque, enough for the loops of the models without growing
+    const size_t initialSlots = 64;
+}
+
+void ThreadPool::Queue::pushBack(Task &task) {
+    if (count == slots.size()) {
+        // Oldest first in the new slots
+        vector<Task> grown(max<size_t>(1, 2 * slots.size()));
+        for (size_t i = 0; i < count; i++) {
+            grown[i] = move(slots[(head + i) % slots.size()]);
+        }
+        slots.swap(grown);
+        head = 0;
+    }
+    slots[(head + count++) % slots.size()] = move(task);
+}
+
+bool ThreadPool::Queue::popBack(Task &task) {
+    if (count == 0) {
+        return false;
+    }
+    Task &slot = slots[(head + --count) % slots.size()];
+    task = move(slot);
+    slot = nullptr;
+    return true;
+}
+
+bool ThreadPool::Queue::popFront(Task &task) {
+    if (count == 0) {
+        return false;
+    }
+    Task &slot = slots[head];
+    task = move(slot);
+    slot = nullptr;
+    head = (head + 1) % slots.size();
+    count--;
+    return true;
+}
+
+ThreadPool::ThreadPool(unsigned threads) : queues(threads ? threads : max(1u, thread::hardware_concurrency())), pending(0), next(0) {
+    for (auto &queue : queues) {
+        queue.slots.resize(initialSlots);
+    }
+    for (unsigned i = 0; i < queues.size(); i++) {
+        workers.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> guard(idleLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    // Tasks spawned by a worker stay local, others are spread round robin
+    unsigned target = currentWorker();
+    if (target == size()) {
+        target = (unsigned)(next++ % queues.size());
+    }
+
+    pending++;
+    {
+        lock_guard<mutex> guard(queues[target].lock);
+        queues[target].pushBack(task);
+    }
+    {
+        // Taking the lock orders the push before a worker goes to sleep
+        lock_guard<mutex> guard(idleLock);
+    }
+    wakeUp.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(idleLock);
+    allDone.wait(guard, [this] { return pending == 0; });
+}
+
+void ThreadPool::parallelFor(size_t n, const function<void(size_t)> &body, size_t grain) {
+    if (n == 0) {
+        return;
+    }
+    // Several chunks per worker leave room for stealing on uneven runs
+    if (grain == 0) {
+        grain = max<size_t>(1, n / (size() * 8));
+    }
+    // Chunks of this call only, the caller may be a task itself
+    struct Loop {
+        ThreadPool *pool;
+        const function<void(size_t)> &body;
+        size_t n, grain;
+        atomic<size_t> remaining;
+    } loop { this, body, n, grain, { (n + grain - 1) / grain } };
+    atomic<size_t> &remaining = loop.remaining;
+    for (size_t begin = 0; begin < n; begin += grain) {
+        // Two words of capture are stored inside the task, no allocation
+        submit([&loop, begin] {
+            const size_t end = min(loop.n, begin + loop.grain);
+            for (size_t i = begin; i < end; i++) {
+                loop.body(i);
+            }
+            if (--loop.remaining == 0) {
+                lock_guard<mutex> guard(loop.pool->idleLock);
+                loop.pool->allDone.notify_all();
+            }
+        });
+    }
+
+    // A worker runs queued tasks meanwhile instead of blocking its slot
+    const unsigned self = currentWorker();
+    Task task;
+    while (remaining != 0) {
+        if (self < size() && take(self, task)) {
+            execute(task);
+            continue;
+        }
+        unique_lock<mutex> guard(idleLock);
+        allDone.wait(guard, [&remaining] { return remaining == 0; });
+    }
+}
+
+unsigned ThreadPool::currentWorker() const {
+    return currentPool == this ? currentIndex : size();
+}
+
+bool ThreadPool::take(unsigned self, Task &task) {
+    // Own deque first, newest task is the one most likely still in cache
+    {
+        lock_guard<mutex> guard(queues[self].lock);
+        if (queues[self].popBack(task)) {
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another worker
+    for (size_t i = 1; i < queues.size(); i++) {
+        Queue &victim = queues[(self + i) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (victim.popFront(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(Task &task) {
+    task();
+    task = nullptr;
+    if (--pending == 0) {
+        lock_guard<mutex> guard(idleLock);
+        allDone.notify_all();
+    }
+}
+
+void ThreadPool::run(unsigned self) {
+    currentPool = this;
+    currentIndex = self;
+
+    Task task;
+    while (true) {
+        if (take(self, task)) {
+            execute(task);
+            continue;
+        }
+
+        unique_lock<mutex> guard(idleLock);
+        if (stopping) {
+            return;
+        }
+        // Recheck under the lock, submit() pushes before it takes idleLock
+        bool queued = false;
+        for (auto &queue : queues) {
+            lock_guard<mutex> queueGuard(queue.lock);
+            if (queue.count != 0) {
+                queued = true;
+                break;
+            }
+        }
+        if (!queued) {
+            wakeUp.wait(guard);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Intervention timeline implementation
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Timeline.cpp
+ * @date 13. 11. 2020
+ */
+#include "headers/Timeline.h"
+#include "headers/Date.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+    const char *const parameterNames[] = { "R0", "alpha", "sigma", "omega" };
+
+    // Days of the Hubei interventions
+    const unsigned long newYear = Date::simulationDay(2020, 1, 23);
+    const unsigned long quarantine = Date::simulationDay(2020, 1, 27);
+    const unsigned long lockdown = Date::simulationDay(2020, 2, 12);
+
+    bool parseChange(const string &text, Timeline::Parameter &parameter, double &value) {
+        size_t eq = text.find('=');
+        if (eq == string::npos) {
+            return false;
+        }
+        string name = text.substr(0, eq), number = text.substr(eq + 1);
+        for (int i = 0; i < 4; i++) {
+            if (name == parameterNames[i]) {
+                char *end = nullptr;
+                parameter = (Timeline::Parameter)i;
+                value = strtod(number.c_str(), &end);
+                return !number.empty() && *end == '\0';
+            }
+        }
+        return false;
+    }
+}
+
+bool Timeline::parseDay(const string &text, unsigned long &day) {
+    int year, month, dayOfMonth;
+    char rest;
+    if (sscanf(text.c_str(), "%d-%d-%d%c", &year, &month, &dayOfMonth, &rest) == 3) {
+        // Simulation starts with the first reported case
+        if (!Date::valid(year, month, dayOfMonth) || Date::simulationDay(year, month, dayOfMonth) < 0) {
+            return false;
+        }
+        day = Date::simulationDay(year, month, dayOfMonth);
+        return true;
+    }
+    char *end = nullptr;
+    day = strtoul(text.c_str(), &end, 10);
+    return !text.empty() && text[0] != '-' && *end == '\0';
+}
+
+int Timeline::load(const string &path) {
+    ifstream input(path);
+    if (!input) {
+        cerr << "Cannot open timeline " << path << endl;
+        return 1;
+    }
+
+    string line;
+    unsigned long number = 0;
+    while (getline(input, line)) {
+        number++;
+        line = line.substr(0, line.find('#'));
+
+        stringstream tokens(line);
+        string when, item;
+        if (!(tokens >> when)) {
+            continue;
+        }
+        unsigned long day;
+        bool ok = parseDay(when, day);
+        bool any = false;
+        while (ok && tokens >> item) {
+            Parameter parameter;
+            double value;
+            ok = parseChange(item, parameter, value);
+            if (ok) {
+                add(day, parameter, value);
+                any = true;
+            }
+        }
+        if (!ok || !any) {
+            cerr << path << ":" << number << ": bad intervention: " << line << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void Timeline::add(unsigned long day, Parameter parameter, double value) {
+    Change change = { day, parameter, value };
+    auto position = upper_bound(changes.begin(), changes.end(), change,
+        [](const Change &a, const Change &b) { return a.day < b.day; });
+    changes.insert(position, change);
+}
+
+Timeline Timeline::hubei(bool restrictions) {
+    Timeline timeline;
+
+    // Chinese new year celebration epidemic spot
+    timeline.add(newYear, R0, 6.6037);
+
+    if (restrictions) {
+        // China province Hubei took drastic government measures in January 27th with all cities quarantined
+        timeline.add(quarantine, R0, 3.7732);
+
+        // Approximately after 12th February Covid19 spreading in Hubei was postponed
+        // due to radical lockdown of the province and large-scale case-screening
+        // Basic reproduction number(R0) according to studies dropped to 0.2020
+        timeline.add(lockdown, R0, 0.2020);
+    }
+    return timeline;
+}
@@ -0,0 +1,147 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Structure-of-arrays batch of SIR/SEIRD trajectories interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file BatchModel.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _BATCH_MODEL_H_
+#define _BATCH_MODEL_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <vector>
+
+#include "Timeline.h"
+
+/**
+ * Many independent trajectories of the Model equations advanced together
+ *
+ * Every compartment, rate and statistic is one contiguous double array with
+ * a slot per trajectory (lane), so a day of all lanes is a few passes of
+ * vector arithmetic. The kernel is picked at runtime: AVX-512, AVX2 or a
+ * portable scalar loop. All lanes share the model type (SIR or SEIRD).
+ */
+class BatchModel {
+public:
+    // Instruction set used by step()
+    enum Kernel { SCALAR, AVX2, AVX512 };
+
+    /**
+     * Creates lanes with the initial state and rates of Model
+     *
+     * @param lanes trajectory count
+     * @param SIERD simulation model of all lanes
+     */
+    BatchModel(std::size_t lanes, bool SIERD);
+
+    /**
+     * Sets COVID19 constants of a lane
+     */
+    void setRates(std::size_t lane, double R0, double alpha, double sigma, double omega);
+
+    /**
+     * Changes basic reproduction number of a lane, transmission follows
+     */
+    void setR0(std::size_t lane, double R0);
+
+    /**
+     * Adds interventions of a lane for simulate(), lanes start without any
+     */
+    void setTimeline(std::size_t lane, const Timeline &timeline);
+
+    /**
+     * Forces a kernel, the best supported one is chosen by default
+     *
+     * @return false if the CPU does not support it
+     */
+    bool setKernel(Kernel kernel);
+
+    /**
+     * @return kernel used by step()
+     */
+    Kernel getKernel() const { return kernel; }
+
+    /**
+     * Tracks statistics of the current day and advances all lanes by a day
+     */
+    void step();
+
+    /**
+     * Advances all lanes, applying their interventions on the way
+     *
+     * @param days number of days of simulation
+     */
+    void simulate(unsigned long days);
+
+    /**
+     * @return trajectory count
+     */
+    std::size_t size() const { return lanes; }
+
+    /**
+     * @return days simulated so far
+     */
+    unsigned long getDay() const { return day; }
+
+    // Per lane values, index by lane
+    const double *getS() const { return S.data(); }
+    const double *getE() const { return E.data(); }
+    const double *getI() const { return I.data(); }
+    const double *getR() const { return R.data(); }
+    const double *getD() const { return D.data(); }
+    const double *getSumInfected() const { return sumInfected.data(); }
+    const double *getSumRecovered() const { return sumRecovered.data(); }
+    const double *getMaxInfected() const { return maxInfected.data(); }
+    const double *getMaxIncrement() const { return maxIncrement.data(); }
+    const double *getDayMaxInfected() const { return dayMaxInfected.data(); }
+    const double *getDayMaxIncrement() const { return dayMaxIncrement.data(); }
+
+    // View of all arrays handed to a kernel, count is a multiple of 8
+    struct Arrays {
+        std::size_t count;
+        double N, day;
+        double *S, *E, *I, *R, *D;
+        double *beta, *alpha, *sigma, *omega;
+        double *derrI, *sumInfected, *sumRecovered;
+        double *maxInfected, *maxIncrement, *dayMaxInfected, *dayMaxIncrement;
+    };
+
+private:
+    // Population of chinese province Hubei
+    double N = 58500000.0;
+
+    std::size_t lanes/* Trajectory count */;
+    bool SIERD/* Simulation model */;
+    Kernel kernel = SCALAR;
+    unsigned long day = 0;
+
+    // Compartments, padded with empty lanes to a multiple of the vector width
+    std::vector<double> S, E, I, R, D;
+
+    // Rates
+    std::vector<double> R0, beta, alpha, sigma, omega;
+
+    // Interventions of all lanes merged by day
+    struct LaneChange {
+        unsigned long day;
+        std::size_t lane;
+        Timeline::Parameter parameter;
+        double value;
+    };
+    std::vector<LaneChange> schedule;
+    std::size_t pending = 0/* First change not applied yet */;
+
+    // Statistics, days are kept as double to stay in vector registers
+    std::vector<double> derrI, sumInfected, sumRecovered;
+    std::vector<double> maxInfected, maxIncrement, dayMaxInfected, dayMaxIncrement;
+
+    Arrays arrays();
+};
+
+#endif //_BATCH_MODEL_H_
@@ -0,0 +1,148 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Fitting of Model rates to observed case data interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Calibration.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _CALIBRATION_H_
+#define _CALIBRATION_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Model.h"
+#include "optimize.h"
+#include "Timeline.h"
+
+/**
+ * Finds rates of an experiment that reproduce observed cases
+ *
+ * A fitted parameter is a rate together with the day it takes effect: day 0
+ * is the initial value, a later day is an intervention, so the R0 of every
+ * stage of the Hubei timeline is one parameter. The loss of a point is
+ *
+ *     mean over observations of (ln(1 + model) - ln(1 + observed))^2
+ *
+ * over the cumulative infected (Isum) and the currently infected (I) where
+ * observed. Every evaluation simulates a fresh Model inside the process.
+ *
+ * Methods:
+ *  - NELDER_MEAD: downhill simplex; the initial simplex, the shrink and the
+ *    four trial points of an iteration (reflection, expansion, outside and
+ *    inside contraction) are evaluated concurrently on the thread pool
+ *  - HOOKE, SIMANN: SIMLIB Optimize_hooke and Optimize_simann, which ask for
+ *    one point at a time and therefore evaluate sequentially; they share the
+ *    global state of SIMLIB, so fits by these methods called from several
+ *    threads run one after another
+ *
+ * Case file: CSV with a header naming the columns, "date" (YYYY-MM-DD) or
+ * "day", then "cumulative" and/or "infected"; other columns are ignored and
+ * empty cells are missing observations.
+ *
+ * Parameter file, one parameter per line, '#' starts a comment:
+ *
+ *     <when> <R0|alpha|sigma|omega> <min> <max> [<start>]
+ */
+class Calibration {
+public:
+    // Optimization method
+    enum Method { NELDER_MEAD, HOOKE, SIMANN };
+
+    // Observed values of a day, NaN if not observed
+    struct Observation {
+        unsigned long day;
+        double cumulative, infected;
+    };
+
+    /**
+     * @param experiment simulation model (1-4) whose rates are fitted
+     */
+    explicit Calibration(int experiment);
+
+    /**
+     * Appends observations from a case file
+     *
+     * @return 0 if OK
+     */
+    int loadCases(const std::string &path);
+
+    void addObservation(unsigned long day, double cumulative, double infected);
+
+    /**
+     * Appends fitted parameters from a parameter file
+     *
+     * @return 0 if OK
+     */
+    int loadParameters(const std::string &path);
+
+    /**
+     * Adds a fitted rate starting at a day, the start defaults to the middle of the range
+     */
+    void addParameter(unsigned long day, Timeline::Parameter parameter, double min, double max, double start);
+
+    /**
+     * R0 of the initial day and of every stage of the experiment timeline
+     */
+    void addHubeiParameters();
+
+    /**
+     * Simulates the experiment with parameter values
+     *
+     * @return loss against the observations, safe to call from several threads
+     */
+    double loss(const simlib3::ParameterVector &values) const;
+
+    /**
+     * Minimizes the loss, the parameters end up with the best values found
+     *
+     * Safe to call from several threads, HOOKE and SIMANN fits are serialized.
+     *
+     * @param threads workers of the concurrent evaluations, 0 means one per hardware thread
+     * @param iterations iteration limit (temperature steps of SIMANN)
+     * @return best loss
+     */
+    double fit(Method method, unsigned threads = 0, int iterations = 500);
+
+    /**
+     * @return fitted parameters with their current values
+     */
+    simlib3::ParameterVector getParameters() const;
+
+    /**
+     * @return experiment timeline with the given parameter values
+     */
+    Timeline timeline(const simlib3::ParameterVector &values) const;
+
+    /**
+     * @return experiment setup with the given parameter values, initial rates and timeline
+     */
+    Model::Parameters modelParameters(const simlib3::ParameterVector &values) const;
+
+    std::size_t getEvaluations() const { return evaluations; }
+
+private:
+    struct Fitted {
+        unsigned long day;
+        Timeline::Parameter parameter;
+        double min, max, value;
+    };
+
+    int experiment;
+    std::vector<Observation> observations;
+    std::vector<Fitted> fitted;
+    std::deque<std::string> names/* Storage of the parameter names, Param keeps pointers */;
+    std::size_t evaluations = 0;
+
+    double nelderMead(simlib3::ParameterVector &values, unsigned threads, int iterations);
+};
+
+#endif //_CALIBRATION_H_
@@ -0,0 +1,171 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Compartment graph engine interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://en.wikipedia.org/wiki/Compartmental_models_in_epidemiology
+ * @file Compartments.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _COMPARTMENTS_H_
+#define _COMPARTMENTS_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Compartment model declared as compartments, parameters and flows
+ *
+ * Every flow moves people from one compartment to another with the rate
+ *
+ *     parameter * from                  (linear, e.g. recovery)
+ *     parameter * from * contact / N    (mass action, e.g. transmission)
+ *
+ * On the first step the declaration is compiled into a flat transition
+ * table. A step is forward Euler over one day: all fluxes are evaluated from
+ * the current state, each clamped to its source compartment, and then
+ * applied in declaration order. Linear flows multiply by a constant one slot
+ * and divide by one, so every flow runs the same branch-free expression.
+ *
+ * Text declaration, one item per line, '#' starts a comment:
+ *
+ *     population <N>
+ *     compartment <name> <initial count | rest>
+ *     parameter <name> <value>
+ *     flow <from> -> <to> : <parameter> * <from> [* <contact> / N]
+ *
+ * "rest" gives a compartment the population left after all others.
+ *
+ * @tparam T arithmetic type of state and parameters
+ */
+template<typename T>
+class CompartmentModel {
+public:
+    // Declared flow
+    struct Flow {
+        int from, to, parameter, contact/* -1 for linear flows */;
+    };
+
+    /**
+     * @param N whole population, divisor of mass action flows
+     */
+    explicit CompartmentModel(T N = 0);
+
+    /**
+     * Reads a text declaration
+     *
+     * @param path declaration file
+     * @return 0 if OK
+     */
+    int load(const std::string &path);
+
+    /**
+     * @return index of the new compartment
+     */
+    int addCompartment(const std::string &name, T initial);
+
+    /**
+     * @return index of the new parameter
+     */
+    int addParameter(const std::string &name, T value);
+
+    /**
+     * Adds a flow between compartments
+     *
+     * @param from source compartment
+     * @param to target compartment
+     * @param parameter rate parameter
+     * @param contact infectious compartment of a mass action flow, empty for a linear one
+     * @return index of the new flow, -1 if a name is unknown
+     */
+    int addFlow(const std::string &from, const std::string &to, const std::string &parameter, const std::string &contact = "");
+
+    /**
+     * Advances the model by one day
+     */
+    void step();
+
+    /**
+     * @return index of a compartment, -1 if there is no such compartment
+     */
+    int compartment(const std::string &name) const;
+
+    /**
+     * @return index of a parameter, -1 if there is no such parameter
+     */
+    int parameter(const std::string &name) const;
+
+    /**
+     * @return index of the first flow between the compartments, -1 if there is none
+     */
+    int flow(const std::string &from, const std::string &to) const;
+
+    T getPopulation() const { return N; }
+    void setPopulation(T N) {
+        this->N = N;
+        compiled = false;
+    }
+
+    std::size_t compartments() const { return names.size(); }
+    const std::vector<std::string> &getNames() const { return names; }
+
+    /**
+     * @return declared flows, index by flow
+     */
+    const std::vector<Flow> &getFlows() const { return flows; }
+
+    /**
+     * @return current values of all compartments, index by compartment
+     */
+    const T *getState() const { return state.data(); }
+
+    T get(int compartment) const { return state[compartment]; }
+    void set(int compartment, T value) { state[compartment] = value; }
+
+    T getParameter(int parameter) const { return parameters[parameter]; }
+    void setParameter(int parameter, T value) { parameters[parameter] = value; }
+
+    /**
+     * @return people moved by a flow so far, plus the value set by setCumulative()
+     */
+    T getCumulative(int flow) const { return cumulative[flow]; }
+    void setCumulative(int flow, T value) { cumulative[flow] = value; }
+
+    /**
+     * SIR model of Model: S -> I -> R
+     */
+    static CompartmentModel sir(T N, T infected, T exposed);
+
+    /**
+     * SEIRD model of Model: S -> E -> I -> R, I -> D
+     */
+    static CompartmentModel seird(T N, T infected, T exposed);
+
+private:
+    T N/* Whole population */;
+    std::vector<std::string> names, parameterNames;
+    std::vector<Flow> flows;
+
+    // Compartment values followed by the constant one slot
+    std::vector<T> state;
+    std::vector<T> parameters;
+    std::vector<T> cumulative;
+
+    // Compiled transition table, one entry per flow
+    bool compiled = false;
+    std::vector<int> from, to, rate, factor;
+    std::vector<T> divisor, flux, delta;
+
+    /**
+     * Builds the transition table from the declared flows
+     */
+    void compile();
+};
+
+#endif //_COMPARTMENTS_H_
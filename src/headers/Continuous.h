@@ -0,0 +1,140 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Continuous-time SIR/SEIRD model on SIMLIB integrators interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Continuous.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _CONTINUOUS_H_
+#define _CONTINUOUS_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Model.h"
+#include "Output.h"
+#include "Snapshot.h"
+#include "Span.h"
+
+/**
+ * The SIR/SEIRD equations of Model as ordinary differential equations
+ *
+ *     S' = -beta * S * I / N
+ *     E' =  beta * S * I / N - sigma * E
+ *     I' =  sigma * E - (alpha + omega) * I    (SIR: beta * S * I / N - alpha * I)
+ *     R' =  alpha * I
+ *     D' =  omega * I
+ *
+ * solved by SIMLIB Integrator blocks with the step control of the chosen
+ * method, while Model takes one forward Euler step per day. A Sampler
+ * applies the interventions of a day and records the state once a day,
+ * integration steps always end on days because of it.
+ *
+ * SIMLIB keeps the simulator in global variables: runs of all instances are
+ * serialized, a model is reentrant but not concurrent. Between runs the
+ * state lives in the model, so advance() continues where the last run
+ * stopped and a snapshot restores it in a fresh simulation of SIMLIB.
+ */
+class ContinuousModel {
+public:
+    // SIMLIB integration method
+    enum Method { RKF5, RKF8, EULER };
+
+    explicit ContinuousModel(const Model::Parameters &parameters);
+
+    /**
+     * @param method RKF5 and RKF8 adapt the step to the accuracy, EULER keeps the largest step
+     */
+    void setMethod(Method method) { this->method = method; }
+
+    /**
+     * Error allowed per step of the adaptive methods
+     *
+     * @param relative tolerance relative to the compartment value
+     * @param absolute tolerance in people
+     */
+    void setAccuracy(double relative, double absolute = 1e-6);
+
+    /**
+     * Bounds of the integration step in days
+     */
+    void setStep(double min, double max);
+
+    /**
+     * Starts again from the initial state of day 0
+     */
+    void reset();
+
+    /**
+     * Integrates from the current day, writes the state at the start of every
+     * day followed by Isum and Rsum as the data file of Model, values are not rounded
+     *
+     * @param day day reached
+     * @param sink trajectory output, nullptr keeps only the statistics and the state
+     * @return 0 if OK
+     */
+    int advance(unsigned long day, TrajectorySink *sink = nullptr);
+
+    /**
+     * Integrates from day 0
+     *
+     * @param days number of days of simulation
+     * @return 0 if OK
+     */
+    int simulate(unsigned long days, TrajectorySink *sink = nullptr);
+
+    /**
+     * Appends the integrator values, rates, statistics and day
+     */
+    void save(Snapshot &snapshot) const;
+
+    /**
+     * Continues from a snapshot of a model with the same compartments,
+     * interventions of the restored day and later come from the own timeline
+     *
+     * @return 0 if OK, 1 if the snapshot is of another model and nothing changed
+     */
+    int restore(Snapshot &snapshot);
+
+    unsigned long getDay() const { return today; }
+
+    /**
+     * @return compartments of the current day, index by getNames()
+     */
+    Span<const double> getState() const { return Span<const double>(state.data(), state.size()); }
+    const std::vector<std::string> &getNames() const { return names; }
+
+    /**
+     * @return statistics of the simulated days, sampled daily as in Model
+     */
+    const Model::Stats &getStats() const { return stats; }
+
+    /**
+     * @return integration steps of the last simulation
+     */
+    long getSteps() const { return steps; }
+
+private:
+    Model::Parameters parameters;
+    Method method = RKF5;
+    double relative = 1e-6, absolute = 1e-6;
+    double minStep = 1e-6, maxStep = 1.0;
+
+    std::vector<std::string> names;
+    std::vector<double> state;
+    Model::Rates rates/* Rates with the interventions applied so far */;
+    std::size_t pending = 0/* First change of the timeline not applied yet */;
+    unsigned long today = 0;
+    double previousI = 0.0/* Infected of the previous day */;
+    Model::Stats stats;
+    long steps = 0;
+};
+
+#endif //_CONTINUOUS_H_
@@ -0,0 +1,64 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Day numbers of the proleptic Gregorian calendar
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://howardhinnant.github.io/date_algorithms.html#days_from_civil
+ * @file Date.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _DATE_H_
+#define _DATE_H_
+
+/**
+ * Dates as day numbers, all constexpr so fixed dates become constants at
+ * compile time and a simulation only ever compares day indices
+ *
+ * The calendar is proleptic Gregorian: leap years every fourth year except
+ * centuries not divisible by 400, extended to years before 1582.
+ */
+namespace Date {
+    constexpr bool leap(long year) {
+        return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    }
+
+    constexpr unsigned daysInMonth(long year, unsigned month) {
+        return month == 2 ? (leap(year) ? 29 : 28) : (month == 4 || month == 6 || month == 9 || month == 11 ? 30 : 31);
+    }
+
+    constexpr bool valid(long year, unsigned month, unsigned day) {
+        return month >= 1 && month <= 12 && day >= 1 && day <= daysInMonth(year, month);
+    }
+
+    // Steps of number(), a year starting with March puts the leap day last
+    constexpr long era(long year) { return (year >= 0 ? year : year - 399) / 400; }
+    constexpr long dayOfYear(unsigned month, unsigned day) { return (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; }
+    constexpr long dayOfEra(long yearOfEra, long dayOfYear) { return yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear; }
+    constexpr long fromMarch(long year, unsigned month, unsigned day) {
+        return era(year) * 146097 + dayOfEra(year - era(year) * 400, dayOfYear(month, day)) - 719468;
+    }
+
+    /**
+     * @return days since 1.1.1970, negative before
+     */
+    constexpr long number(long year, unsigned month, unsigned day) {
+        return fromMarch(year - (month <= 2 ? 1 : 0), month, day);
+    }
+
+    // First reported case in chinese province Hubei, day 0 of the simulations
+    constexpr long firstCase = number(2019, 12, 31);
+
+    /**
+     * @return day index of a date counted from the first reported case
+     */
+    constexpr long simulationDay(long year, unsigned month, unsigned day) {
+        return number(year, month, day) - firstCase;
+    }
+
+    // Days simulated by the experiments, until 7.12.2020
+    constexpr unsigned long reportDays = simulationDay(2020, 12, 7);
+}
+
+#endif //_DATE_H_
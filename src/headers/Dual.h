@@ -0,0 +1,116 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Forward-mode automatic differentiation number
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://en.wikipedia.org/wiki/Automatic_differentiation#Automatic_differentiation_using_dual_numbers
+ * @file Dual.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _DUAL_H_
+#define _DUAL_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * Value with its derivatives by N independent inputs (tangents)
+ *
+ * Arithmetic applies the chain rule to all tangents at once, the tangent
+ * loops have a length known at compile time and vectorize, so one run of a
+ * model on Dual<N> gives the derivatives of every result by N inputs.
+ * A plain number converts to a constant with zero tangents, comparisons
+ * look at the value only.
+ *
+ * round() keeps the tangents: the models round only what they report, so the
+ * derivative of a rounded result is the one of the value before rounding.
+ */
+template<std::size_t N>
+class Dual {
+public:
+    double value = 0.0;
+    double tangent[N] = {}/* Derivative by each input */;
+
+    Dual() {}
+    Dual(double value) : value(value) {}
+
+    /**
+     * @param index input the value is, its tangent is one and the others zero
+     */
+    static Dual variable(double value, std::size_t index) {
+        Dual result(value);
+        result.tangent[index] = 1.0;
+        return result;
+    }
+
+    explicit operator double() const { return value; }
+
+    Dual &operator+=(const Dual &other) {
+        value += other.value;
+        for (std::size_t i = 0; i < N; i++) {
+            tangent[i] += other.tangent[i];
+        }
+        return *this;
+    }
+
+    Dual &operator-=(const Dual &other) {
+        value -= other.value;
+        for (std::size_t i = 0; i < N; i++) {
+            tangent[i] -= other.tangent[i];
+        }
+        return *this;
+    }
+
+    Dual &operator*=(const Dual &other) {
+        for (std::size_t i = 0; i < N; i++) {
+            tangent[i] = tangent[i] * other.value + value * other.tangent[i];
+        }
+        value *= other.value;
+        return *this;
+    }
+
+    Dual &operator/=(const Dual &other) {
+        // (a / b)' = (a' - (a / b) * b') / b
+        value /= other.value;
+        const double inverse = 1.0 / other.value;
+        for (std::size_t i = 0; i < N; i++) {
+            tangent[i] = (tangent[i] - value * other.tangent[i]) * inverse;
+        }
+        return *this;
+    }
+
+    friend Dual operator+(Dual a, const Dual &b) { return a += b; }
+    friend Dual operator-(Dual a, const Dual &b) { return a -= b; }
+    friend Dual operator*(Dual a, const Dual &b) { return a *= b; }
+    friend Dual operator/(Dual a, const Dual &b) { return a /= b; }
+
+    friend Dual operator-(Dual a) {
+        a.value = -a.value;
+        for (std::size_t i = 0; i < N; i++) {
+            a.tangent[i] = -a.tangent[i];
+        }
+        return a;
+    }
+
+    friend bool operator<(const Dual &a, const Dual &b) { return a.value < b.value; }
+    friend bool operator>(const Dual &a, const Dual &b) { return a.value > b.value; }
+    friend bool operator<=(const Dual &a, const Dual &b) { return a.value <= b.value; }
+    friend bool operator>=(const Dual &a, const Dual &b) { return a.value >= b.value; }
+    friend bool operator==(const Dual &a, const Dual &b) { return a.value == b.value; }
+    friend bool operator!=(const Dual &a, const Dual &b) { return a.value != b.value; }
+
+    friend Dual round(Dual a) {
+        a.value = std::round(a.value);
+        return a;
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const Dual &a) { return out << a.value; }
+};
+
+#endif //_DUAL_H_
@@ -0,0 +1,150 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Stochastic SIR/SEIRD ensemble interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://en.wikipedia.org/wiki/Reed%E2%80%93Frost_model
+ * @file Ensemble.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _ENSEMBLE_H_
+#define _ENSEMBLE_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Output.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include "Timeline.h"
+
+/**
+ * Replicates of the Model equations with whole people moving at random
+ *
+ * Chain binomial: each of the X people of a compartment leaves it during a
+ * day with probability 1 - exp(-rate), so the daily transitions are binomial
+ * draws; people leaving infected split between recovery and death by a
+ * second draw. Tau leaping: transitions are Poisson draws with the Model
+ * flux as mean, clamped to the people present.
+ *
+ * All replicates advance a day together, split among the workers, each with
+ * its own random stream keyed by the seed and the replicate index. After
+ * every day the 5 %, 50 % and 95 % quantiles of each compartment over the
+ * replicates are written to the sink, so memory stays proportional to the
+ * replicate count whatever the number of days.
+ */
+class Ensemble {
+public:
+    // Transition sampling
+    enum Method { CHAIN_BINOMIAL, TAU_LEAP };
+
+    /**
+     * Creates replicates with the initial state and rates of Model
+     *
+     * @param replicates replicate count
+     * @param SIERD simulation model
+     */
+    Ensemble(std::size_t replicates, bool SIERD);
+
+    /**
+     * Sets COVID19 constants of all replicates
+     */
+    void setRates(double R0, double alpha, double sigma, double omega);
+
+    /**
+     * Sets interventions applied by simulate()
+     */
+    void setTimeline(const Timeline &timeline);
+
+    void setMethod(Method method) { this->method = method; }
+
+    /**
+     * Restarts all replicates with streams of a new seed
+     */
+    void setSeed(std::uint64_t seed);
+
+    /**
+     * Sets worker count of the following steps
+     *
+     * @param threads 0 means one per hardware thread, 1 runs on the calling thread
+     */
+    void setThreads(unsigned threads);
+
+    /**
+     * Writes daily quantiles, columns <compartment>_q05, _q50 and _q95
+     */
+    void setSink(std::unique_ptr<TrajectorySink> sink);
+
+    /**
+     * Advances all replicates by a day
+     */
+    void step();
+
+    /**
+     * Advances all replicates, applying the interventions on the way
+     *
+     * @param days number of days of simulation
+     * @return 0 if OK
+     */
+    int simulate(unsigned long days);
+
+    /**
+     * @return value below which lies the fraction q of the replicates (nearest rank)
+     */
+    double quantile(const std::uint64_t *values, double q);
+
+    std::size_t size() const { return replicates; }
+    unsigned long getDay() const { return day; }
+
+    // Per replicate values, index by replicate
+    const std::uint64_t *getS() const { return S.data(); }
+    const std::uint64_t *getE() const { return E.data(); }
+    const std::uint64_t *getI() const { return I.data(); }
+    const std::uint64_t *getR() const { return R.data(); }
+    const std::uint64_t *getD() const { return D.data(); }
+    const std::uint64_t *getSumInfected() const { return sumInfected.data(); }
+
+private:
+    // Population of chinese province Hubei and case 0 with the exposed
+    std::uint64_t N = 58500000, initialE = 27 * 20, initialI = 27;
+
+    std::size_t replicates;
+    bool SIERD/* Simulation model */;
+    Method method = CHAIN_BINOMIAL;
+    std::uint64_t seed = 0;
+    unsigned long day = 0;
+
+    // Compartments of the replicates
+    std::vector<std::uint64_t> S, E, I, R, D, sumInfected;
+    std::vector<RandomStream> streams;
+
+    // Constants typical for COVID19, beta = alpha * R0
+    double R0 = 5.6015, alpha = 0.0556, beta = 0.0556 * 5.6015, sigma = 0.1923, omega = 0.0034;
+
+    Timeline timeline;
+    std::size_t pending = 0/* First change not applied yet */;
+
+    unsigned threads = 0;
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<TrajectorySink> sink;
+    std::vector<double> scratch/* Values of a day being ranked */, row;
+
+    /**
+     * Advances replicates [begin, end)
+     */
+    void stepReplicates(std::size_t begin, std::size_t end);
+
+    /**
+     * Writes quantiles of the current day to the sink
+     */
+    void writeQuantiles();
+};
+
+#endif //_ENSEMBLE_H_
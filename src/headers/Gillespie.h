@@ -0,0 +1,124 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Exact stochastic simulation of compartment models interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://en.wikipedia.org/wiki/Gillespie_algorithm
+ * @file Gillespie.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _GILLESPIE_H_
+#define _GILLESPIE_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Compartments.h"
+#include "Output.h"
+#include "Random.h"
+
+/**
+ * Gillespie stochastic simulation algorithm over a compartment declaration
+ *
+ * Every flow is a reaction moving one person with the propensity
+ *
+ *     parameter * from                  (linear)
+ *     parameter * from * contact / N    (mass action)
+ *
+ * Direct method: the time to the next event is exponential with the total
+ * propensity, the reaction is picked proportionally to its propensity.
+ * Next reaction method (Gibson & Bruck): every reaction keeps an absolute
+ * firing time in an indexed binary heap and times of affected reactions are
+ * rescaled instead of drawn again, so an event costs one random number.
+ *
+ * Either way only the propensities of reactions reading a compartment the
+ * fired reaction changed are recomputed (dependency graph), the total of the
+ * direct method is updated by the differences.
+ */
+class Gillespie {
+public:
+    // Algorithm used by advance()
+    enum Method { DIRECT, NEXT_REACTION };
+
+    /**
+     * Takes compartments, parameters and flows of a model, counts are rounded
+     *
+     * @param model declaration with the initial state
+     * @param seed random stream of the run
+     */
+    explicit Gillespie(const CompartmentModel<double> &model, std::uint64_t seed = 0, Method method = NEXT_REACTION);
+
+    /**
+     * Fires reactions until the time reaches the limit or no reaction can fire
+     *
+     * @param until end of the interval in days
+     * @return events fired
+     */
+    std::uint64_t advance(double until);
+
+    /**
+     * Writes the state at the start of every day and advances day by day
+     *
+     * @param days number of days of simulation
+     * @return 0 if OK
+     */
+    int simulate(unsigned long days, TrajectorySink &sink);
+
+    double getTime() const { return time; }
+    std::uint64_t getEvents() const { return events; }
+    std::size_t compartments() const { return state.size(); }
+    std::int64_t get(int compartment) const { return state[compartment]; }
+
+    /**
+     * @return largest difference between a kept propensity and a fresh evaluation
+     */
+    double propensityError() const;
+
+private:
+    struct Reaction {
+        int from, to, contact/* -1 for linear flows */;
+        double rate/* Parameter, divided by N for mass action */;
+    };
+
+    Method method;
+    RandomStream random;
+    double time = 0.0;
+    std::uint64_t events = 0;
+
+    std::vector<std::string> names;
+    std::vector<std::int64_t> state;
+    std::vector<Reaction> reactions;
+    std::vector<double> propensity;
+    double total = 0.0/* Sum of propensities, direct method */;
+
+    // Reactions to update after a reaction fired, CSR by fired reaction
+    std::vector<std::size_t> dependentStart;
+    std::vector<int> dependents;
+
+    // Indexed min heap of firing times, next reaction method
+    std::vector<double> firing/* Absolute firing time by reaction */;
+    std::vector<int> heap/* Reactions ordered by firing time */;
+    std::vector<std::size_t> position/* Heap slot by reaction */;
+
+    double evaluate(int reaction) const;
+    double exponential() { return -std::log(random.uniform()); }
+
+    void buildDependencies();
+    void fire(int reaction);
+    bool stepDirect(double until);
+    bool stepNextReaction(double until);
+
+    void heapUpdate(int reaction, double time);
+    void siftUp(std::size_t slot);
+    void siftDown(std::size_t slot);
+};
+
+#endif //_GILLESPIE_H_
@@ -0,0 +1,193 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Region and age stratified SEIRD metapopulation interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://en.wikipedia.org/wiki/Metapopulation
+ * @file Metapopulation.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _METAPOPULATION_H_
+#define _METAPOPULATION_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Output.h"
+#include "ThreadPool.h"
+#include "Timeline.h"
+
+/**
+ * SEIRD compartments of Model in every patch, a patch being one age group
+ * of one region (patch = region * groups + group)
+ *
+ * Patches only meet through the contact matrix C: a susceptible of patch i
+ * is infected at the rate
+ *
+ *     beta * sum_j C[i][j] * I[j] / N[j]
+ *
+ * where C[i][j] is the relative number of daily contacts of a person of
+ * patch i with people of patch j (mobility times age mixing) and N[j] is the
+ * population of patch j. Transmission is beta = alpha * R0 as in Model.
+ *
+ * Contacts are added as triplets and compiled into CSR rows. The division
+ * by N[j] is done once per patch and day (prevalence), so the force of
+ * infection is a sparse matrix times the prevalence vector with 32-bit
+ * column indices streamed row by row. Each day is a single pass over
+ * the rows split among the workers: a row reads the infected of the
+ * previous day and writes only its own patch, so the result does not depend
+ * on the thread count.
+ *
+ * Contact file, one entry per line, '#' starts a comment, entries of the
+ * same pair add up:
+ *
+ *     <region> <group> <contact region> <contact group> <contacts>
+ */
+class Metapopulation {
+public:
+    /**
+     * Creates empty patches with the COVID19 constants of Model
+     *
+     * @param regions region count
+     * @param groups age groups per region
+     */
+    Metapopulation(std::size_t regions, std::size_t groups);
+
+    /**
+     * @return patch of an age group in a region
+     */
+    std::size_t patch(std::size_t region, std::size_t group) const { return region * groups + group; }
+
+    /**
+     * Sets the population of a patch, everyone not exposed or infected is susceptible
+     */
+    void setPopulation(std::size_t patch, double N, double exposed = 0.0, double infected = 0.0);
+
+    /**
+     * Adds contacts of patch row with patch column
+     */
+    void addContact(std::size_t row, std::size_t column, double contacts);
+
+    /**
+     * Appends contacts from a file
+     *
+     * @param path contact file
+     * @return 0 if OK
+     */
+    int loadContacts(const std::string &path);
+
+    /**
+     * Sets COVID19 constants shared by all patches
+     */
+    void setRates(double R0, double alpha, double sigma, double omega);
+
+    /**
+     * Sets interventions applied by simulate(), R0 changes scale all contacts
+     */
+    void setTimeline(const Timeline &timeline);
+
+    /**
+     * Sets worker count of the following steps
+     *
+     * @param threads 0 means one per hardware thread, 1 runs on the calling thread
+     */
+    void setThreads(unsigned threads);
+
+    /**
+     * Writes totals of all patches for every simulated day
+     */
+    void setSink(std::unique_ptr<TrajectorySink> sink);
+
+    /**
+     * Advances all patches by a day
+     */
+    void step();
+
+    /**
+     * Advances all patches, applying the interventions on the way
+     *
+     * @param days number of days of simulation
+     * @return 0 if OK
+     */
+    int simulate(unsigned long days);
+
+    std::size_t patches() const { return S.size(); }
+    std::size_t getRegions() const { return regions; }
+    std::size_t getGroups() const { return groups; }
+
+    /**
+     * @return stored contacts after merging duplicates
+     */
+    std::size_t nonZeros();
+
+    /**
+     * @return days simulated so far
+     */
+    unsigned long getDay() const { return day; }
+
+    // Per patch values, index by patch
+    const double *getS() const { return S.data(); }
+    const double *getE() const { return E.data(); }
+    const double *getI() const { return I.data(); }
+    const double *getR() const { return R.data(); }
+    const double *getD() const { return D.data(); }
+    const double *getSumInfected() const { return sumInfected.data(); }
+
+private:
+    std::size_t regions, groups;
+
+    // Compartments and population of the patches
+    std::vector<double> S, E, I, R, D, N, sumInfected;
+
+    // Prevalence I / N of every patch, read by the rows while the next one is written
+    std::vector<double> prevalence, nextPrevalence;
+
+    // Constants typical for COVID19, beta = alpha * R0
+    double R0 = 5.6015, alpha = 0.0556, beta = 0.0556 * 5.6015, sigma = 0.1923, omega = 0.0034;
+
+    // Contacts not compiled yet
+    struct Entry {
+        std::uint32_t row, column;
+        double contacts;
+    };
+    std::vector<Entry> entries;
+
+    // Compressed sparse rows of C
+    bool compiled = false;
+    std::vector<std::size_t> rowStart;
+    std::vector<std::uint32_t> columns;
+    std::vector<double> weights;
+
+    Timeline timeline;
+    std::size_t pending = 0/* First change not applied yet */;
+    unsigned long day = 0;
+
+    unsigned threads = 0;
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<TrajectorySink> sink;
+
+    /**
+     * Builds the CSR matrix from the entries
+     */
+    void compile();
+
+    /**
+     * Advances patches [begin, end)
+     */
+    void stepRows(std::size_t begin, std::size_t end);
+
+    /**
+     * Writes totals of the current day to the sink
+     */
+    void writeTotals();
+};
+
+#endif //_METAPOPULATION_H_
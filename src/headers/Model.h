@@ -15,48 +15,46 @@
 /**
  * Include of libraries (C/C++)
  */
-#include <iostream>
+#include <cstddef>
+#include <memory>
 #include <string>
-#include <fstream>
-#include <cstring>
-#include <cstdlib>
-#include <cmath>
+#include <vector>
+
+#include "Compartments.h"
+#include "Date.h"
+#include "Dual.h"
+#include "Output.h"
+#include "Snapshot.h"
+#include "Span.h"
+#include "Timeline.h"
 
 /**
  * Simulation model interface
+ *
+ * A model is built from Parameters and advanced day by day with step() or
+ * runTo(), the state and the statistics are read directly from the model.
+ * Nothing is printed or written unless an Observer does it, so any number
+ * of models can run in one process and every model on its own thread.
+ *
+ * performExp() is the command line driver of the Hubei experiments: it
+ * reports to stdout and writes the data file through its own observers.
+ *
+ * @tparam T arithmetic type of state, rates and statistics: double is the
+ *           fast default, long double the 80-bit reference, float the fastest,
+ *           Dual<4> gives derivatives by four seeded inputs in one run
  */
-class Model {
-private:
-    // Population of chinese province Hubei
-    long double N = 58500000.0;/* Whole population: N = S + I + R (+ E + D) */
-
-    // Current values
-    struct curr {
-        long double
-            S = 0.0/* Susceptible */,
-            // estimated by scientific paper of Mr.Wang the initial
-            // number of exposed is 20 times greater than the number infected
-            E = 27 * 20.0/* Exposed */,
-            I = 27.0/* Infected, case 0 */,
-            R = 0.0/* Removed */,
-            D = 0.0/* Dead */;
-    } curr;
-
-    // Next values
-    struct next {
-        long double
-            S = 0.0/* Susceptible */,
-            // Estimated by scientific paper of Mr.Wang the initial
-            // number of exposed is 20 times greater than the number infected
-            E = 27 * 20.0/* Exposed */,
-            I = 27.0/* Infected, case 0 */,
-            R = 0.0/* Removed */,
-            D = 0.0/* Dead */;
-    } next;
+template<typename T>
+class BasicModel {
+public:
+    // Statistical values of a simulation
+    struct Stats {
+        T maxInfected = 0.0, maxIncrement = 0.0, sumInfected = 0.0, sumRecovered = 0.0;
+        unsigned long dayMaxInfected = 0, dayMaxIncrement = 0;
+    };
 
     // Constants typical for COVID19
-    struct rates {
-        long double
+    struct Rates {
+        T
             R0 = 5.6015,/* Basic reproduction number of disease */
 
             // hospitalization period^(-1) -> hospitalization period was estimated as 18 days
@@ -69,85 +67,260 @@ private:
             sigma = 0.1923/* Infectivity: exposed person becomes infective */,
 
             omega = 0.0034/* Fatality: infected person dies */;
-    } rates;
+    };
+
+    // Everything a simulation starts from
+    struct Parameters {
+        bool SIERD = false/* Simulation model */;
+        bool restrictions = false/* Government measures, only reported, the timeline applies them */;
+
+        // Population of chinese province Hubei
+        T N = 58500000.0;/* Whole population: N = S + I + R (+ E + D) */
+
+        // Initial values
+        T
+            // estimated by scientific paper of Mr.Wang the initial
+            // number of exposed is 20 times greater than the number infected
+            E = 27 * 20.0/* Exposed */,
+            I = 27.0/* Infected, case 0 */;
+
+        Rates rates/* Initial rates */;
+        Timeline timeline/* Interventions changing the rates */;
+
+        /**
+         * Setup of a Hubei experiment
+         *
+         * @param num experiment number (1-4): SIR, SIR with measures, SIERD, SIERD with measures
+         */
+        static Parameters experiment(int num);
+    };
+
+    /**
+     * Receiver of simulation progress, every callback does nothing by default
+     */
+    class Observer {
+    public:
+        virtual ~Observer() {}
+
+        /**
+         * runTo() starts, the state is the one of the current day
+         */
+        virtual void started(const BasicModel &model, unsigned long until) {}
+
+        /**
+         * A day starts: interventions of the day are applied and the state is not advanced yet
+         */
+        virtual void day(const BasicModel &model) {}
+
+        /**
+         * runTo() reached its day
+         */
+        virtual void finished(const BasicModel &model) {}
+    };
+
+private:
+    Parameters parameters;
+
+    // Compartments and flows of the simulated model (SIR or SEIRD)
+    CompartmentModel<T> graph;
+
+    // Indices into graph, -1 if the model has no such item
+    struct index {
+        int S = -1, E = -1, I = -1, R = -1, D = -1/* Compartments */;
+        int infection = -1, recovery = -1/* Flows */;
+        int beta = -1, alpha = -1, sigma = -1, omega = -1/* Parameters */;
+    } index;
+
+    Rates rates/* Current rates */;
 
     // Statistical values we are going to track
-    struct stats {
-        long double maxInfected = 0.0, maxIncrement = 0.0, sumInfected = 0.0, sumRecovered = 0.0;
-        unsigned long dayMaxInfected = 0, dayMaxIncrement = 0;
-    } stats;
+    Stats stats;
 
     // Daily change of infected people
-    long double derrI = 0.0/* Infected*/;
+    T derrI = 0.0/* Infected*/;
+
+    unsigned long today = 0/* Day the next step simulates */;
+    std::size_t pending = 0/* First change of the timeline not applied yet */;
+    std::vector<Observer *> observers;
 
-    bool SIERD = false/* Simulation model */;
+    // Command line experiments
     unsigned long days = 0;/* Number of days of simulation */
-    bool restrictions = false;/* Government measures */
-    std::ofstream output/* Data file */;
+    bool customTimeline = false;/* Timeline set by setTimeline() */
+    bool verbose = true;/* Print header and footer to stdout */
+    std::string outputPath = "statistics/data.csv";/* Data file path, empty disables it */
+    std::unique_ptr<TrajectorySink> sink/* Data file */;
 
     /**
-     * Simulation
+     * Simulation of a command line experiment
      *
      * @return 0 if OK
      */
     int simulate();
 
+    /**
+     * Applies an intervention to the rates
+     */
+    void applyChange(const Timeline::Change &change);
+
     /**
      * Calculates nest step of a simulation based on differential equations
      */
     void nextStep();
 
     /**
-     * Counts the date difference
+     * Builds the compartment graph of the simulation model
      */
-    unsigned long simulationDays(int yearEnd, int monthEnd, int dayEnd);
+    void buildGraph();
 
     /**
-     * Outputs initial conditions to stdout
+     * Copies the rates into the parameters of the graph
      */
-    void printHeader();
+    void updateParameters();
 
+public:
     /**
-     * Outputs simulations results to stdout
+     * Model of the first experiment (SIR without measures)
      */
-    void printFooter();
+    BasicModel();
+
+    explicit BasicModel(const Parameters &parameters);
 
     /**
-     * Simulates epidemic with no measures (SIR)
-     *
-     * @return 0 if OK
+     * Starts again from day 0 with the parameters, observers are kept
      */
-    int exp1();
+    void reset();
 
     /**
-     * Simulates epidemic with government measures (SIR)
-     *
-     * @return 0 if OK
+     * Replaces the parameters and starts again from day 0
+     */
+    void reset(const Parameters &parameters);
+
+    /**
+     * Simulates the current day: applies its interventions, updates the
+     * statistics, notifies observers and advances the state by one day
      */
-    int exp2();
+    void step();
 
     /**
-     * Simulates epidemic with no measures (SIERD)
+     * Steps until the given day, nothing happens if the model is already there
      *
-     * @return 0 if OK
+     * @param day day reached, the number of days simulated since day 0
+     */
+    void runTo(unsigned long day);
+
+    /**
+     * @return day the next step simulates, the number of days simulated so far
      */
-    int exp3();
+    unsigned long getDay() const { return today; }
 
     /**
-     * Simulates epidemic with measures (SIERD)
+     * @return values of all compartments, valid until reset()
+     */
+    Span<const T> getState() const { return Span<const T>(graph.getState(), graph.compartments()); }
+
+    /**
+     * @return compartment names, index by compartment as getState()
+     */
+    const std::vector<std::string> &getNames() const { return graph.getNames(); }
+
+    /**
+     * @return index of a compartment (S, E, I, R, D), -1 if the model has no such compartment
+     */
+    int compartment(const std::string &name) const { return graph.compartment(name); }
+
+    const Parameters &getParameters() const { return parameters; }
+
+    /**
+     * @return rates with the interventions applied so far
+     */
+    const Rates &getRates() const { return rates; }
+
+    /**
+     * Appends the state of the current day: compartments, sums of the
+     * flows, current rates, statistics and the day
+     */
+    void save(Snapshot &snapshot) const;
+
+    /**
+     * Continues from a snapshot of a model with the same compartments
      *
-     * @return 0 if OK
+     * The rates are those of the snapshot, interventions of the restored day
+     * and later come from the own timeline, so a model with other later
+     * interventions forks a what-if run from the shared prefix.
+     *
+     * @return 0 if OK, 1 if the snapshot is of another model and nothing changed
      */
-    int exp4();
+    int restore(Snapshot &snapshot);
+
+    /**
+     * Observer is notified until removed, the model does not own it
+     */
+    void addObserver(Observer &observer);
+    void removeObserver(Observer &observer);
 
-public:
     /**
      * Wraps days calculation and experiment
      *
      * @param num experiment number
+     * @param days number of days of simulation, 0 simulates until 7.12.2020
      * @return 0 if OK
      */
-    int performExp(int num);
+    int performExp(int num, unsigned long days = 0);
+
+    /**
+     * Replaces the Hubei timeline of the experiments with custom interventions
+     */
+    void setTimeline(const Timeline &timeline);
+
+    /**
+     * Overrides the initial COVID19 constants, interventions still change them later
+     *
+     * @param R0 basic reproduction number
+     * @param alpha recovery rate
+     * @param sigma infectivity
+     * @param omega fatality rate
+     */
+    void setRates(T R0, T alpha, T sigma, T omega);
+
+    /**
+     * Redirects the data file
+     *
+     * @param path CSV file path, ".bin" for the binary columnar format or
+     *             ".delta" for the compressed log, empty string writes no data file
+     */
+    void setOutput(const std::string &path);
+
+    /**
+     * Sends the trajectory of the next simulation to a custom sink instead of the data file
+     */
+    void setSink(std::unique_ptr<TrajectorySink> sink);
+
+    /**
+     * Enables or disables the stdout header and footer
+     */
+    void setVerbose(bool enabled);
+
+    /**
+     * @return statistics of the days simulated so far
+     */
+    const Stats &getStats() const { return stats; }
+
+    /**
+     * @return dead people of the current day
+     */
+    T getDead() const { return index.D < 0 ? T(0) : graph.get(index.D); }
 };
 
+// Simulation model in the default precision
+typedef BasicModel<double> Model;
+
+// Model carrying the derivatives of everything by R0, alpha, sigma and omega, in this order
+typedef BasicModel<Dual<4>> SensitivityModel;
+
+/**
+ * Setup of a Hubei experiment with the initial rates seeded as the inputs
+ * of SensitivityModel, interventions replace them by constants
+ */
+SensitivityModel::Parameters sensitivityParameters(int experiment);
+
 #endif //_MAIN_H_
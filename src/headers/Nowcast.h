@@ -0,0 +1,140 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Incremental nowcasting by an ensemble Kalman filter interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://doi.org/10.1029/94JC00572
+ * @file Nowcast.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _NOWCAST_H_
+#define _NOWCAST_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Compartments.h"
+#include "Model.h"
+#include "Output.h"
+#include "Random.h"
+
+/**
+ * Model kept running while daily case reports arrive
+ *
+ * Every ensemble member is a state of the Model equations extended by its
+ * cumulative infections and its own ln R0, which follows a random walk.
+ * Members advance day by day with the compartment graph of Model; when a
+ * day has a report, the stochastic ensemble Kalman filter moves every
+ * member towards the reported new infections of that day (perturbed
+ * observations), which updates the compartments and R0 together.
+ *
+ * A forecast copies only the member states and advances the copy, so the
+ * filter continues from the current day and nothing is simulated again
+ * from day 0.
+ *
+ * The timeline of the parameters is not applied: interventions show up as
+ * changes of the estimated R0.
+ */
+class Nowcast {
+public:
+    // Daily forecast, means and 5 %, 95 % quantiles over the members
+    struct Day {
+        unsigned long day;
+        double cases, casesLow, casesHigh/* New infections of the day */;
+        double infected, infectedLow, infectedHigh;
+    };
+
+    /**
+     * @param parameters model, initial state and rates, R0 is the centre of the prior
+     * @param members ensemble size
+     */
+    Nowcast(const Model::Parameters &parameters, std::size_t members = 200, std::uint64_t seed = 0);
+
+    /**
+     * @param prior standard deviation of ln R0 of the initial members
+     * @param drift standard deviation of the daily change of ln R0
+     */
+    void setR0Noise(double prior, double drift);
+
+    /**
+     * Standard deviation of a report: relative * cases + absolute
+     */
+    void setReportError(double relative, double absolute = 1.0);
+
+    /**
+     * Advances the members to a day and assimilates the new infections reported for it
+     *
+     * @param day day of the report, after the current day
+     * @param cases infections of the previous day, cumulative(day) - cumulative(day - 1) in Model
+     * @return 0 if OK, 1 if the day is not after the current day
+     */
+    int assimilate(unsigned long day, double cases);
+
+    /**
+     * Advances the members without a report
+     */
+    void advance(unsigned long day);
+
+    /**
+     * Forecast from a copy of the members, the filter state does not change
+     *
+     * @param days days ahead
+     */
+    std::vector<Day> forecast(unsigned long days) const;
+
+    /**
+     * Reads reports and assimilates each as it arrives, after every report
+     * a status line goes to the output and the forecast to its file
+     *
+     * Report lines "<when> <cases>" with a date YYYY-MM-DD or a day index, blank
+     * or comma separated, '#' starts a comment; a pipe is read line by line.
+     *
+     * @param horizon days of the forecast
+     * @param forecastPath data file rewritten after every report, empty writes none
+     * @return 0 if OK
+     */
+    int serve(std::istream &reports, std::ostream &status, unsigned long horizon, const std::string &forecastPath);
+
+    unsigned long getDay() const { return today; }
+    std::size_t size() const { return members; }
+
+    /**
+     * @return mean of R0 over the members
+     */
+    double getR0() const;
+
+    /**
+     * @return mean of a compartment over the members, -1 index gives the cumulative infections
+     */
+    double mean(int compartment) const;
+
+private:
+    Model::Parameters parameters;
+    std::size_t members, width/* Compartments, cumulative infections and ln R0 */;
+    mutable CompartmentModel<double> graph/* Shared by the members, holds one state at a time */;
+    int infection, beta/* Indices of the graph */;
+    RandomStream random;
+    double prior = 0.3, drift = 0.05, relative = 0.1, absolute = 1.0;
+
+    unsigned long today = 0;
+    std::vector<double> states/* Member after member */;
+    std::vector<double> predicted/* New infections of the last day by member */;
+
+    /**
+     * Advances a member state by one day
+     *
+     * @return new infections of the day
+     */
+    double step(double *state) const;
+};
+
+#endif //_NOWCAST_H_
@@ -0,0 +1,269 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Buffered trajectory output interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Output.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Destination of a trajectory, one row of doubles per simulated day
+ */
+class TrajectorySink {
+public:
+    virtual ~TrajectorySink() {}
+
+    /**
+     * Starts the output
+     *
+     * @param columns column names, every row has one value per column
+     * @return 0 if OK
+     */
+    virtual int open(const std::vector<std::string> &columns) = 0;
+
+    /**
+     * Appends a row
+     */
+    virtual void write(const double *row) = 0;
+
+    /**
+     * Flushes buffered rows and finishes the output
+     *
+     * @return 0 if everything was written
+     */
+    virtual int close() = 0;
+};
+
+/**
+ * CSV with a header line, rows are formatted into a memory buffer that is
+ * written in large blocks, there is no flush per line
+ */
+class CsvSink : public TrajectorySink {
+public:
+    /**
+     * @param path CSV file path
+     * @param precision significant digits, 6 matches the operator<< default
+     */
+    explicit CsvSink(const std::string &path, int precision = 6);
+    ~CsvSink();
+
+    int open(const std::vector<std::string> &columns);
+    void write(const double *row);
+    int close();
+
+private:
+    std::string path;
+    std::ofstream file;
+    std::string buffer;
+    std::size_t columns = 0;
+    int precision;
+};
+
+/**
+ * Compact columnar binary format
+ *
+ * Layout (little endian):
+ *  - 8 B magic "IMSTRAJ", 4 B version, 4 B column count, 8 B row count
+ *  - 16 B NUL padded name per column
+ *  - zero padding up to the data offset, the next multiple of 64
+ *  - one array of row count float64 values per column, column after column,
+ *    each zero padded to the column stride, the next multiple of 64 bytes
+ *
+ * Every column is a contiguous 64 B aligned array, so a memory map of the
+ * file is directly usable (numpy.memmap, TrajectoryReader). Rows are kept in
+ * memory and written column by column on close().
+ */
+class BinarySink : public TrajectorySink {
+public:
+    static const char magic[8];
+    static const std::uint32_t version = 2;
+    static const std::size_t nameSize = 16;
+    static const std::size_t alignment = 64;
+
+    explicit BinarySink(const std::string &path);
+    ~BinarySink();
+
+    int open(const std::vector<std::string> &columns);
+    void write(const double *row);
+    int close();
+
+    /**
+     * @return byte offset of the first column array for the given column count
+     */
+    static std::size_t dataOffset(std::size_t columns);
+
+    /**
+     * @return bytes from the start of a column array to the next for the given row count
+     */
+    static std::size_t columnStride(std::size_t rows);
+
+private:
+    std::string path;
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> data/* One array per column */;
+    bool opened = false;
+};
+
+/**
+ * Zero-copy reader of the BinarySink format via mmap
+ */
+class TrajectoryReader {
+public:
+    TrajectoryReader() {}
+    ~TrajectoryReader();
+
+    /**
+     * Maps a file written by BinarySink
+     *
+     * @return 0 if OK
+     */
+    int open(const std::string &path);
+
+    /**
+     * Unmaps the file, column pointers become invalid
+     */
+    void close();
+
+    std::size_t rows() const { return rowCount; }
+    const std::vector<std::string> &columns() const { return names; }
+
+    /**
+     * @return column array of rows() values or nullptr if there is no such column
+     */
+    const double *column(const std::string &name) const;
+
+private:
+    void *map = nullptr;
+    std::size_t mapSize = 0;
+    std::size_t rowCount = 0;
+    std::size_t stride = 0/* Values from one column array to the next */;
+    std::vector<std::string> names;
+    const double *values = nullptr;
+
+    TrajectoryReader(const TrajectoryReader &);
+    TrajectoryReader &operator=(const TrajectoryReader &);
+};
+
+/**
+ * Compressed trajectory log with random access by day
+ *
+ * Rows are stored in blocks of a fixed row count, every block encodes each
+ * of its columns on its own, so a block decodes without the others:
+ *  - INTEGER: all values of the block are whole numbers (rounded people),
+ *    stored as zigzag varint second differences, the change of the daily
+ *    change, which stays small on smooth epidemic curves
+ *  - XOR: bits of a value XOR the bits of the previous row, the nonzero
+ *    bytes in between the zero high and low bytes follow a count byte
+ *
+ * Layout (little endian):
+ *  - 8 B magic "IMSDLOG", 4 B version, 4 B column count, 4 B rows per block,
+ *    4 B reserved
+ *  - varint length and bytes of every column name
+ *  - blocks: per column 1 B encoding and the values of its rows
+ *  - index: 8 B file offset of every block
+ *  - 8 B index offset, 8 B row count, 8 B magic
+ *
+ * Only the block being filled is kept in memory.
+ */
+class DeltaSink : public TrajectorySink {
+public:
+    static const char magic[8];
+    static const std::uint32_t version = 1;
+
+    /**
+     * @param blockRows rows per block, the unit of random access
+     */
+    explicit DeltaSink(const std::string &path, std::size_t blockRows = 128);
+    ~DeltaSink();
+
+    int open(const std::vector<std::string> &columns);
+    void write(const double *row);
+    int close();
+
+private:
+    std::string path;
+    std::ofstream file;
+    std::size_t columns = 0, blockRows, rows = 0/* Rows of the current block */;
+    std::uint64_t total = 0/* Rows written */;
+    std::vector<double> block/* Current block, column after column */;
+    std::vector<std::uint64_t> offsets/* Index of the written blocks */;
+    std::string buffer;
+
+    /**
+     * Encodes and writes the current block
+     */
+    void flush();
+};
+
+/**
+ * Reader of the DeltaSink format, decodes only the blocks it is asked for
+ */
+class DeltaReader {
+public:
+    /**
+     * Reads the header and the block index of a file written by DeltaSink
+     *
+     * @return 0 if OK
+     */
+    int open(const std::string &path);
+
+    void close();
+
+    std::size_t rows() const { return rowCount; }
+    const std::vector<std::string> &columns() const { return names; }
+
+    /**
+     * Decodes the row of a day, reads its block only
+     *
+     * @param values one value per column
+     * @return 0 if OK
+     */
+    int row(std::size_t day, double *values);
+
+    /**
+     * Decodes a whole column
+     *
+     * @return 0 if OK, 1 if there is no such column or the file is damaged
+     */
+    int column(const std::string &name, std::vector<double> &values);
+
+private:
+    std::ifstream file;
+    std::vector<std::string> names;
+    std::size_t rowCount = 0, blockRows = 0;
+    std::vector<std::uint64_t> offsets/* Block offsets followed by the index offset */;
+
+    std::size_t cached = 0/* Block in the cache plus one, 0 if none */;
+    std::vector<double> cache/* Decoded block, column after column */;
+    std::string bytes;
+
+    /**
+     * Decodes a block into the cache
+     *
+     * @return 0 if OK
+     */
+    int load(std::size_t block);
+};
+
+/**
+ * Picks a sink by file extension, ".bin" is binary, ".delta" the
+ * compressed log and anything else CSV
+ */
+std::unique_ptr<TrajectorySink> makeSink(const std::string &path);
+
+#endif //_OUTPUT_H_
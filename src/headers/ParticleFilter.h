@@ -0,0 +1,178 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Particle filter over the stochastic SIR/SEIRD model interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://doi.org/10.1049/ip-f-2.1993.0015
+ * @file ParticleFilter.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _PARTICLE_FILTER_H_
+#define _PARTICLE_FILTER_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Model.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+/**
+ * Bootstrap particle filter for daily case reports
+ *
+ * Particles are whole people moving by the chain binomial of Ensemble, each
+ * with its own ln R0 following a random walk. A report weights every
+ * particle by the negative binomial probability of the reported cases with
+ * the new infections of the particle as mean; the filter returns the log
+ * likelihood of the report and the effective sample size of the weights.
+ * Once the effective size drops below a fraction of the particle count, the
+ * particles are resampled systematically.
+ *
+ * The state is a structure of arrays, index by particle. Propagation splits
+ * the particles among the workers; a particle slot keeps its random stream,
+ * so results do not depend on the worker count. Resampling runs in place:
+ * particles drawn at least once stay in their slots, the extra copies go to
+ * the slots of the particles not drawn, and the counts and free slots live
+ * in buffers allocated with the particles. The blocks of particles go to
+ * the workers as tasks small enough for the storage the pool keeps, so no
+ * day after the one starting the workers allocates memory.
+ */
+class ParticleFilter {
+public:
+    // Result of a report
+    struct Step {
+        unsigned long day = 0;
+        double logLikelihood = 0.0/* Of the report given the reports before */;
+        double effectiveSize = 0.0/* Of the weights after the report */;
+        bool resampled = false;
+    };
+
+    /**
+     * @param parameters model, initial state and rates, R0 is the centre of the prior
+     * @param particles particle count
+     */
+    ParticleFilter(const Model::Parameters &parameters, std::size_t particles, std::uint64_t seed = 0);
+
+    /**
+     * Restarts the particles from day 0
+     *
+     * @param prior standard deviation of ln R0 of the initial particles
+     * @param drift standard deviation of the daily change of ln R0
+     */
+    void setR0Noise(double prior, double drift);
+
+    /**
+     * Sets the negative binomial dispersion k of reports, the variance is mean + mean^2 / k
+     */
+    void setDispersion(double dispersion) { this->dispersion = dispersion; }
+
+    /**
+     * Resamples once the effective size is below the fraction of the particles, 1 after every report
+     */
+    void setResampleThreshold(double fraction) { threshold = fraction; }
+
+    /**
+     * Sets worker count of the following steps
+     *
+     * @param threads 0 means one per hardware thread, 1 runs on the calling thread
+     */
+    void setThreads(unsigned threads);
+
+    /**
+     * Advances the particles to a day and weights them by the new infections reported for it
+     *
+     * @param day day of the report, after the current day
+     * @param cases infections of the previous day, as in Nowcast
+     * @return 0 if OK, 1 if the day is not after the current day
+     */
+    int assimilate(unsigned long day, double cases);
+
+    /**
+     * Advances the particles without a report
+     */
+    void advance(unsigned long day);
+
+    /**
+     * @return result of the last report
+     */
+    const Step &getStep() const { return last; }
+
+    /**
+     * @return log likelihood of all reports so far
+     */
+    double getLogLikelihood() const { return logLikelihood; }
+
+    /**
+     * @return (sum of weights)^2 / sum of squared weights
+     */
+    double effectiveSize() const;
+
+    /**
+     * @return weighted mean of values index by particle, e.g. getI()
+     */
+    double mean(const std::uint64_t *values) const;
+
+    /**
+     * @return weighted mean of R0
+     */
+    double getR0() const;
+
+    std::size_t size() const { return particles; }
+    unsigned long getDay() const { return day; }
+
+    // Per particle values, index by particle
+    const std::uint64_t *getS() const { return S.data(); }
+    const std::uint64_t *getE() const { return E.data(); }
+    const std::uint64_t *getI() const { return I.data(); }
+    const std::uint64_t *getR() const { return R.data(); }
+    const std::uint64_t *getD() const { return D.data(); }
+    const std::uint64_t *getSumInfected() const { return sumInfected.data(); }
+    const double *getLogR0() const { return logR0.data(); }
+
+private:
+    Model::Parameters parameters;
+    std::size_t particles;
+    std::uint64_t seed;
+    double prior = 0.3, drift = 0.05, dispersion = 20.0, threshold = 0.5;
+
+    unsigned long day = 0;
+    double logLikelihood = 0.0;
+    Step last;
+
+    // Particle state
+    std::vector<std::uint64_t> S, E, I, R, D, sumInfected, newInfected/* Of the last day */;
+    std::vector<double> logR0, logWeight;
+    std::vector<RandomStream> streams/* Owned by the slot, not copied by resampling */;
+    RandomStream resampling;
+
+    // Resampling buffers, sized with the particles
+    std::vector<std::uint32_t> counts, slots;
+
+    unsigned threads = 0;
+    std::unique_ptr<ThreadPool> pool;
+
+    /**
+     * Runs body(begin, end) on blocks of particles, the body is not copied
+     */
+    template<class Body>
+    void forBlocks(const Body &body);
+
+    /**
+     * Advances particles [begin, end) by a day
+     */
+    void stepParticles(std::size_t begin, std::size_t end);
+
+    /**
+     * Systematic resampling in place, all weights become equal
+     */
+    void resample();
+};
+
+#endif //_PARTICLE_FILTER_H_
@@ -0,0 +1,26 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Accuracy report of Model precisions interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file PrecisionReport.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _PRECISION_REPORT_H_
+#define _PRECISION_REPORT_H_
+
+#include <ostream>
+
+/**
+ * Runs all experiments with float, double and long double models and writes
+ * the final statistics, their relative error to long double and time per run
+ *
+ * @param out report stream
+ * @param repeats runs per experiment and precision used for timing
+ * @return 0 if OK
+ */
+int precisionReport(std::ostream &out, unsigned repeats = 20);
+
+#endif //_PRECISION_REPORT_H_
@@ -0,0 +1,91 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Counter-based random streams and samplers interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://www.thesalmons.org/john/random123/papers/random123sc11.pdf
+ * @file Random.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstdint>
+
+/**
+ * Philox4x32-10 random stream
+ *
+ * Numbers are a keyed bijection of a 128-bit counter, so a stream is fully
+ * given by its key (seed, stream number) and position. Every replicate of an
+ * ensemble owns a stream: nothing is shared between threads and results do
+ * not depend on which worker ran which replicate.
+ */
+class RandomStream {
+public:
+    /**
+     * @param seed experiment seed
+     * @param stream independent stream of the seed, e.g. replicate index
+     */
+    explicit RandomStream(std::uint64_t seed = 0, std::uint64_t stream = 0);
+
+    /**
+     * @return next 32 random bits
+     */
+    std::uint32_t next() {
+        if (used == 4) {
+            refill();
+        }
+        return block[used++];
+    }
+
+    /**
+     * @return uniform number from the open interval (0, 1), 53 random bits
+     */
+    double uniform() {
+        // Separate statements, the order of two calls in one expression is unspecified
+        std::uint64_t high = next();
+        std::uint64_t low = next();
+        std::uint64_t bits = (high << 32 | low) >> 11;
+        return (bits + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * Philox4x32-10 of a counter with the key of this stream
+     */
+    void generate(const std::uint32_t counter[4], std::uint32_t out[4]) const;
+
+private:
+    std::uint32_t key[2];
+    std::uint32_t counter[4] = { 0, 0, 0, 0 };
+    std::uint32_t block[4];
+    unsigned used = 4/* Numbers of block already returned */;
+
+    void refill();
+};
+
+/**
+ * Binomial random variable, inversion for small means, otherwise BTRS
+ * transformed rejection (Hormann 1993) in constant expected time
+ *
+ * @param n trials
+ * @param p success probability
+ */
+std::uint64_t binomial(RandomStream &random, std::uint64_t n, double p);
+
+/**
+ * Poisson random variable, multiplication for small means, otherwise PTRS
+ * transformed rejection (Hormann 1993) in constant expected time
+ */
+std::uint64_t poisson(RandomStream &random, double mean);
+
+/**
+ * Standard normal random variable, Box-Muller transform of two uniforms
+ */
+double normal(RandomStream &random);
+
+#endif //_RANDOM_H_
@@ -0,0 +1,37 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Console report of a simulation interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Report.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _REPORT_H_
+#define _REPORT_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <ostream>
+
+#include "Model.h"
+
+/**
+ * Observer printing the initial conditions when a run starts and the
+ * results when it finishes, the output of the command line experiments
+ */
+template<typename T>
+class ConsoleReport : public BasicModel<T>::Observer {
+public:
+    explicit ConsoleReport(std::ostream &out) : out(out) {}
+
+    void started(const BasicModel<T> &model, unsigned long until) override;
+    void finished(const BasicModel<T> &model) override;
+
+private:
+    std::ostream &out;
+};
+
+#endif //_REPORT_H_
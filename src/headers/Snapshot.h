@@ -0,0 +1,96 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Binary snapshot of a simulation state interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Snapshot.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * State of a simulation at the start of a day, taken to fork what-if runs
+ * from a shared prefix instead of simulating the prefix again
+ *
+ * A snapshot is a byte buffer of plain values in the order they were put,
+ * the simulation reading it gets them in the same order and checks the kind
+ * tag and the sizes it starts with. Values keep their in-memory
+ * representation, so long double states restore exactly.
+ *
+ * File layout (little endian):
+ *  - 8 B magic "IMSSNAP", 4 B version, 4 B zero, 8 B payload size
+ *  - payload
+ */
+class Snapshot {
+public:
+    static const char magic[8];
+    static const std::uint32_t version = 1;
+
+    /**
+     * Appends values of a trivially copyable type
+     */
+    template<typename V>
+    void put(const V *values, std::size_t count) {
+        const char *data = reinterpret_cast<const char *>(values);
+        bytes.insert(bytes.end(), data, data + count * sizeof(V));
+    }
+
+    template<typename V>
+    void put(const V &value) { put(&value, 1); }
+
+    /**
+     * Reads values at the read position
+     *
+     * @return false if the snapshot has fewer bytes left
+     */
+    template<typename V>
+    bool get(V *values, std::size_t count) {
+        std::size_t size = count * sizeof(V);
+        if (bytes.size() - position < size) {
+            return false;
+        }
+        std::memcpy(values, bytes.data() + position, size);
+        position += size;
+        return true;
+    }
+
+    template<typename V>
+    bool get(V &value) { return get(&value, 1); }
+
+    /**
+     * Appends a kind tag, expect() checks it when reading
+     */
+    void tag(const char *kind) { put(kind, std::strlen(kind) + 1); }
+    bool expect(const char *kind);
+
+    /**
+     * Moves the read position to the start, a snapshot restores any number of runs
+     */
+    void rewind() { position = 0; }
+    void clear() { bytes.clear(); position = 0; }
+    std::size_t size() const { return bytes.size(); }
+
+    /**
+     * @return 0 if OK
+     */
+    int save(const std::string &path) const;
+    int load(const std::string &path);
+
+private:
+    std::vector<char> bytes;
+    std::size_t position = 0/* Read position */;
+};
+
+#endif //_SNAPSHOT_H_
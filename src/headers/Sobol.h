@@ -0,0 +1,147 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Variance-based global sensitivity analysis interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://doi.org/10.1016/j.cpc.2009.09.018
+ * @file Sobol.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _SOBOL_H_
+#define _SOBOL_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "optimize.h"
+
+/**
+ * Sobol low-discrepancy sequence in up to 40 dimensions, direction numbers
+ * of Joe and Kuo (new-joe-kuo-6.21201). Points are computed directly from
+ * their index, so any worker can generate any part of the sequence.
+ */
+class SobolSequence {
+public:
+    static const std::size_t maxDimensions = 40;
+
+    /**
+     * @param dimensions coordinates of a point, at most maxDimensions
+     */
+    explicit SobolSequence(std::size_t dimensions);
+
+    std::size_t dimensions() const { return directions.size() / 32; }
+
+    /**
+     * Point of the sequence, coordinates from [0, 1)
+     */
+    void point(std::uint64_t index, double *coordinates) const;
+
+private:
+    std::vector<std::uint32_t> directions/* 32 direction numbers per dimension */;
+};
+
+/**
+ * First-order and total-effect Sobol indices of model outputs by parameters
+ *
+ * Saltelli design: every sample is a pair of points A, B of the parameter
+ * ranges and the model runs on A, on B and on A with the i-th parameter
+ * taken from B (AB_i), d + 2 runs per sample for d parameters. Estimators
+ * (Saltelli 2010 first-order, Jansen total effect):
+ *
+ *     S_i  = mean(f(B) * (f(AB_i) - f(A))) / V
+ *     ST_i = mean((f(A) - f(AB_i))^2) / 2 / V
+ *
+ * with V the variance of f(A) and f(B). Runs of a batch of samples are
+ * evaluated concurrently on the thread pool, then folded in sample order
+ * into running sums, so memory does not grow with the sample count and
+ * the indices do not depend on the number of threads.
+ *
+ * Designs:
+ *  - SOBOL: A and B are the two halves of a 2d-dimensional Sobol point,
+ *    further run() calls continue the sequence
+ *  - LATIN_HYPERCUBE: every run() is a new Latin hypercube of its sample
+ *    count, the strata are random permutations computed per sample
+ */
+class SobolAnalysis {
+public:
+    // Sampling of the parameter ranges
+    enum Design { SOBOL, LATIN_HYPERCUBE };
+
+    /**
+     * Model run, called from several threads at once
+     *
+     * @param values parameter values of the run
+     * @param outputs outputs of the run to be filled
+     */
+    typedef std::function<void(const simlib3::ParameterVector &values, double *outputs)> Evaluation;
+
+    /**
+     * @param parameters analysed parameters, their Min() and Max() are the sampled range
+     * @param outputs output count of an evaluation
+     */
+    SobolAnalysis(const simlib3::ParameterVector &parameters, std::size_t outputs, Evaluation evaluation);
+
+    void setDesign(Design design) { this->design = design; }
+
+    /**
+     * Seed of the Latin hypercube permutations and positions within strata
+     */
+    void setSeed(std::uint64_t seed) { this->seed = seed; }
+
+    /**
+     * @param threads 0 means one per hardware thread, 1 runs on the calling thread
+     */
+    void setThreads(unsigned threads) { this->threads = threads; }
+
+    /**
+     * Evaluates more samples and adds them to the estimates
+     *
+     * @param samples sample count, each sample takes parameter count + 2 runs
+     * @return 0 if OK, 1 if SOBOL has too many parameters
+     */
+    int run(std::size_t samples);
+
+    /**
+     * Forgets all samples
+     */
+    void clear();
+
+    double firstOrder(std::size_t parameter, std::size_t output) const;
+    double totalEffect(std::size_t parameter, std::size_t output) const;
+    double mean(std::size_t output) const;
+    double variance(std::size_t output) const;
+
+    std::size_t getSamples() const { return samples; }
+    std::size_t getEvaluations() const { return samples * (parameters.size() + 2); }
+    const simlib3::ParameterVector &getParameters() const { return parameters; }
+
+private:
+    simlib3::ParameterVector parameters;
+    std::size_t outputs;
+    Evaluation evaluation;
+    Design design = SOBOL;
+    std::uint64_t seed = 0;
+    unsigned threads = 0;
+
+    // Running sums, index by output and by parameter * outputs + output
+    std::size_t samples = 0, designs = 0/* Latin hypercubes so far */;
+    std::vector<double> shift/* f(A) of the first sample, subtracted against cancellation */;
+    std::vector<double> means, squares/* Welford sums over f(A) and f(B) */;
+    std::vector<double> first, total;
+
+    /**
+     * Coordinates of A and B of a sample of the current Latin hypercube, 2 * parameters values from [0, 1)
+     *
+     * @param count sample count of the hypercube
+     */
+    void latinPoint(std::size_t sample, std::size_t count, double *coordinates) const;
+};
+
+#endif //_SOBOL_H_
@@ -0,0 +1,43 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Non-owning view of contiguous values
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Span.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _SPAN_H_
+#define _SPAN_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+
+/**
+ * Pointer and length of values owned by someone else, std::span for C++11
+ *
+ * A span stays valid until the owner reallocates the values.
+ */
+template<typename T>
+class Span {
+public:
+    Span() {}
+    Span(T *data, std::size_t size) : pointer(data), length(size) {}
+
+    T *data() const { return pointer; }
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    T &operator[](std::size_t i) const { return pointer[i]; }
+    T *begin() const { return pointer; }
+    T *end() const { return pointer + length; }
+
+private:
+    T *pointer = nullptr;
+    std::size_t length = 0;
+};
+
+#endif //_SPAN_H_
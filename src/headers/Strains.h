@@ -0,0 +1,137 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Multi-strain SIR/SEIRD model interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://doi.org/10.1007/s00285-003-0241-6
+ * @file Strains.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _STRAINS_H_
+#define _STRAINS_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Model.h"
+#include "Output.h"
+
+/**
+ * Model equations with exposed, infected and recovered split by strain
+ *
+ * Strain k spreads with beta_k = beta * transmissibility_k among the
+ * susceptible, and among the people recovered from strain j at the rate
+ *
+ *     (1 - C[j][k]) * beta_k * R_j * I_k / N
+ *
+ * where C[j][k] is the protection of an infection by j against k, 1 by
+ * default (no reinfection). Strain 0 is the one of Model, later strains
+ * arrive on their day by moving seed infections out of the susceptible.
+ * The timeline changes the rates of all strains alike. The infections of
+ * all strains leaving S, or the reinfections leaving R_j, are scaled down
+ * together if their sum exceeds the compartment, which then empties.
+ *
+ * Every per-strain quantity is one contiguous array index by strain and the
+ * cross-immunity matrix is stored row by row, so a day is a few plain loops
+ * over strains without any dispatch: linear in the strain count except the
+ * reinfection term, which has an entry per pair of strains. A step is the
+ * forward Euler step of CompartmentModel with the same operation order, so
+ * one strain reproduces Model exactly.
+ */
+class StrainModel {
+public:
+    /**
+     * Creates the strain of Model with its initial state, rates and timeline
+     */
+    explicit StrainModel(const Model::Parameters &parameters);
+
+    /**
+     * Adds a strain arriving later, fully protected against by all immunity
+     *
+     * @param transmissibility beta relative to strain 0
+     * @param arrival day the seed infections appear
+     * @param seeds infected people moved from the susceptible on arrival
+     * @return strain index
+     */
+    std::size_t addStrain(double transmissibility, unsigned long arrival, double seeds);
+
+    /**
+     * @param from strain of the past infection
+     * @param to strain of the new infection
+     * @param protection 1 blocks reinfection, 0 leaves the recovered as exposed to it as the susceptible
+     */
+    void setCrossImmunity(std::size_t from, std::size_t to, double protection);
+
+    /**
+     * Applies interventions and arrivals of the current day and advances by a day
+     */
+    void step();
+
+    /**
+     * Advances to a day, writing every day before it to the sink if set
+     *
+     * @return 0 if OK
+     */
+    int simulate(unsigned long days);
+
+    /**
+     * Writes S, E, I, R per strain (suffix 2, 3, ... after strain 0), D and the sums of infected and recovered
+     */
+    void setSink(std::unique_ptr<TrajectorySink> sink);
+
+    std::size_t strains() const { return transmissibility.size(); }
+    unsigned long getDay() const { return today; }
+
+    double getS() const { return S; }
+    double getD() const { return D; }
+
+    // Per strain values, index by strain
+    const double *getE() const { return E.data(); }
+    const double *getI() const { return I.data(); }
+    const double *getR() const { return R.data(); }
+    const double *getSumInfected() const { return sumInfected.data(); }
+    const double *getSumRecovered() const { return sumRecovered.data(); }
+
+private:
+    Model::Parameters parameters;
+    Model::Rates rates;
+    std::size_t pending = 0/* First change not applied yet */;
+    unsigned long today = 0;
+
+    // Shared compartments
+    double S, D = 0.0;
+
+    // Per strain, contiguous
+    std::vector<double> E, I, R, sumInfected, sumRecovered;
+    std::vector<double> transmissibility, beta, seeds;
+    std::vector<unsigned long> arrival;
+
+    // Row by row, index [from * strains + to]
+    std::vector<double> escape/* 1 - protection */;
+
+    // Fluxes of a day
+    std::vector<double> infection, incubation, recovery, death, reinfection;
+    std::vector<char> emptiedR/* Reinfections take all recovered of the strain */;
+
+    std::unique_ptr<TrajectorySink> sink;
+    std::vector<double> row;
+
+    /**
+     * Transmission of every strain from the current rates
+     */
+    void updateBeta();
+
+    /**
+     * Writes the current day to the sink
+     */
+    void write();
+};
+
+#endif //_STRAINS_H_
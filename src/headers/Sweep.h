@@ -0,0 +1,112 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Parallel parameter sweep interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Sweep.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <string>
+#include <vector>
+
+#include "Model.h"
+
+/**
+ * Runs many independent Model instances on a work-stealing thread pool
+ *
+ * Runs are read either from a grid file, one "key = values" line per
+ * parameter where values is a comma separated list or start:stop:step range
+ * with start <= stop, or from a CSV list with a header naming the parameters.
+ * Known parameters are experiment (1-4), R0, alpha, sigma and omega, missing
+ * ones keep the Model defaults.
+ */
+class Sweep {
+public:
+    // Single parameter set
+    struct Run {
+        int experiment = 1;/* Experiment number passed to Model::performExp */
+        double
+            R0 = 5.6015,
+            alpha = 0.0556,
+            sigma = 0.1923,
+            omega = 0.0034;
+    };
+
+    // Outcome of a single run
+    struct Result {
+        int status = -1;/* Return value of Model::performExp, -1 if not run */
+        Model::Stats stats;
+        double dead = 0.0;
+    };
+
+    /**
+     * Appends runs described by a grid or list file
+     *
+     * @param path parameter file
+     * @return 0 if OK
+     */
+    int load(const std::string &path);
+
+    /**
+     * Appends a single run
+     */
+    void add(const Run &run);
+
+    /**
+     * Uses custom interventions in all runs instead of the experiment timeline
+     */
+    void setTimeline(const Timeline &timeline);
+
+    /**
+     * Simulates all runs and writes the merged summary sweep.csv into outDir
+     *
+     * @param threads worker count, 0 means one per hardware thread
+     * @param outDir existing or new directory for the output files
+     * @param trajectories also write run_<index>.csv data file per run
+     * @param binary write the summary and data files in the binary columnar
+     *               format (sweep.bin, run_<index>.bin) instead of CSV
+     * @return 0 if all runs succeeded
+     */
+    int execute(unsigned threads, const std::string &outDir, bool trajectories, bool binary = false);
+
+    /**
+     * @return parameter sets in run order
+     */
+    const std::vector<Run> &getRuns() const { return runs; }
+
+    /**
+     * @return results in run order, filled by execute()
+     */
+    const std::vector<Result> &getResults() const { return results; }
+
+private:
+    std::vector<Run> runs;
+    std::vector<Result> results;
+    Timeline timeline;
+    bool customTimeline = false;
+
+    /**
+     * Expands "key = values" lines into the cartesian product of all values
+     */
+    int loadGrid(std::ifstream &input);
+
+    /**
+     * Reads one run per CSV row
+     */
+    int loadList(std::ifstream &input, const std::string &header);
+
+    /**
+     * Writes the merged summary, one row per run
+     */
+    int writeSummary(const std::string &path, bool binary) const;
+};
+
+#endif //_SWEEP_H_
@@ -0,0 +1,137 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Work-stealing thread pool interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file ThreadPool.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of workers, each owning a task deque. A worker pops its own
+ * tasks from the back and steals from the front of other deques when idle,
+ * so uneven task lengths are balanced without a central queue.
+ *
+ * The deques are ring buffers keeping their slots once grown and the chunk
+ * tasks of parallelFor fit the inline storage of std::function, so a loop
+ * run again and again, e.g. a day of a model, allocates no memory.
+ */
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * Starts the workers
+     *
+     * @param threads worker count, 0 means one per hardware thread
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    /**
+     * Waits for queued tasks and joins the workers
+     */
+    ~ThreadPool();
+
+    /**
+     * Queues a task, tasks may be submitted from inside other tasks
+     */
+    void submit(Task task);
+
+    /**
+     * Blocks until every submitted task has finished, not to be called from
+     * a task (the task itself is unfinished), parallelFor can be used there
+     */
+    void wait();
+
+    /**
+     * Runs body(i) for i in [0, n) split into chunks of grain indices and waits
+     * for them only. Called from a task, the worker runs queued tasks while
+     * waiting, so nested loops do not deadlock.
+     *
+     * @param n index count
+     * @param body function called once per index
+     * @param grain indices per task, 0 picks a chunk size from the worker count
+     */
+    void parallelFor(std::size_t n, const std::function<void(std::size_t)> &body, std::size_t grain = 0);
+
+    /**
+     * @return number of workers
+     */
+    unsigned size() const { return (unsigned)workers.size(); }
+
+    /**
+     * @return index of the calling worker, size() when called from other threads
+     */
+    unsigned currentWorker() const;
+
+private:
+    // Ring buffer deque, slots [head, head + count) modulo the slot count
+    struct Queue {
+        std::mutex lock;
+        std::vector<Task> slots;
+        std::size_t head = 0/* Oldest task */, count = 0;
+
+        /**
+         * Appends a task, doubles the slots if all are taken
+         */
+        void pushBack(Task &task);
+
+        /**
+         * Moves out the newest task
+         *
+         * @return false if empty
+         */
+        bool popBack(Task &task);
+
+        /**
+         * Moves out the oldest task
+         *
+         * @return false if empty
+         */
+        bool popFront(Task &task);
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Queue> queues;
+
+    std::mutex idleLock/* Guards sleeping and completion */;
+    std::condition_variable wakeUp/* Signalled on new work and shutdown */;
+    std::condition_variable allDone/* Signalled when pending drops to zero */;
+    std::atomic<std::size_t> pending/* Submitted but not finished tasks */;
+    std::atomic<std::size_t> next/* Round robin target for external submits */;
+    bool stopping = false;
+
+    /**
+     * Worker main loop
+     */
+    void run(unsigned self);
+
+    /**
+     * Runs a taken task and counts it as finished
+     */
+    void execute(Task &task);
+
+    /**
+     * Takes a task from the own deque or steals one
+     *
+     * @return true if a task was found
+     */
+    bool take(unsigned self, Task &task);
+};
+
+#endif //_THREAD_POOL_H_
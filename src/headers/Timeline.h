@@ -0,0 +1,114 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Intervention timeline interface
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file Timeline.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _TIMELINE_H_
+#define _TIMELINE_H_
+
+/**
+ * Include of libraries (C/C++)
+ */
+#include <string>
+#include <vector>
+
+/**
+ * Sorted list of parameter changes (interventions) by simulation day
+ *
+ * Dates are turned into day indices when the timeline is built, so a
+ * simulation only compares the current day with the next pending change.
+ *
+ * File format, one intervention per line, '#' starts a comment:
+ *
+ *     <when> <parameter>=<value> [<parameter>=<value> ...]
+ *
+ * where <when> is a date YYYY-MM-DD or a day index counted from the first
+ * reported case (31.12.2019 is day 0) and <parameter> is R0, alpha, sigma or
+ * omega. Transmission rate always follows as alpha * R0.
+ */
+class Timeline {
+public:
+    // Parameters an intervention can change
+    enum Parameter { R0, ALPHA, SIGMA, OMEGA };
+
+    // Single parameter change
+    struct Change {
+        unsigned long day/* Applied before simulating this day */;
+        Parameter parameter;
+        double value;
+    };
+
+    /**
+     * Appends interventions from a file
+     *
+     * @param path timeline file
+     * @return 0 if OK
+     */
+    int load(const std::string &path);
+
+    /**
+     * Adds a change, changes of one day keep their insertion order
+     */
+    void add(unsigned long day, Parameter parameter, double value);
+
+    /**
+     * @return changes sorted by day
+     */
+    const std::vector<Change> &getChanges() const { return changes; }
+
+    /**
+     * Sets the parameter of a change, the transmission rate follows as alpha * R0
+     *
+     * @param change Change or any record with the parameter and value members
+     */
+    template<class Changed, typename T>
+    static void apply(const Changed &change, T &R0, T &alpha, T &sigma, T &omega, T &beta) {
+        switch (change.parameter) {
+            case Timeline::R0:
+                R0 = change.value;
+                break;
+            case Timeline::ALPHA:
+                alpha = change.value;
+                break;
+            case Timeline::SIGMA:
+                sigma = change.value;
+                break;
+            case Timeline::OMEGA:
+                omega = change.value;
+                break;
+        }
+        beta = alpha * R0;
+    }
+
+    /**
+     * Sets the parameter of a change in rates with the R0, alpha, sigma,
+     * omega and beta members
+     */
+    template<class Changed, class Rates>
+    static void apply(const Changed &change, Rates &rates) {
+        apply(change, rates.R0, rates.alpha, rates.sigma, rates.omega, rates.beta);
+    }
+
+    /**
+     * Reads a date YYYY-MM-DD or a day index
+     *
+     * @return false if the text is neither
+     */
+    static bool parseDay(const std::string &text, unsigned long &day);
+
+    /**
+     * Timeline of the Hubei experiments: Chinese new year celebration and,
+     * with restrictions, the quarantine and the lockdown of the province
+     */
+    static Timeline hubei(bool restrictions);
+
+private:
+    std::vector<Change> changes;
+};
+
+#endif //_TIMELINE_H_
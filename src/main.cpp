@@ -7,7 +7,533 @@
  * @date 13. 11. 2020
  */
 
+#include "headers/Calibration.h"
+#include "headers/Continuous.h"
+#include "headers/Ensemble.h"
+#include "headers/Gillespie.h"
 #include "headers/Model.h"
+#include "headers/Nowcast.h"
+#include "headers/PrecisionReport.h"
+#include "headers/Sobol.h"
+#include "headers/Strains.h"
+#include "headers/Sweep.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+/**
+ * Parameter sweep over many independent models
+ *
+ * Usage: main sweep <grid or list file> [output directory] [-j threads] [-t] [-b] [-T timeline]
+ *  -t writes the data file of every run, -b uses the binary columnar format,
+ *  -T replaces the experiment interventions with a timeline file
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int sweep(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+
+    std::string outDir = "statistics/sweep";
+    unsigned threads = 0;
+    bool trajectories = false;
+    bool binary = false;
+    Sweep sweep;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0) {
+            trajectories = true;
+        } else if (strcmp(argv[i], "-b") == 0) {
+            binary = true;
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            Timeline timeline;
+            if (timeline.load(argv[++i]) != 0) { return 1; }
+            sweep.setTimeline(timeline);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else {
+            outDir = argv[i];
+        }
+    }
+
+    if (sweep.load(argv[2]) != 0) { return 1; }
+    return sweep.execute(threads, outDir, trajectories, binary);
+}
+
+/**
+ * Fit of experiment rates to observed cases, prints the fitted timeline
+ *
+ * Usage: main calibrate <cases> [experiment] [-p parameters] [-m nelder-mead|hooke|simann] [-j threads] [-i iterations]
+ *  fits R0 of every stage of the experiment timeline unless a parameter file is given
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int calibrate(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+
+    int experiment = 4;
+    const char *parameters = nullptr;
+    Calibration::Method method = Calibration::NELDER_MEAD;
+    unsigned threads = 0;
+    int iterations = 500;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            parameters = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "hooke") == 0) {
+                method = Calibration::HOOKE;
+            } else if (strcmp(argv[i], "simann") == 0) {
+                method = Calibration::SIMANN;
+            } else if (strcmp(argv[i], "nelder-mead") != 0) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            experiment = atoi(argv[i]);
+        }
+    }
+    if (experiment < 1 || experiment > 4) { return 1; }
+
+    Calibration calibration(experiment);
+    if (calibration.loadCases(argv[2]) != 0) { return 1; }
+    if (parameters) {
+        if (calibration.loadParameters(parameters) != 0) { return 1; }
+    } else {
+        calibration.addHubeiParameters();
+    }
+
+    double loss = calibration.fit(method, threads, iterations);
+    simlib3::ParameterVector values = calibration.getParameters();
+    std::cout << "# loss " << loss << " after " << calibration.getEvaluations() << " simulations" << std::endl;
+    for (int i = 0; i < values.size(); i++) {
+        std::string name = values[i].Name();
+        size_t at = name.find('@');
+        std::cout << name.substr(at + 1) << " " << name.substr(0, at) << "=" << values[i].Value() << std::endl;
+    }
+    return 0;
+}
+
+/**
+ * Sobol indices of the experiment statistics by rates
+ *
+ * Usage: main sobol [experiment] [-p parameters] [-n samples] [-d days] [-lhs] [-s seed] [-j threads]
+ *  samples rates from the ranges of a calibration parameter file, R0 of every
+ *  stage of the experiment timeline unless one is given; -lhs uses a Latin
+ *  hypercube instead of the Sobol sequence
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int sobol(int argc, char** argv) {
+    int experiment = 4;
+    const char *parameters = nullptr;
+    size_t samples = 4096;
+    unsigned long days = Date::reportDays;
+    SobolAnalysis::Design design = SobolAnalysis::SOBOL;
+    uint64_t seed = 0;
+    unsigned threads = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            parameters = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            samples = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            days = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-lhs") == 0) {
+            design = SobolAnalysis::LATIN_HYPERCUBE;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else {
+            experiment = atoi(argv[i]);
+        }
+    }
+    if (experiment < 1 || experiment > 4) { return 1; }
+
+    Calibration calibration(experiment);
+    if (parameters) {
+        if (calibration.loadParameters(parameters) != 0) { return 1; }
+    } else {
+        calibration.addHubeiParameters();
+    }
+
+    const char *outputs[] = { "sumInfected", "maxInfected", "dayMaxInfected", "dead" };
+    SobolAnalysis analysis(calibration.getParameters(), 4, [&](const simlib3::ParameterVector &values, double *out) {
+        Model model(calibration.modelParameters(values));
+        model.runTo(days);
+        out[0] = model.getStats().sumInfected;
+        out[1] = model.getStats().maxInfected;
+        out[2] = (double)model.getStats().dayMaxInfected;
+        out[3] = model.getDead();
+    });
+    analysis.setDesign(design);
+    analysis.setSeed(seed);
+    analysis.setThreads(threads);
+    if (analysis.run(samples) != 0) { return 1; }
+
+    const simlib3::ParameterVector &values = analysis.getParameters();
+    std::cout << "# " << analysis.getSamples() << " samples, " << analysis.getEvaluations() << " simulations" << std::endl;
+    std::cout << "output parameter first total" << std::endl;
+    for (size_t o = 0; o < 4; o++) {
+        for (int i = 0; i < values.size(); i++) {
+            std::cout << outputs[o] << " " << values[i].Name() << " "
+                      << analysis.firstOrder(i, o) << " " << analysis.totalEffect(i, o) << std::endl;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Stochastic ensemble of an experiment
+ *
+ * Usage: main ensemble <experiment> [data file] [-n replicates] [-j threads] [-s seed] [-tau] [-T timeline]
+ *  writes daily 5/50/95 % quantiles, -tau uses tau leaping instead of chain binomial,
+ *  -T replaces the experiment interventions with a timeline file
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int ensemble(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+    int experiment = atoi(argv[2]);
+    if (experiment < 1 || experiment > 4) { return 1; }
+
+    std::string output = "statistics/ensemble.csv";
+    size_t replicates = 1000;
+    unsigned threads = 0;
+    uint64_t seed = 0;
+    bool tau = false;
+    Timeline timeline = Timeline::hubei(experiment % 2 == 0);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-tau") == 0) {
+            tau = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            replicates = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            timeline = Timeline();
+            if (timeline.load(argv[++i]) != 0) { return 1; }
+        } else {
+            output = argv[i];
+        }
+    }
+
+    Ensemble ensemble(replicates, experiment >= 3);
+    ensemble.setTimeline(timeline);
+    ensemble.setMethod(tau ? Ensemble::TAU_LEAP : Ensemble::CHAIN_BINOMIAL);
+    ensemble.setSeed(seed);
+    ensemble.setThreads(threads);
+    ensemble.setSink(makeSink(output));
+    return ensemble.simulate(Date::reportDays);
+}
+
+/**
+ * Simulation of a model declared in a file
+ *
+ * Usage: main model <declaration> [days] [data file]
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int compartments(int argc, char** argv) {
+    if (argc < 3 || argc > 5) { return 1; }
+
+    CompartmentModel<double> model;
+    if (model.load(argv[2]) != 0) { return 1; }
+    unsigned long days = argc >= 4 ? strtoul(argv[3], nullptr, 10) : Date::reportDays;
+    std::unique_ptr<TrajectorySink> sink = makeSink(argc == 5 ? argv[4] : "statistics/model.csv");
+    if (sink->open(model.getNames()) != 0) { return 1; }
+
+    std::vector<double> row(model.compartments());
+    for (unsigned long i = 0; i < days; i++) {
+        for (size_t c = 0; c < row.size(); c++) {
+            row[c] = round(model.get((int)c));
+        }
+        sink->write(row.data());
+        model.step();
+    }
+    return sink->close();
+}
+
+/**
+ * Exact stochastic simulation of a model declared in a file
+ *
+ * Usage: main ssa <declaration> [days] [data file] [-direct] [-s seed]
+ *  uses the next reaction method unless -direct is given
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int ssa(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+
+    unsigned long days = Date::reportDays;
+    std::string output = "statistics/ssa.csv";
+    uint64_t seed = 0;
+    Gillespie::Method method = Gillespie::NEXT_REACTION;
+    int positional = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-direct") == 0) {
+            method = Gillespie::DIRECT;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (positional++ == 0) {
+            days = strtoul(argv[i], nullptr, 10);
+        } else {
+            output = argv[i];
+        }
+    }
+
+    CompartmentModel<double> model;
+    if (model.load(argv[2]) != 0) { return 1; }
+    Gillespie simulation(model, seed, method);
+    std::unique_ptr<TrajectorySink> sink = makeSink(output);
+    return simulation.simulate(days, *sink);
+}
+
+/**
+ * Continuous-time experiment solved by a SIMLIB integration method
+ *
+ * Usage: main ode <experiment> [days] [data file] [-m rkf5|rkf8|euler] [-a accuracy] [-h step]
+ *  -a is the relative accuracy of rkf5 and rkf8, -h the step of euler
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int ode(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+    int experiment = atoi(argv[2]);
+    if (experiment < 1 || experiment > 4) { return 1; }
+
+    unsigned long days = Date::reportDays;
+    std::string output = "statistics/ode.csv";
+    ContinuousModel model(Model::Parameters::experiment(experiment));
+    int positional = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            const char *method = argv[++i];
+            if (strcmp(method, "rkf5") == 0) {
+                model.setMethod(ContinuousModel::RKF5);
+            } else if (strcmp(method, "rkf8") == 0) {
+                model.setMethod(ContinuousModel::RKF8);
+            } else if (strcmp(method, "euler") == 0) {
+                model.setMethod(ContinuousModel::EULER);
+            } else {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            model.setAccuracy(atof(argv[++i]));
+        } else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            double step = atof(argv[++i]);
+            model.setStep(step, step);
+        } else if (positional++ == 0) {
+            days = strtoul(argv[i], nullptr, 10);
+        } else {
+            output = argv[i];
+        }
+    }
+
+    std::unique_ptr<TrajectorySink> sink = makeSink(output);
+    return model.simulate(days, sink.get());
+}
+
+/**
+ * Derivatives of an experiment by the initial rates from one run on dual numbers
+ *
+ * Usage: main sensitivity <experiment> [days] [data file]
+ *  prints the derivatives of the statistics, the data file has every
+ *  compartment followed by its derivatives by R0, alpha, sigma and omega
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int sensitivity(int argc, char** argv) {
+    if (argc < 3 || argc > 5) { return 1; }
+    int experiment = atoi(argv[2]);
+    if (experiment < 1 || experiment > 4) { return 1; }
+    unsigned long days = argc >= 4 ? strtoul(argv[3], nullptr, 10) : Date::reportDays;
+
+    const char *inputs[] = { "R0", "alpha", "sigma", "omega" };
+    SensitivityModel model(sensitivityParameters(experiment));
+    std::vector<std::string> columns;
+    for (const std::string &name : model.getNames()) {
+        columns.push_back(name);
+        for (const char *input : inputs) {
+            columns.push_back("d" + name + "/d" + input);
+        }
+    }
+    std::unique_ptr<TrajectorySink> sink = makeSink(argc == 5 ? argv[4] : "statistics/sensitivity.csv");
+    if (sink->open(columns) != 0) { return 1; }
+
+    std::vector<double> row(columns.size());
+    while (model.getDay() < days) {
+        size_t column = 0;
+        for (const Dual<4> &value : model.getState()) {
+            row[column++] = value.value;
+            for (double tangent : value.tangent) {
+                row[column++] = tangent;
+            }
+        }
+        sink->write(row.data());
+        model.step();
+    }
+
+    const SensitivityModel::Stats &stats = model.getStats();
+    const std::pair<const char *, Dual<4>> results[] = {
+        { "sumInfected", stats.sumInfected }, { "sumRecovered", stats.sumRecovered },
+        { "maxInfected", stats.maxInfected }, { "maxIncrement", stats.maxIncrement }, { "dead", model.getDead() }
+    };
+    std::cout << "statistic value d/dR0 d/dalpha d/dsigma d/domega" << std::endl;
+    for (const auto &result : results) {
+        std::cout << result.first << " " << result.second.value;
+        for (double tangent : result.second.tangent) {
+            std::cout << " " << tangent;
+        }
+        std::cout << std::endl;
+    }
+    return sink->close();
+}
+
+/**
+ * Export of a compressed trajectory log to a CSV data file readable by plot.py
+ *
+ * Usage: main export <log> [data file] [-r first last]
+ *  -r exports the days first to last only, decoding just their blocks
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int exportLog(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+
+    std::string output = "statistics/data.csv";
+    size_t first = 0, last = (size_t)-1;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 2 < argc) {
+            first = strtoul(argv[++i], nullptr, 10);
+            last = strtoul(argv[++i], nullptr, 10);
+        } else {
+            output = argv[i];
+        }
+    }
+
+    DeltaReader log;
+    if (log.open(argv[2]) != 0) { return 1; }
+    CsvSink sink(output);
+    if (sink.open(log.columns()) != 0) { return 1; }
+    std::vector<double> row(log.columns().size());
+    for (size_t day = first; day < log.rows() && day <= last; day++) {
+        if (log.row(day, row.data()) != 0) { return 1; }
+        sink.write(row.data());
+    }
+    return sink.close();
+}
+
+/**
+ * Experiment with variants arriving after the original strain
+ *
+ * Usage: main strains <experiment> [data file] [-v transmissibility day seeds protection]...
+ *  every -v adds a strain whose infections start on the day, protection is the one
+ *  of any earlier infection against it; without -v the data file is the one of scenarioN
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int strains(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+    int experiment = atoi(argv[2]);
+    if (experiment < 1 || experiment > 4) { return 1; }
+
+    StrainModel model(Model::Parameters::experiment(experiment));
+    std::string output = "statistics/strains.csv";
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0 && i + 4 < argc) {
+            double transmissibility = atof(argv[i + 1]), seeds = atof(argv[i + 3]), protection = atof(argv[i + 4]);
+            size_t strain = model.addStrain(transmissibility, strtoul(argv[i + 2], nullptr, 10), seeds);
+            for (size_t from = 0; from < strain; from++) {
+                model.setCrossImmunity(from, strain, protection);
+            }
+            i += 4;
+        } else {
+            output = argv[i];
+        }
+    }
+
+    model.setSink(makeSink(output));
+    if (model.simulate(Date::reportDays) != 0) { return 1; }
+    std::cout << "strain infected" << std::endl;
+    for (size_t k = 0; k < model.strains(); k++) {
+        std::cout << k + 1 << " " << round(model.getSumInfected()[k]) << std::endl;
+    }
+    return 0;
+}
+
+/**
+ * Nowcasting from daily reports of new infections as they arrive
+ *
+ * Usage: main nowcast <experiment> [reports file|-] [-n members] [-f horizon] [-o forecast file] [-s seed]
+ *  reads "<date or day> <cases>" lines, from the standard input without a file or with -,
+ *  prints a status line after every report and rewrites the forecast file
+ *
+ * @param argc Argument count
+ * @param argv Arguments from CLI
+ * @return 0 if OK
+ */
+int nowcast(int argc, char** argv) {
+    if (argc < 3) { return 1; }
+    int experiment = atoi(argv[2]);
+    if (experiment < 1 || experiment > 4) { return 1; }
+
+    std::string reports = "-", output = "statistics/forecast.csv";
+    size_t members = 200;
+    unsigned long horizon = 14;
+    uint64_t seed = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            members = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            horizon = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else {
+            reports = argv[i];
+        }
+    }
+
+    Nowcast filter(Model::Parameters::experiment(experiment), members, seed);
+    if (reports == "-") {
+        return filter.serve(std::cin, std::cout, horizon, output);
+    }
+    std::ifstream input(reports);
+    if (!input) {
+        std::cerr << "Cannot open " << reports << std::endl;
+        return 1;
+    }
+    return filter.serve(input, std::cout, horizon, output);
+}
 
 /**
  * Main simulation function
@@ -17,11 +543,36 @@
  * @return 0 if OK
  */
 int main(int argc, char** argv){
+    if (argc >= 2 && strcmp(argv[1],"sweep") == 0) { return sweep(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"calibrate") == 0) { return calibrate(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"sobol") == 0) { return sobol(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"ensemble") == 0) { return ensemble(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"ssa") == 0) { return ssa(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"ode") == 0) { return ode(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"sensitivity") == 0) { return sensitivity(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"export") == 0) { return exportLog(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"nowcast") == 0) { return nowcast(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"strains") == 0) { return strains(argc, argv); }
+    if (argc >= 2 && strcmp(argv[1],"model") == 0) { return compartments(argc, argv); }
+    if (argc == 2 && strcmp(argv[1],"precision") == 0) { return precisionReport(std::cout); }
+
     // Wrong param count
-    if (argc != 2) { return 1; }
+    if (argc < 2 || argc > 5) { return 1; }
 
-    // Model init, start & end time set and simulations
+    // Model init, optional timeline file replacing the experiment interventions
+    // and data file, ".delta" writes the compressed log
     Model model;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            model.setOutput(argv[++i]);
+        } else {
+            Timeline timeline;
+            if (timeline.load(argv[i]) != 0) { return 1; }
+            model.setTimeline(timeline);
+        }
+    }
+
+    // Start & end time set and simulations
     if (strcmp(argv[1],"scenario1") == 0) { return model.performExp(1); }
     if (strcmp(argv[1],"scenario2") == 0) { return model.performExp(2); }
     if (strcmp(argv[1],"scenario3") == 0) { return model.performExp(3); }
@@ -0,0 +1,87 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the batch model: every kernel the CPU supports gives exactly the
+ * compartments and statistics of Model for every lane of all experiments
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file batch.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/BatchModel.h"
+#include "../src/headers/Date.h"
+#include "../src/headers/Model.h"
+#include "common.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const char *const kernelNames[] = { "scalar", "avx2", "avx512" };
+
+    // Not a multiple of the vector width, the padding lanes are stepped as well
+    const size_t lanes = 13;
+
+    double laneR0(size_t lane) {
+        return 2.0 + 0.5 * lane;
+    }
+
+    void experiment(int num) {
+        const bool SIERD = num >= 3;
+        const unsigned long days = Date::reportDays;
+
+        vector<Model> models(lanes);
+        for (size_t k = 0; k < lanes; k++) {
+            models[k].setVerbose(false);
+            models[k].setOutput("");
+            models[k].setRates(laneR0(k), 0.0556, 0.1923, 0.0034);
+            models[k].performExp(num, days);
+        }
+
+        const BatchModel::Kernel kernels[] = { BatchModel::SCALAR, BatchModel::AVX2, BatchModel::AVX512 };
+        const Timeline timeline = Timeline::hubei(num % 2 == 0);
+        for (BatchModel::Kernel kernel : kernels) {
+            BatchModel batch(lanes, SIERD);
+            if (!batch.setKernel(kernel)) {
+                check(kernel != BatchModel::SCALAR, "scalar kernel supported");
+                continue;
+            }
+            for (size_t k = 0; k < lanes; k++) {
+                batch.setRates(k, laneR0(k), 0.0556, 0.1923, 0.0034);
+                batch.setTimeline(k, timeline);
+            }
+            batch.simulate(days);
+
+            const string name = "experiment " + to_string(num) + " " + kernelNames[kernel];
+            for (size_t k = 0; k < lanes; k++) {
+                const Model &model = models[k];
+                Span<const double> state = model.getState();
+                const Model::Stats &stats = model.getStats();
+                const string lane = name + " lane " + to_string(k);
+                check(batch.getS()[k] == state[model.compartment("S")]
+                      && batch.getI()[k] == state[model.compartment("I")]
+                      && batch.getR()[k] == state[model.compartment("R")]
+                      && (!SIERD || (batch.getE()[k] == state[model.compartment("E")]
+                                     && batch.getD()[k] == model.getDead())), lane + ": compartments");
+                check(batch.getSumInfected()[k] == stats.sumInfected
+                      && batch.getSumRecovered()[k] == stats.sumRecovered, lane + ": sums");
+                check(batch.getMaxInfected()[k] == stats.maxInfected
+                      && batch.getDayMaxInfected()[k] == stats.dayMaxInfected
+                      && batch.getMaxIncrement()[k] == stats.maxIncrement
+                      && batch.getDayMaxIncrement()[k] == stats.dayMaxIncrement, lane + ": maxima");
+            }
+        }
+    }
+}
+
+int main() {
+    for (int num = 1; num <= 4; num++) {
+        experiment(num);
+    }
+
+    return finish();
+}
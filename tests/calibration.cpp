@@ -0,0 +1,123 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the calibration: rates used to generate synthetic cases must be
+ * found again from the experiment defaults
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file calibration.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Calibration.h"
+#include "../src/headers/Model.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Keeps the cumulative infected of every day
+    class CumulativeSink : public TrajectorySink {
+    public:
+        CumulativeSink(vector<double> &values) : values(values) {}
+        int open(const vector<string> &columns) override { column = columns.size() - 2; return 0; }
+        void write(const double *row) override { values.push_back(row[column]); }
+        int close() override { return 0; }
+    private:
+        vector<double> &values;
+        size_t column = 0;
+    };
+
+    // Cases of experiment 2 with other R0 of the stages, written as a case file
+    void writeCases(const char *path, const double R0[4], unsigned long days) {
+        Timeline timeline;
+        const unsigned long stages[3] = { 23, 27, 43 };
+        for (int k = 0; k < 3; k++) {
+            timeline.add(stages[k], Timeline::R0, R0[k + 1]);
+        }
+        Model model;
+        vector<double> cumulative;
+        model.setVerbose(false);
+        model.setRates(R0[0], 0.0556, 0.1923, 0.0034);
+        model.setTimeline(timeline);
+        model.setSink(unique_ptr<TrajectorySink>(new CumulativeSink(cumulative)));
+        model.performExp(2, days);
+
+        ofstream output(path);
+        output << "day,cumulative,note\n";
+        for (unsigned long day = 0; day < days; day += 2) {
+            output << day << "," << cumulative[day] << ",\n";
+        }
+    }
+
+    void cases() {
+        const char *path = "calibration-test.csv";
+        ofstream(path) << "date,infected\n2020-01-05,10\n2020-01-06,ten\n";
+        Calibration calibration(1);
+        check(calibration.loadCases(path) != 0, "cases: bad number");
+        ofstream(path) << "day,active\n5,10\n";
+        check(calibration.loadCases(path) != 0, "cases: missing column");
+        remove(path);
+    }
+
+    void nelderMead() {
+        const char *path = "calibration-test.csv";
+        const double R0[4] = { 4.5, 7.0, 3.0, 0.4 };
+        writeCases(path, R0, 90);
+        Calibration calibration(2);
+        check(calibration.loadCases(path) == 0, "cases: load");
+        remove(path);
+
+        calibration.addHubeiParameters();
+        double loss = calibration.fit(Calibration::NELDER_MEAD, 4, 2000);
+        simlib3::ParameterVector values = calibration.getParameters();
+        check(loss < 1e-8, "nelder-mead: loss");
+        for (int i = 0; i < 4; i++) {
+            check(fabs(values[i].Value() - R0[i]) < 0.02 * R0[i], string("nelder-mead: ") + values[i].Name());
+        }
+    }
+
+    // SIMLIB Hooke-Jeeves on a single rate
+    double hooke(double R0) {
+        Calibration calibration(1);
+        Model model;
+        vector<double> cumulative;
+        model.setVerbose(false);
+        model.setRates(R0, 0.0556, 0.1923, 0.0034);
+        model.setTimeline(Timeline());
+        model.setSink(unique_ptr<TrajectorySink>(new CumulativeSink(cumulative)));
+        model.performExp(1, 20);
+        for (unsigned long day = 0; day < 20; day++) {
+            calibration.addObservation(day, cumulative[day], NAN);
+        }
+        calibration.addParameter(0, Timeline::R0, 1.0, 8.0, 5.0);
+        calibration.fit(Calibration::HOOKE, 1, 200);
+        return calibration.getParameters()[0].Value();
+    }
+
+    // Fits of other threads do not evaluate each other's loss
+    void concurrentHooke() {
+        double first = 0.0, second = 0.0;
+        thread other([&second] { second = hooke(4.2); });
+        first = hooke(3.3);
+        other.join();
+        check(fabs(first - 3.3) < 0.01, "hooke: R0");
+        check(fabs(second - 4.2) < 0.01, "hooke: R0 of the other thread");
+    }
+}
+
+int main() {
+    cases();
+    nelderMead();
+    concurrentHooke();
+
+    return finish();
+}
@@ -0,0 +1,66 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Scaffold shared by the regression tests: failed checks are printed and
+ * counted, the test passes and prints OK if none failed
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file common.h
+ * @date 13. 11. 2020
+ */
+
+#ifndef _TESTS_COMMON_H_
+#define _TESTS_COMMON_H_
+
+#include "../src/headers/Output.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void check(bool ok, const std::string &what) {
+        if (!ok) {
+            printf("FAIL %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    /**
+     * @return exit status of the test, prints OK if no check failed
+     */
+    int finish() {
+        if (failures == 0) {
+            printf("OK\n");
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    typedef std::vector<std::vector<double>> Rows;
+
+    // Keeps the data file in memory
+    class RowSink : public TrajectorySink {
+    public:
+        RowSink(Rows &rows) : rows(rows) {}
+
+        int open(const std::vector<std::string> &columns) override {
+            width = columns.size();
+            rows.clear();
+            return 0;
+        }
+
+        void write(const double *row) override {
+            rows.push_back(std::vector<double>(row, row + width));
+        }
+
+        int close() override { return 0; }
+
+    private:
+        Rows &rows;
+        size_t width = 0;
+    };
+}
+
+#endif //_TESTS_COMMON_H_
@@ -0,0 +1,196 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Regression test of the compartment graph engine: the Hubei experiments
+ * must give the same data file and statistics as the former hand written
+ * SIR/SEIRD equations of Model
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file compartments.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Compartments.h"
+#include "../src/headers/Model.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Former Model equations, kept as the reference
+    template<typename T>
+    struct Legacy {
+        T N = 58500000.0;
+        struct { T S = 0.0, E = 27 * 20.0, I = 27.0, R = 0.0, D = 0.0; } curr, next;
+        T R0 = 5.6015, alpha = 0.0556, beta = 0.0556 * 5.6015, sigma = 0.1923, omega = 0.0034;
+        typename BasicModel<T>::Stats stats;
+        T derrI = 0.0;
+        bool SIERD;
+
+        void nextStep() {
+            T newInfected = (beta * curr.S * curr.I) / N;
+            if (SIERD) {
+                if (newInfected > next.S) {
+                    next.S = 0;
+                    next.E += curr.S - (sigma * curr.E);
+                } else {
+                    next.S += -newInfected;
+                    next.E += newInfected - (sigma * curr.E);
+                    stats.sumInfected += newInfected;
+                }
+                next.I += (sigma * curr.E - alpha * curr.I - omega * curr.I);
+                next.D += omega * curr.I;
+                curr.E = next.E;
+                curr.D = next.D;
+            } else {
+                if (newInfected > next.S) {
+                    next.S = 0;
+                    next.I += curr.S - (alpha * curr.I);
+                } else {
+                    next.S += -newInfected;
+                    next.I += newInfected - alpha * curr.I;
+                    stats.sumInfected += newInfected;
+                }
+            }
+            next.R += alpha * curr.I;
+            stats.sumRecovered += alpha * curr.I;
+            derrI = next.I - curr.I;
+            curr.S = next.S;
+            curr.I = next.I;
+            curr.R = next.R;
+        }
+
+        Rows simulate(bool restrictions, unsigned long days) {
+            curr.S = next.S = (N - next.I - next.E);
+            stats.sumInfected = next.I;
+
+            Timeline timeline = Timeline::hubei(restrictions);
+            const vector<Timeline::Change> &changes = timeline.getChanges();
+            size_t pending = 0;
+            Rows rows;
+            for (unsigned long i = 0; i < days; i++) {
+                while (pending < changes.size() && changes[pending].day <= i) {
+                    R0 = changes[pending++].value;
+                    beta = alpha * R0;
+                }
+                if (round(curr.I) > stats.maxInfected) {
+                    stats.maxInfected = round(curr.I);
+                    stats.dayMaxInfected = i + 1ul;
+                }
+                if (round(derrI) > stats.maxIncrement) {
+                    stats.maxIncrement = round(derrI);
+                    stats.dayMaxIncrement = i + 1ul;
+                }
+                vector<double> row;
+                row.push_back((double)round(curr.S));
+                if (SIERD) {
+                    row.push_back((double)round(curr.E));
+                }
+                row.push_back((double)round(curr.I));
+                row.push_back((double)round(curr.R));
+                if (SIERD) {
+                    row.push_back((double)round(curr.D));
+                }
+                row.push_back((double)round(stats.sumInfected));
+                row.push_back((double)round(stats.sumRecovered));
+                rows.push_back(row);
+                nextStep();
+            }
+            return rows;
+        }
+    };
+
+    template<typename T>
+    void experiment(int num, const char *type) {
+        string name = string("experiment ") + to_string(num) + " " + type;
+
+        Rows rows;
+        BasicModel<T> model;
+        model.setVerbose(false);
+        model.setSink(unique_ptr<TrajectorySink>(new RowSink(rows)));
+        check(model.performExp(num) == 0, name + ": simulation");
+
+        Legacy<T> legacy;
+        legacy.SIERD = num >= 3;
+        Rows expected = legacy.simulate(num % 2 == 0, Date::reportDays);
+
+        check(rows == expected, name + ": data file");
+        const typename BasicModel<T>::Stats &a = model.getStats(), &b = legacy.stats;
+        check(a.maxInfected == b.maxInfected && a.maxIncrement == b.maxIncrement
+              && a.dayMaxInfected == b.dayMaxInfected && a.dayMaxIncrement == b.dayMaxIncrement
+              && a.sumInfected == b.sumInfected && a.sumRecovered == b.sumRecovered, name + ": statistics");
+        check(model.getDead() == legacy.curr.D, name + ": dead");
+    }
+
+    // A text declaration must build the same graph as the built in one
+    void declaration() {
+        const char *path = "compartments-test.model";
+        ofstream(path) <<
+            "# SEIRD of Model\n"
+            "population 58500000\n"
+            "compartment S rest\n"
+            "compartment E 540\n"
+            "compartment I 27\n"
+            "compartment R 0\n"
+            "compartment D 0\n"
+            "parameter beta 0.3114434\n"
+            "parameter alpha 0.0556\n"
+            "parameter sigma 0.1923\n"
+            "parameter omega 0.0034\n"
+            "flow S -> E : beta * S * I / N\n"
+            "flow E -> I : sigma * E\n"
+            "flow I -> R : alpha * I\n"
+            "flow I -> D : omega * I\n";
+
+        CompartmentModel<double> loaded;
+        check(loaded.load(path) == 0, "declaration: load");
+        remove(path);
+
+        CompartmentModel<double> built = CompartmentModel<double>::seird(58500000.0, 27.0, 540.0);
+        const double values[] = { 0.3114434, 0.0556, 0.1923, 0.0034 };
+        for (int p = 0; p < 4; p++) {
+            built.setParameter(p, values[p]);
+        }
+        check(loaded.getNames() == built.getNames(), "declaration: compartments");
+        for (int day = 0; day < 300; day++) {
+            loaded.step();
+            built.step();
+        }
+        bool same = true;
+        for (size_t c = 0; c < built.compartments(); c++) {
+            same = same && loaded.get((int)c) == built.get((int)c);
+        }
+        check(same, "declaration: state");
+    }
+
+    // Contacts after a change of the population use the new N
+    void population() {
+        CompartmentModel<double> model = CompartmentModel<double>::seird(1000000.0, 10.0, 0.0);
+        model.setParameter(0, 0.5);
+        model.step();
+        model.setPopulation(500000.0);
+        const int S = model.compartment("S"), I = model.compartment("I");
+        const double susceptible = model.get(S), infected = model.get(I);
+        model.step();
+        const double infections = 0.5 * susceptible * infected / 500000.0;
+        check(fabs(susceptible - model.get(S) - infections) <= 1e-9 * infections, "population: new N");
+    }
+}
+
+int main() {
+    for (int num = 1; num <= 4; num++) {
+        experiment<double>(num, "double");
+        experiment<long double>(num, "long double");
+    }
+    declaration();
+    population();
+
+    return finish();
+}
@@ -0,0 +1,107 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the continuous-time model: RKF5 and RKF8 agree, the population is
+ * conserved, SIMLIB Euler converges with order one and interventions apply
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file continuous.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Continuous.h"
+#include "common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Keeps the infected of every day
+    class InfectedSink : public TrajectorySink {
+    public:
+        vector<double> values;
+
+        int open(const vector<string> &columns) override {
+            column = find(columns.begin(), columns.end(), "I") - columns.begin();
+            values.clear();
+            return 0;
+        }
+
+        void write(const double *row) override { values.push_back(row[column]); }
+        int close() override { return 0; }
+
+    private:
+        size_t column = 0;
+    };
+
+    // Largest daily difference of the infected over the peak
+    double difference(const vector<double> &a, const vector<double> &b) {
+        double worst = 0.0;
+        for (size_t day = 0; day < a.size(); day++) {
+            worst = max(worst, fabs(a[day] - b[day]));
+        }
+        return worst / *max_element(b.begin(), b.end());
+    }
+
+    vector<double> infected(const Model::Parameters &parameters, ContinuousModel::Method method, double setting) {
+        InfectedSink sink;
+        ContinuousModel model(parameters);
+        model.setMethod(method);
+        if (method == ContinuousModel::EULER) {
+            model.setStep(setting, setting);
+        } else {
+            model.setAccuracy(setting);
+        }
+        model.simulate(200, &sink);
+        return sink.values;
+    }
+
+    void methods() {
+        Model::Parameters parameters = Model::Parameters::experiment(4);
+        vector<double> rkf5 = infected(parameters, ContinuousModel::RKF5, 1e-8);
+        vector<double> rkf8 = infected(parameters, ContinuousModel::RKF8, 1e-10);
+        check(rkf5.size() == 200 && rkf8.size() == 200, "methods: rows");
+        check(difference(rkf5, rkf8) < 1e-6, "methods: rkf5 and rkf8");
+
+        // Halving the step halves the error of a first order method
+        double coarse = difference(infected(parameters, ContinuousModel::EULER, 0.5), rkf8);
+        double fine = difference(infected(parameters, ContinuousModel::EULER, 0.25), rkf8);
+        check(coarse / fine > 1.7 && coarse / fine < 2.3, "methods: euler order");
+    }
+
+    void conservation() {
+        for (int num = 1; num <= 4; num++) {
+            Model::Parameters parameters = Model::Parameters::experiment(num);
+            ContinuousModel model(parameters);
+            check(model.simulate(Date::reportDays) == 0, "conservation: simulation");
+            double sum = 0.0;
+            for (double value : model.getState()) {
+                sum += value;
+            }
+            // SIR leaves the initially exposed out of every compartment
+            double expected = parameters.N - (parameters.SIERD ? 0.0 : parameters.E);
+            check(fabs(sum - expected) < 1e-6 * parameters.N, "conservation: experiment " + to_string(num));
+        }
+    }
+
+    void interventions() {
+        ContinuousModel free(Model::Parameters::experiment(3)), measures(Model::Parameters::experiment(4));
+        free.simulate(200);
+        measures.simulate(200);
+        check(measures.getStats().sumInfected < 0.01 * free.getStats().sumInfected, "interventions: cumulative");
+        check(measures.getStats().dayMaxInfected < free.getStats().dayMaxInfected, "interventions: peak");
+    }
+}
+
+int main() {
+    methods();
+    conservation();
+    interventions();
+
+    return finish();
+}
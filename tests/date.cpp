@@ -0,0 +1,67 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the day numbers: known dates, leap years, consecutive dates over
+ * a whole 400 year cycle and dates of the timeline files
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file date.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Date.h"
+#include "../src/headers/Timeline.h"
+#include "common.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+// Fixed dates are compile time constants
+static_assert(Date::number(1970, 1, 1) == 0, "epoch");
+static_assert(Date::simulationDay(2020, 1, 23) == 23, "chinese new year");
+static_assert(Date::simulationDay(2020, 3, 1) == 61, "after the leap day");
+static_assert(Date::reportDays == 342, "7.12.2020");
+
+namespace {
+    void known() {
+        check(Date::number(2000, 3, 1) == 11017, "known: 1.3.2000");
+        check(Date::number(1969, 12, 31) == -1, "known: before the epoch");
+        check(Date::number(1600, 1, 1) == -135140, "known: 1.1.1600");
+        check(Date::leap(2020) && Date::leap(2000) && !Date::leap(1900) && !Date::leap(2019), "known: leap years");
+        check(Date::daysInMonth(2020, 2) == 29 && Date::daysInMonth(2021, 2) == 28 && Date::daysInMonth(2020, 4) == 30,
+              "known: month lengths");
+    }
+
+    void consecutive() {
+        long expected = Date::number(1600, 1, 1);
+        bool ok = true;
+        for (long year = 1600; year < 2000; year++) {
+            for (unsigned month = 1; month <= 12; month++) {
+                for (unsigned day = 1; day <= Date::daysInMonth(year, month); day++) {
+                    ok = ok && Date::number(year, month, day) == expected++;
+                }
+            }
+        }
+        check(ok && expected == Date::number(2000, 1, 1) && expected - Date::number(1600, 1, 1) == 146097,
+              "consecutive: 400 years");
+    }
+
+    void parsed() {
+        unsigned long day = 0;
+        check(Timeline::parseDay("2019-12-31", day) && day == 0, "parsed: first case");
+        check(Timeline::parseDay("2020-02-29", day) && day == 60, "parsed: leap day");
+        check(Timeline::parseDay("2020-12-07", day) && day == Date::reportDays, "parsed: report end");
+        check(!Timeline::parseDay("2019-02-29", day) && !Timeline::parseDay("2020-04-31", day), "parsed: no such day");
+        check(!Timeline::parseDay("2019-12-30", day), "parsed: before the first case");
+    }
+}
+
+int main() {
+    known();
+    consecutive();
+    parsed();
+
+    return finish();
+}
@@ -0,0 +1,146 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the compressed trajectory log: every value comes back bit for
+ * bit, any day is readable on its own, damaged files are rejected and the
+ * data file of an experiment shrinks at least five times
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file delta.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Model.h"
+#include "../src/headers/Output.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const char *path = "delta-test.delta";
+
+    bool identical(double a, double b) {
+        return memcmp(&a, &b, sizeof(a)) == 0;
+    }
+
+    long size(const string &file) {
+        ifstream input(file, ios::binary | ios::ate);
+        return input ? (long)input.tellg() : -1;
+    }
+
+    // Whole numbers, a fraction, and special values in the last rows
+    vector<vector<double>> table(size_t rows) {
+        vector<vector<double>> values(rows, vector<double>(3));
+        for (size_t r = 0; r < rows; r++) {
+            values[r][0] = 58500000.0 - 3.0 * r * r;
+            values[r][1] = r * 0.1;
+            values[r][2] = -(double)r;
+        }
+        values[rows - 1][1] = numeric_limits<double>::quiet_NaN();
+        values[rows - 2][1] = -numeric_limits<double>::infinity();
+        values[rows - 1][2] = -0.0;
+        return values;
+    }
+
+    void roundTrip(size_t rows, size_t blockRows) {
+        const string name = "round trip " + to_string(rows) + "/" + to_string(blockRows);
+        vector<vector<double>> values = table(rows);
+        DeltaSink sink(path, blockRows);
+        check(sink.open({ "S", "rate", "change" }) == 0, name + ": open");
+        for (const vector<double> &row : values) {
+            sink.write(row.data());
+        }
+        check(sink.close() == 0, name + ": close");
+
+        DeltaReader reader;
+        check(reader.open(path) == 0 && reader.rows() == rows && reader.columns().size() == 3, name + ": header");
+
+        // Days out of order, each from its own block
+        bool ok = true;
+        double row[3];
+        for (size_t k = 0; k < rows; k++) {
+            size_t day = (k * 7919) % rows;
+            ok = ok && reader.row(day, row) == 0;
+            for (size_t c = 0; ok && c < 3; c++) {
+                ok = identical(row[c], values[day][c]);
+            }
+        }
+        check(ok, name + ": rows");
+        check(reader.row(rows, row) != 0, name + ": past the end");
+
+        vector<double> column;
+        ok = reader.column("rate", column) == 0 && column.size() == rows;
+        for (size_t r = 0; ok && r < rows; r++) {
+            ok = identical(column[r], values[r][1]);
+        }
+        check(ok, name + ": column");
+        check(reader.column("D", column) != 0, name + ": missing column");
+    }
+
+    void damaged() {
+        vector<vector<double>> values = table(300);
+        DeltaSink sink(path);
+        sink.open({ "S", "rate", "change" });
+        for (const vector<double> &row : values) {
+            sink.write(row.data());
+        }
+        sink.close();
+
+        // Truncated: the trailer is gone
+        string bytes;
+        {
+            ifstream input(path, ios::binary);
+            bytes.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+        }
+        ofstream(path, ios::binary).write(bytes.data(), bytes.size() - 5);
+        DeltaReader reader;
+        check(reader.open(path) != 0, "damaged: truncated");
+
+        // Corrupted block: the encoding of the first column is unknown
+        ofstream(path, ios::binary).write(bytes.data(), bytes.size());
+        check(reader.open(path) == 0, "damaged: intact");
+        uint64_t first;
+        memcpy(&first, bytes.data() + bytes.size() - 24 - 3 * sizeof(uint64_t), sizeof(first));
+        bytes[first] = 7;
+        ofstream(path, ios::binary).write(bytes.data(), bytes.size());
+        double row[3];
+        check(reader.open(path) == 0 && reader.row(0, row) != 0 && reader.row(200, row) == 0, "damaged: block");
+        remove(path);
+    }
+
+    void experiment() {
+        const string csv = "delta-test.csv";
+        Model plain, compressed;
+        plain.setVerbose(false);
+        compressed.setVerbose(false);
+        plain.setOutput(csv);
+        compressed.setOutput(path);
+        check(plain.performExp(4) == 0 && compressed.performExp(4) == 0, "experiment: simulations");
+        check(size(path) > 0 && size(csv) >= 5 * size(path), "experiment: five times smaller");
+
+        DeltaReader reader;
+        vector<double> infected;
+        check(reader.open(path) == 0 && reader.column("I", infected) == 0
+              && infected.size() == Date::reportDays, "experiment: rows");
+        remove(path);
+        remove(csv.c_str());
+    }
+}
+
+int main() {
+    roundTrip(300, 128);
+    roundTrip(256, 128);
+    roundTrip(5, 1);
+    damaged();
+    experiment();
+
+    return finish();
+}
@@ -0,0 +1,99 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the random streams, samplers and the stochastic ensemble
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file ensemble.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Ensemble.h"
+#include "../src/headers/Model.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace {
+    // Known answer of Philox4x32-10 for zero key and counter (Random123)
+    void philox() {
+        RandomStream random(0, 0);
+        const uint32_t expected[] = { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 };
+        bool same = true;
+        for (uint32_t value : expected) {
+            same = same && random.next() == value;
+        }
+        check(same, "philox: known answer");
+    }
+
+    // Sample mean and variance within five standard errors of the exact ones
+    template<typename Sampler>
+    void moments(const string &name, double mean, double variance, Sampler sample) {
+        RandomStream random(12345, 7);
+        const int count = 200000;
+        double sum = 0.0, squares = 0.0;
+        for (int i = 0; i < count; i++) {
+            double x = (double)sample(random);
+            sum += x;
+            squares += x * x;
+        }
+        double sampleMean = sum / count, sampleVariance = squares / count - sampleMean * sampleMean;
+        check(fabs(sampleMean - mean) <= 5.0 * sqrt(variance / count), name + ": mean");
+        check(fabs(sampleVariance - variance) <= 5.0 * variance * sqrt(2.0 / count) + 1e-9, name + ": variance");
+    }
+
+    void samplers() {
+        moments("binomial inversion", 20 * 0.1, 20 * 0.1 * 0.9, [](RandomStream &r) { return binomial(r, 20, 0.1); });
+        moments("binomial BTRS", 1000 * 0.3, 1000 * 0.3 * 0.7, [](RandomStream &r) { return binomial(r, 1000, 0.3); });
+        moments("binomial p > 0.5", 5000 * 0.9, 5000 * 0.9 * 0.1, [](RandomStream &r) { return binomial(r, 5000, 0.9); });
+        moments("poisson multiplication", 3.5, 3.5, [](RandomStream &r) { return poisson(r, 3.5); });
+        moments("poisson PTRS", 250.0, 250.0, [](RandomStream &r) { return poisson(r, 250.0); });
+    }
+
+    // Quantiles of experiment 4 must not depend on the thread count
+    void threads() {
+        Ensemble serial(500, true), parallel(500, true);
+        serial.setThreads(1);
+        parallel.setThreads(4);
+        for (Ensemble *ensemble : { &serial, &parallel }) {
+            ensemble->setTimeline(Timeline::hubei(true));
+            ensemble->setSeed(42);
+            ensemble->simulate(120);
+        }
+        size_t bytes = serial.size() * sizeof(uint64_t);
+        check(memcmp(serial.getI(), parallel.getI(), bytes) == 0 && memcmp(serial.getD(), parallel.getD(), bytes) == 0,
+              "threads: identical replicates");
+    }
+
+    // With millions of people the noise is small, medians stay close to Model
+    void median() {
+        Model model;
+        model.setVerbose(false);
+        model.setOutput("");
+        model.performExp(3);
+
+        for (Ensemble::Method method : { Ensemble::CHAIN_BINOMIAL, Ensemble::TAU_LEAP }) {
+            Ensemble ensemble(200, true);
+            ensemble.setMethod(method);
+            ensemble.setTimeline(Timeline::hubei(false));
+            ensemble.simulate(Date::reportDays);
+            double infected = ensemble.quantile(ensemble.getSumInfected(), 0.5);
+            check(fabs(infected - model.getStats().sumInfected) <= 0.01 * model.getStats().sumInfected,
+                  method == Ensemble::TAU_LEAP ? "tau leaping: median" : "chain binomial: median");
+        }
+    }
+}
+
+int main() {
+    philox();
+    samplers();
+    threads();
+    median();
+
+    return finish();
+}
@@ -0,0 +1,77 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the exact stochastic simulation: both methods must agree with
+ * the known mean of a decay process and with each other on an outbreak
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file gillespie.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Gillespie.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+namespace {
+    const char *const methodNames[] = { "direct", "next reaction" };
+
+    // Recovery only: the mean of I(t) is I0 * exp(-alpha * t)
+    void recovery(Gillespie::Method method) {
+        CompartmentModel<double> model(1000.0);
+        model.addCompartment("I", 1000.0);
+        model.addCompartment("R", 0.0);
+        model.addParameter("alpha", 0.1);
+        model.addFlow("I", "R", "alpha");
+
+        const int runs = 400;
+        double sum = 0.0;
+        for (int seed = 0; seed < runs; seed++) {
+            Gillespie ssa(model, seed, method);
+            ssa.advance(10.0);
+            sum += ssa.get(0);
+            if (ssa.get(0) + ssa.get(1) != 1000) {
+                check(false, string(methodNames[method]) + " recovery: people lost");
+                return;
+            }
+        }
+        // Variance of a single run is 1000 * p * (1 - p), p = exp(-1)
+        double expected = 1000.0 * exp(-1.0), deviation = sqrt(1000.0 * exp(-1.0) * (1.0 - exp(-1.0)) / runs);
+        check(fabs(sum / runs - expected) <= 5.0 * deviation, string(methodNames[method]) + " recovery: mean");
+    }
+
+    // Mean final size of a small SEIRD outbreak, both methods sample the same process
+    double outbreak(Gillespie::Method method) {
+        CompartmentModel<double> model = CompartmentModel<double>::seird(2000.0, 5.0, 0.0);
+        const double parameters[] = { 0.3, 0.1, 0.2, 0.01 };
+        for (int p = 0; p < 4; p++) {
+            model.setParameter(p, parameters[p]);
+        }
+
+        const int runs = 300;
+        double sum = 0.0, error = 0.0;
+        for (int seed = 0; seed < runs; seed++) {
+            Gillespie ssa(model, 1000 + seed, method);
+            ssa.advance(400.0);
+            sum += ssa.get(3) + ssa.get(4);
+            error = fmax(error, ssa.propensityError());
+        }
+        check(error <= 1e-9, string(methodNames[method]) + " outbreak: propensities");
+        return sum / runs;
+    }
+}
+
+int main() {
+    recovery(Gillespie::DIRECT);
+    recovery(Gillespie::NEXT_REACTION);
+
+    double direct = outbreak(Gillespie::DIRECT), nextReaction = outbreak(Gillespie::NEXT_REACTION);
+    check(fabs(direct - nextReaction) <= 0.1 * direct, "outbreak: methods agree");
+
+    return finish();
+}
@@ -0,0 +1,95 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the metapopulation engine: a single well-mixed patch must follow
+ * the SEIRD experiment of Model and the result must not depend on the
+ * thread count or on how the population is split into identical patches
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file metapopulation.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Metapopulation.h"
+#include "../src/headers/Model.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace {
+    bool close(double a, double b) {
+        return fabs(a - b) <= 1e-9 * fabs(b);
+    }
+
+    // Experiment 4 of Model on one patch
+    void wellMixed() {
+        Model model;
+        model.setVerbose(false);
+        model.setOutput("");
+        model.performExp(4);
+
+        Metapopulation patches(1, 1);
+        patches.setPopulation(0, 58500000.0, 27 * 20.0, 27.0);
+        patches.addContact(0, 0, 1.0);
+        patches.setTimeline(Timeline::hubei(true));
+        patches.simulate(Date::reportDays);
+
+        check(close(patches.getSumInfected()[0], model.getStats().sumInfected), "well mixed: infected");
+        check(close(patches.getD()[0], model.getDead()), "well mixed: dead");
+    }
+
+    // Regions with equal populations and contacts among all groups
+    void build(Metapopulation &model) {
+        for (size_t i = 0; i < model.patches(); i++) {
+            for (size_t j = 0; j < model.patches(); j++) {
+                model.addContact(i, j, 1.0 / model.patches());
+            }
+            model.setPopulation(i, 1000000.0, 0.0, i % 3 == 0 ? 50.0 : 0.0);
+        }
+    }
+
+    void threads() {
+        Metapopulation serial(300, 4), parallel(300, 4);
+        build(serial);
+        build(parallel);
+        serial.setThreads(1);
+        parallel.setThreads(4);
+        serial.simulate(100);
+        parallel.simulate(100);
+
+        size_t bytes = serial.patches() * sizeof(double);
+        check(memcmp(serial.getI(), parallel.getI(), bytes) == 0 && memcmp(serial.getS(), parallel.getS(), bytes) == 0,
+              "threads: identical state");
+    }
+
+    // A region split into two groups mixing uniformly behaves like one group
+    void split() {
+        Metapopulation one(1, 1), two(1, 2);
+        one.setPopulation(0, 2000000.0, 100.0, 10.0);
+        one.addContact(0, 0, 1.0);
+        two.setPopulation(0, 1000000.0, 50.0, 5.0);
+        two.setPopulation(1, 1000000.0, 50.0, 5.0);
+        for (size_t i = 0; i < 2; i++) {
+            two.addContact(i, 0, 0.25);
+            two.addContact(i, 1, 0.5);
+            two.addContact(i, 1, 0.25);
+        }
+        check(two.nonZeros() == 4, "split: duplicates merged");
+        one.simulate(200);
+        two.simulate(200);
+        check(close(two.getI()[0] + two.getI()[1], one.getI()[0]), "split: infected");
+    }
+}
+
+int main() {
+    wellMixed();
+    threads();
+    split();
+
+    return finish();
+}
@@ -0,0 +1,117 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the library interface of Model: stepping models built from
+ * parameters must reproduce the command line experiments, also when the
+ * run is split, interleaved with another model or repeated after reset()
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file model.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Model.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Builds the same rows as the data file from the days seen by an observer
+    class RowObserver : public Model::Observer {
+    public:
+        Rows rows;
+        unsigned startedCount = 0, finishedCount = 0;
+
+        void started(const Model &model, unsigned long until) override { startedCount++; }
+        void day(const Model &model) override {
+            vector<double> row;
+            for (double value : model.getState()) {
+                row.push_back(round(value));
+            }
+            row.push_back(round(model.getStats().sumInfected));
+            row.push_back(round(model.getStats().sumRecovered));
+            rows.push_back(row);
+        }
+        void finished(const Model &model) override { finishedCount++; }
+    };
+
+    bool sameStats(const Model &a, const Model &b) {
+        const Model::Stats &x = a.getStats(), &y = b.getStats();
+        return x.maxInfected == y.maxInfected && x.maxIncrement == y.maxIncrement
+            && x.dayMaxInfected == y.dayMaxInfected && x.dayMaxIncrement == y.dayMaxIncrement
+            && x.sumInfected == y.sumInfected && x.sumRecovered == y.sumRecovered;
+    }
+
+    void experiment(int num) {
+        string name = string("experiment ") + to_string(num);
+        const unsigned long days = Date::reportDays;
+
+        Rows expected;
+        Model reference;
+        reference.setVerbose(false);
+        reference.setSink(unique_ptr<TrajectorySink>(new RowSink(expected)));
+        check(reference.performExp(num) == 0, name + ": simulation");
+
+        // Split run, every day is seen once, a run already at its day only notifies
+        Model model(Model::Parameters::experiment(num));
+        RowObserver observer;
+        model.addObserver(observer);
+        model.runTo(days / 3);
+        model.runTo(days);
+        model.runTo(days);
+        check(model.getDay() == days, name + ": day");
+        check(observer.rows == expected, name + ": rows");
+        check(observer.startedCount == 3 && observer.finishedCount == 3, name + ": callbacks");
+        check(sameStats(model, reference) && model.getDead() == reference.getDead(), name + ": statistics");
+
+        // Reset keeps the observer and starts over
+        observer.rows.clear();
+        model.reset();
+        model.runTo(days);
+        check(observer.rows == expected, name + ": reset");
+        model.removeObserver(observer);
+        model.reset();
+        model.runTo(10);
+        check(observer.rows.size() == days, name + ": removed observer");
+    }
+
+    // Models share nothing, alternating steps of two give the runs of each alone
+    void interleaved() {
+        const unsigned long days = 200;
+        Model::Parameters parameters = Model::Parameters::experiment(4);
+        parameters.rates.R0 = 3.0;
+        parameters.rates.beta = parameters.rates.alpha * parameters.rates.R0;
+
+        Model a(Model::Parameters::experiment(3)), b(parameters);
+        Model aloneA(Model::Parameters::experiment(3)), aloneB(parameters);
+        for (unsigned long day = 0; day < days; day++) {
+            a.step();
+            b.step();
+        }
+        aloneA.runTo(days);
+        aloneB.runTo(days);
+
+        bool same = a.getState().size() == aloneA.getState().size() && b.getState().size() == aloneB.getState().size();
+        for (size_t c = 0; same && c < a.getState().size(); c++) {
+            same = a.getState()[c] == aloneA.getState()[c] && b.getState()[c] == aloneB.getState()[c];
+        }
+        check(same, "interleaved: state");
+        check(sameStats(a, aloneA) && sameStats(b, aloneB), "interleaved: statistics");
+        check(a.getNames() == aloneA.getNames() && a.compartment("D") >= 0, "interleaved: names");
+    }
+}
+
+int main() {
+    for (int num = 1; num <= 4; num++) {
+        experiment(num);
+    }
+    interleaved();
+
+    return finish();
+}
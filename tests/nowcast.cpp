@@ -0,0 +1,100 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the nowcasting: reports of the Hubei experiment with measures
+ * pull a wrong prior R0 to the true one after the lockdown, the forecast
+ * follows the truth and reports arriving through a stream give the same
+ * filter as assimilated one by one
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file nowcast.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Model.h"
+#include "../src/headers/Nowcast.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // New infections by day of the deterministic experiment, cases[d] reported on day d
+    vector<double> truth(unsigned long days) {
+        Model model(Model::Parameters::experiment(2));
+        vector<double> cases(1, 0.0);
+        double sum = model.getStats().sumInfected;
+        while (model.getDay() < days) {
+            model.step();
+            cases.push_back(model.getStats().sumInfected - sum);
+            sum = model.getStats().sumInfected;
+        }
+        return cases;
+    }
+
+    Model::Parameters prior() {
+        Model::Parameters parameters = Model::Parameters::experiment(2);
+        parameters.rates.R0 = 3.0;
+        return parameters;
+    }
+
+    void tracking() {
+        const unsigned long last = 70, horizon = 14;
+        vector<double> cases = truth(last + horizon);
+        Nowcast filter(prior(), 200, 7);
+        bool ok = true;
+        for (unsigned long day = 1; day <= last; day++) {
+            ok = ok && filter.assimilate(day, cases[day]) == 0;
+        }
+        check(ok && filter.getDay() == last, "tracking: assimilated");
+        check(fabs(filter.getR0() - 0.2020) < 0.1, "tracking: R0 after the lockdown " + to_string(filter.getR0()));
+
+        vector<Nowcast::Day> ahead = filter.forecast(horizon);
+        check(ahead.size() == horizon && ahead.back().day == last + horizon, "tracking: forecast days");
+        check(filter.getDay() == last, "tracking: forecast keeps the filter");
+        const Nowcast::Day &end = ahead.back();
+        check(fabs(end.cases - cases[last + horizon]) < 0.2 * cases[last + horizon],
+              "tracking: forecast " + to_string(end.cases) + " of " + to_string(cases[last + horizon]));
+        check(end.casesLow <= end.cases && end.cases <= end.casesHigh, "tracking: forecast quantiles");
+        check(filter.assimilate(last, cases[last]) != 0, "tracking: past report");
+    }
+
+    void stream() {
+        vector<double> cases = truth(30);
+        Nowcast direct(prior(), 50, 3), served(prior(), 50, 3);
+        stringstream reports, status;
+        reports.precision(17);
+        reports << "# day, cases\n";
+        for (unsigned long day = 1; day <= 30; day++) {
+            direct.assimilate(day, cases[day]);
+            reports << (day == 1 ? "2020-01-01" : to_string(day)) << ", " << cases[day] << "\n\n";
+        }
+        check(served.serve(reports, status, 7, "") == 0, "stream: served");
+        check(served.getDay() == 30 && served.getR0() == direct.getR0()
+              && served.mean(-1) == direct.mean(-1), "stream: same filter");
+
+        size_t lines = 0;
+        string line;
+        while (getline(status, line)) {
+            lines++;
+        }
+        check(lines == 30, "stream: status lines");
+
+        stringstream bad("31 many\n"), nothing;
+        check(served.serve(bad, nothing, 7, "") != 0, "stream: bad report");
+        stringstream old("12 1000\n");
+        check(served.serve(old, nothing, 7, "") != 0, "stream: past report");
+    }
+}
+
+int main() {
+    tracking();
+    stream();
+
+    return finish();
+}
@@ -0,0 +1,94 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the trajectory sinks: CSV text is the one of the former operator<<
+ * output, binary columns read back by TrajectoryReader are the written
+ * values in 64 B aligned arrays
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file output.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Output.h"
+#include "common.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const vector<string> names = { "S", "I", "Isum" };
+    const size_t rowCount = 37;
+
+    // Values of all magnitudes the models write, rounded people and fractions
+    Rows sample() {
+        Rows rows;
+        for (size_t day = 0; day < rowCount; day++) {
+            rows.push_back({ 58500000.0 - day * 1234567.0, day * 1234.5678 - 0.125, 58500000.0 / (day + 3) });
+        }
+        return rows;
+    }
+
+    void write(const string &path, const Rows &rows) {
+        unique_ptr<TrajectorySink> sink = makeSink(path);
+        check(sink->open(names) == 0, "open " + path);
+        for (const vector<double> &row : rows) {
+            sink->write(row.data());
+        }
+        check(sink->close() == 0, "close " + path);
+    }
+
+    void csv() {
+        const char *path = "output-test.csv";
+        const Rows rows = sample();
+        write(path, rows);
+
+        // Former data file, values written by operator<< with the default precision
+        ostringstream expected;
+        expected << "S,I,Isum\n";
+        for (const vector<double> &row : rows) {
+            expected << row[0] << "," << row[1] << "," << row[2] << "\n";
+        }
+        ifstream file(path);
+        stringstream actual;
+        actual << file.rdbuf();
+        check(actual.str() == expected.str(), "csv: text of operator<<");
+        remove(path);
+    }
+
+    void binary() {
+        const char *path = "output-test.bin";
+        const Rows rows = sample();
+        write(path, rows);
+
+        TrajectoryReader reader;
+        check(reader.open(path) == 0, "binary: open");
+        check(reader.columns() == names && reader.rows() == rowCount, "binary: header");
+        for (size_t c = 0; c < names.size(); c++) {
+            const double *column = reader.column(names[c]);
+            check(column && (uintptr_t)column % BinarySink::alignment == 0, "binary: aligned " + names[c]);
+            bool same = column != nullptr;
+            for (size_t day = 0; same && day < rowCount; day++) {
+                same = column[day] == rows[day][c];
+            }
+            check(same, "binary: values " + names[c]);
+        }
+        check(reader.column("R") == nullptr, "binary: missing column");
+        reader.close();
+        remove(path);
+    }
+}
+
+int main() {
+    csv();
+    binary();
+
+    return finish();
+}
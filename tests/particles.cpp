@@ -0,0 +1,163 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the particle filter: reports of the Hubei experiment with
+ * measures pull a wrong prior R0 to the lockdown value, the likelihood
+ * prefers the true R0, resampling leaves equal weights, the result does
+ * not depend on the worker count and the days allocate no memory
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file particles.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Model.h"
+#include "../src/headers/ParticleFilter.h"
+#include "common.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Allocations of the whole program, counted by the replaced operator new
+static atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *memory = malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+namespace {
+    // Whole new infections by day of the deterministic experiment, cases[d] reported on day d
+    vector<double> truth(int experiment, unsigned long days) {
+        Model model(Model::Parameters::experiment(experiment));
+        vector<double> cases(1, 0.0);
+        double sum = model.getStats().sumInfected;
+        while (model.getDay() < days) {
+            model.step();
+            cases.push_back(round(model.getStats().sumInfected - sum));
+            sum = model.getStats().sumInfected;
+        }
+        return cases;
+    }
+
+    void tracking() {
+        const unsigned long last = 70;
+        vector<double> cases = truth(2, last);
+        Model::Parameters parameters = Model::Parameters::experiment(2);
+        parameters.rates.R0 = 3.0;
+        ParticleFilter filter(parameters, 2000, 5);
+
+        bool finite = true, effective = true, resampled = false;
+        for (unsigned long day = 1; day <= last; day++) {
+            finite = finite && filter.assimilate(day, cases[day]) == 0 && std::isfinite(filter.getStep().logLikelihood);
+            effective = effective && filter.getStep().effectiveSize > 0.0
+                        && filter.getStep().effectiveSize <= filter.size() * (1.0 + 1e-9);
+            resampled = resampled || filter.getStep().resampled;
+        }
+        check(finite && filter.getDay() == last && std::isfinite(filter.getLogLikelihood()), "tracking: likelihoods");
+        check(effective && resampled, "tracking: effective sizes");
+        check(fabs(filter.getR0() - 0.2020) < 0.15, "tracking: R0 after the lockdown " + to_string(filter.getR0()));
+        check(filter.assimilate(last, cases[last]) != 0, "tracking: past report");
+    }
+
+    // Fixed R0, the likelihood of the reports is largest near the true one
+    void likelihood() {
+        vector<double> cases = truth(1, 40);
+        double values[3];
+        const double factors[] = { 0.8, 1.0, 1.25 };
+        for (int i = 0; i < 3; i++) {
+            Model::Parameters parameters = Model::Parameters::experiment(1);
+            parameters.timeline = Timeline();
+            parameters.rates.R0 = 6.6037 * factors[i];
+            ParticleFilter filter(parameters, 500, 1);
+            filter.setR0Noise(0.0, 0.0);
+            filter.advance(23);
+            for (unsigned long day = 24; day <= 40; day++) {
+                filter.assimilate(day, cases[day]);
+            }
+            values[i] = filter.getLogLikelihood();
+        }
+        check(values[1] > values[0] && values[1] > values[2], "likelihood: true R0 "
+              + to_string(values[0]) + " " + to_string(values[1]) + " " + to_string(values[2]));
+    }
+
+    void resampling() {
+        vector<double> cases = truth(4, 30);
+        ParticleFilter filter(Model::Parameters::experiment(4), 1000, 2);
+        filter.setResampleThreshold(1.0);
+        bool ok = true;
+        for (unsigned long day = 1; day <= 30; day++) {
+            filter.assimilate(day, cases[day]);
+            ok = ok && filter.getStep().resampled && fabs(filter.effectiveSize() - filter.size()) < 1e-6;
+        }
+        check(ok, "resampling: equal weights");
+
+        // Population is conserved by every particle, copies included
+        bool conserved = true;
+        for (size_t p = 0; p < filter.size(); p++) {
+            conserved = conserved && filter.getS()[p] + filter.getE()[p] + filter.getI()[p] + filter.getR()[p]
+                                     + filter.getD()[p] == 58500000u;
+        }
+        check(conserved, "resampling: population");
+    }
+
+    void threads() {
+        vector<double> cases = truth(2, 40);
+        double results[2][2];
+        const unsigned counts[] = { 1, 4 };
+        for (int t = 0; t < 2; t++) {
+            ParticleFilter filter(Model::Parameters::experiment(2), 3000, 9);
+            filter.setThreads(counts[t]);
+            for (unsigned long day = 1; day <= 40; day++) {
+                filter.assimilate(day, cases[day]);
+            }
+            results[t][0] = filter.getLogLikelihood();
+            results[t][1] = filter.mean(filter.getI());
+        }
+        check(results[0][0] == results[1][0] && results[0][1] == results[1][1], "threads: same result");
+    }
+
+    // The first day starts the workers, the following ones reuse everything
+    void allocationFree() {
+        vector<double> cases = truth(2, 30);
+        ParticleFilter filter(Model::Parameters::experiment(2), 3000, 4);
+        filter.setThreads(4);
+        filter.setResampleThreshold(1.0);
+        filter.assimilate(1, cases[1]);
+        const size_t before = allocations;
+        for (unsigned long day = 2; day <= 30; day++) {
+            filter.assimilate(day, cases[day]);
+        }
+        filter.advance(40);
+        const size_t during = allocations - before;
+        check(during == 0, "allocations: " + to_string(during) + " after the first day");
+    }
+}
+
+int main() {
+    tracking();
+    likelihood();
+    resampling();
+    threads();
+    allocationFree();
+
+    return finish();
+}
@@ -0,0 +1,57 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the committed precision report: the statistics and errors of
+ * doc/precision-report.txt must be the ones the models give now, only the
+ * time column may differ
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file precision.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/PrecisionReport.h"
+#include "common.h"
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+    // Line without the time column, the last one of the result rows
+    string withoutTime(const string &line) {
+        if (line.empty() || !isdigit((unsigned char)line[0])) {
+            return line;
+        }
+        return line.substr(0, line.find_last_not_of(' ', line.find_last_of(' ')) + 1);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "doc/precision-report.txt";
+    ifstream committed(path);
+    check((bool)committed, string("open ") + path);
+
+    stringstream generated;
+    check(precisionReport(generated, 1) == 0, "report");
+
+    // The header line with the run count differs as well
+    string expected, actual;
+    unsigned long number = 0;
+    while (getline(generated, actual)) {
+        number++;
+        bool read = (bool)getline(committed, expected);
+        if (number == 2) {
+            continue;
+        }
+        check(read && withoutTime(expected) == withoutTime(actual),
+              "line " + to_string(number) + " of " + path + ", regenerate it by make precision");
+    }
+    check(!getline(committed, expected), string("extra lines in ") + path);
+
+    return finish();
+}
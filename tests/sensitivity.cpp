@@ -0,0 +1,93 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the dual number model: values are those of Model and the
+ * derivatives by the initial rates match central finite differences
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file sensitivity.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Model.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+namespace {
+    const unsigned long days = 200;
+
+    bool close(double value, double expected, double tolerance) {
+        return fabs(value - expected) <= tolerance * fabs(expected) + 1e-6;
+    }
+
+    // Experiment run with one initial rate moved by delta
+    Model moved(int experiment, int input, double delta) {
+        Model::Parameters parameters = Model::Parameters::experiment(experiment);
+        Model::Rates &rates = parameters.rates;
+        double *values[] = { &rates.R0, &rates.alpha, &rates.sigma, &rates.omega };
+        *values[input] += delta;
+        rates.beta = rates.alpha * rates.R0;
+        Model model(parameters);
+        model.runTo(days);
+        return model;
+    }
+
+    void values(int experiment) {
+        SensitivityModel dual(sensitivityParameters(experiment));
+        Model plain(Model::Parameters::experiment(experiment));
+        dual.runTo(days);
+        plain.runTo(days);
+        bool same = true;
+        for (size_t c = 0; c < plain.getState().size(); c++) {
+            same = same && close(dual.getState()[c].value, plain.getState()[c], 1e-12);
+        }
+        const string name = "experiment " + to_string(experiment);
+        check(same, name + ": state");
+        check(dual.getStats().sumInfected.value == plain.getStats().sumInfected
+              && dual.getStats().maxInfected.value == plain.getStats().maxInfected
+              && dual.getStats().dayMaxInfected == plain.getStats().dayMaxInfected, name + ": statistics");
+    }
+
+    void derivatives(int experiment) {
+        SensitivityModel dual(sensitivityParameters(experiment));
+        dual.runTo(days);
+        const Model::Rates initial;
+        const double rates[] = { initial.R0, initial.alpha, initial.sigma, initial.omega };
+        const char *inputs[] = { "R0", "alpha", "sigma", "omega" };
+
+        for (int input = 0; input < 4; input++) {
+            const double h = 1e-5 * rates[input];
+            Model up = moved(experiment, input, h), down = moved(experiment, input, -h);
+            const string name = "experiment " + to_string(experiment) + ": d/d" + inputs[input];
+
+            bool ok = true;
+            for (size_t c = 0; c < up.getState().size(); c++) {
+                double difference = (up.getState()[c] - down.getState()[c]) / (2 * h);
+                ok = ok && close(dual.getState()[c].tangent[input], difference, 1e-4);
+            }
+            check(ok, name + " state");
+
+            double difference = (up.getStats().sumInfected - down.getStats().sumInfected) / (2 * h);
+            check(close(dual.getStats().sumInfected.tangent[input], difference, 1e-4), name + " sumInfected");
+
+            // Rounded peak, the difference is as exact as the rounding allows
+            difference = (up.getStats().maxInfected - down.getStats().maxInfected) / (2 * h);
+            check(fabs(dual.getStats().maxInfected.tangent[input] - difference) <= 1e-2 * fabs(difference) + 1.0 / h,
+                  name + " maxInfected");
+        }
+    }
+}
+
+int main() {
+    for (int experiment = 3; experiment <= 4; experiment++) {
+        values(experiment);
+        derivatives(experiment);
+    }
+
+    return finish();
+}
@@ -0,0 +1,148 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of snapshots: a run forked from a snapshot of a shared prefix must
+ * end as a run simulated from day 0, also with other later interventions,
+ * and a snapshot of another model must be rejected
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file snapshot.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Continuous.h"
+#include "../src/headers/Model.h"
+#include "../src/headers/Snapshot.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+    const unsigned long prefix = 120, days = 341;
+
+    template<typename M>
+    bool same(const M &a, const M &b, double tolerance) {
+        bool ok = a.getState().size() == b.getState().size();
+        for (size_t c = 0; ok && c < a.getState().size(); c++) {
+            ok = fabs(a.getState()[c] - b.getState()[c]) <= tolerance * fabs(b.getState()[c]);
+        }
+        const Model::Stats &x = a.getStats(), &y = b.getStats();
+        return ok && x.maxInfected == y.maxInfected && x.dayMaxInfected == y.dayMaxInfected
+            && x.maxIncrement == y.maxIncrement && x.dayMaxIncrement == y.dayMaxIncrement
+            && fabs(x.sumInfected - y.sumInfected) <= tolerance * y.sumInfected;
+    }
+
+    // Experiment 4 with the lockdown lifted on a later day
+    Model::Parameters lifted() {
+        Model::Parameters parameters = Model::Parameters::experiment(4);
+        parameters.timeline.add(prefix + 30, Timeline::R0, 1.5);
+        return parameters;
+    }
+
+    void model() {
+        const char *path = "snapshot-test.bin";
+        Model shared(Model::Parameters::experiment(4));
+        shared.runTo(prefix);
+        Snapshot snapshot;
+        shared.save(snapshot);
+        check(snapshot.save(path) == 0, "model: save");
+
+        Snapshot loaded;
+        check(loaded.load(path) == 0 && loaded.size() == snapshot.size(), "model: load");
+        remove(path);
+
+        // Same interventions, exactly the run from day 0
+        Model fork(Model::Parameters::experiment(4)), full(Model::Parameters::experiment(4));
+        check(fork.restore(loaded) == 0 && fork.getDay() == prefix, "model: restore");
+        fork.runTo(days);
+        full.runTo(days);
+        check(same(fork, full, 0.0) && fork.getDead() == full.getDead(), "model: fork");
+
+        // Other later interventions
+        Model branch(lifted()), alone(lifted());
+        snapshot.rewind();
+        check(branch.restore(snapshot) == 0, "model: restore branch");
+        branch.runTo(days);
+        alone.runTo(days);
+        check(same(branch, alone, 0.0), "model: branch");
+        check(branch.getStats().sumInfected > full.getStats().sumInfected, "model: branch differs");
+
+        // Long double states keep every bit
+        BasicModel<long double> precise(BasicModel<long double>::Parameters::experiment(3));
+        BasicModel<long double> copy(BasicModel<long double>::Parameters::experiment(3));
+        precise.runTo(prefix);
+        Snapshot wide;
+        precise.save(wide);
+        check(copy.restore(wide) == 0, "model: restore long double");
+        precise.runTo(days);
+        copy.runTo(days);
+        check(copy.getState()[2] == precise.getState()[2], "model: long double");
+    }
+
+    void rejected() {
+        Model sir(Model::Parameters::experiment(1)), seird(Model::Parameters::experiment(3));
+        seird.runTo(10);
+        Snapshot snapshot;
+        seird.save(snapshot);
+        check(sir.restore(snapshot) != 0 && sir.getDay() == 0, "rejected: other compartments");
+
+        snapshot.rewind();
+        BasicModel<float> single(BasicModel<float>::Parameters::experiment(3));
+        check(single.restore(snapshot) != 0, "rejected: other precision");
+
+        snapshot.rewind();
+        ContinuousModel ode(Model::Parameters::experiment(3));
+        check(ode.restore(snapshot) != 0, "rejected: other kind");
+
+        const char *path = "snapshot-test.bin";
+        fclose(fopen(path, "w"));
+        check(snapshot.load(path) != 0, "rejected: empty file");
+
+        // Payload size of the header far beyond the end of the file
+        check(snapshot.save(path) == 0, "rejected: save");
+        {
+            fstream file(path, ios::in | ios::out | ios::binary);
+            const uint64_t size = 1ull << 40;
+            file.seekp(16);     // after the magic, version and reserved fields
+            file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        }
+        Snapshot corrupt;
+        check(corrupt.load(path) != 0, "rejected: size beyond file");
+        remove(path);
+    }
+
+    void continuous() {
+        ContinuousModel shared(Model::Parameters::experiment(4));
+        shared.advance(prefix);
+        Snapshot snapshot;
+        shared.save(snapshot);
+
+        // Integration restarts on the restored day, steps differ only by rounding
+        ContinuousModel fork(Model::Parameters::experiment(4)), full(Model::Parameters::experiment(4));
+        check(fork.restore(snapshot) == 0 && fork.getDay() == prefix, "continuous: restore");
+        fork.advance(days);
+        full.simulate(days);
+        check(same(fork, full, 1e-6), "continuous: fork");
+
+        ContinuousModel branch(lifted()), alone(lifted());
+        snapshot.rewind();
+        check(branch.restore(snapshot) == 0, "continuous: restore branch");
+        branch.advance(days);
+        alone.simulate(days);
+        check(same(branch, alone, 1e-6), "continuous: branch");
+    }
+}
+
+int main() {
+    model();
+    rejected();
+    continuous();
+
+    return finish();
+}
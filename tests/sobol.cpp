@@ -0,0 +1,101 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the Sobol indices on the Ishigami function with known indices,
+ * the sequence stratifies every coordinate and the indices do not depend
+ * on the number of threads
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @see https://www.sfu.ca/~ssurjano/ishigami.html
+ * @file sobol.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Sobol.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+using simlib3::Param;
+using simlib3::ParameterVector;
+
+namespace {
+    // Ishigami with a = 7, b = 0.1 on [-pi, pi]^3
+    const double firstOrder[3] = { 0.3139, 0.4424, 0.0 };
+    const double totalEffect[3] = { 0.5576, 0.4424, 0.2437 };
+
+    ParameterVector ranges() {
+        Param items[3] = { Param("x1", -M_PI, M_PI), Param("x2", -M_PI, M_PI), Param("x3", -M_PI, M_PI) };
+        return ParameterVector(3, items);
+    }
+
+    void ishigami(const ParameterVector &x, double *outputs) {
+        outputs[0] = sin(x[0]) + 7 * sin(x[1]) * sin(x[1]) + 0.1 * pow(x[2], 4) * sin(x[0]);
+        // Shifted far from zero, the estimates must not lose it to cancellation
+        outputs[1] = 1e7 + outputs[0];
+    }
+
+    void indices(SobolAnalysis::Design design, size_t samples, double tolerance, const string &name) {
+        SobolAnalysis analysis(ranges(), 2, ishigami);
+        analysis.setDesign(design);
+        analysis.setThreads(1);
+        check(analysis.run(samples) == 0 && analysis.getEvaluations() == 5 * samples, name + ": run");
+        for (size_t o = 0; o < 2; o++) {
+            for (size_t i = 0; i < 3; i++) {
+                check(fabs(analysis.firstOrder(i, o) - firstOrder[i]) < tolerance, name + ": first order " + to_string(i));
+                check(fabs(analysis.totalEffect(i, o) - totalEffect[i]) < tolerance, name + ": total effect " + to_string(i));
+            }
+        }
+        // Mean 3.5, variance 13.8446
+        check(fabs(analysis.mean(0) - 3.5) < 0.1 && fabs(analysis.variance(0) / 13.8446 - 1) < 0.02, name + ": moments");
+    }
+
+    void stratified() {
+        SobolSequence sequence(SobolSequence::maxDimensions);
+        vector<double> x(sequence.dimensions());
+        bool ok = true;
+        for (size_t d = 0; d < x.size(); d++) {
+            vector<bool> hit(1024, false);
+            for (size_t i = 0; i < hit.size(); i++) {
+                sequence.point(i, x.data());
+                hit[(size_t)(x[d] * hit.size())] = true;
+            }
+            for (bool h : hit) {
+                ok = ok && h;
+            }
+        }
+        check(ok, "sequence: stratified");
+    }
+
+    void threads() {
+        SobolAnalysis one(ranges(), 2, ishigami), many(ranges(), 2, ishigami);
+        one.setThreads(1);
+        many.setThreads(4);
+        one.run(1000);
+        many.run(600);
+        many.run(400);
+        bool same = true;
+        for (size_t i = 0; i < 3; i++) {
+            same = same && one.firstOrder(i, 0) == many.firstOrder(i, 0) && one.totalEffect(i, 0) == many.totalEffect(i, 0);
+        }
+        check(same, "threads: same indices");
+
+        // Too many parameters for the sequence
+        vector<Param> items(SobolSequence::maxDimensions / 2 + 1, Param("x", 0.0, 1.0));
+        SobolAnalysis wide(ParameterVector((int)items.size(), items.data()), 1, [](const ParameterVector &, double *out) { *out = 0.0; });
+        check(wide.run(1) != 0, "threads: too many parameters");
+    }
+}
+
+int main() {
+    indices(SobolAnalysis::SOBOL, 1 << 14, 0.02, "sobol");
+    indices(SobolAnalysis::LATIN_HYPERCUBE, 1 << 15, 0.05, "latin hypercube");
+    stratified();
+    threads();
+
+    return finish();
+}
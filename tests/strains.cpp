@@ -0,0 +1,118 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the multi-strain model: one strain reproduces every experiment
+ * of Model bit for bit, two identical strains add up to one, people are
+ * conserved, a variant escaping immunity reinfects the recovered and no
+ * compartment goes negative however fast the strains spread
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file strains.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Model.h"
+#include "../src/headers/Strains.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+namespace {
+    double total(const StrainModel &model) {
+        double sum = model.getS() + model.getD();
+        for (size_t k = 0; k < model.strains(); k++) {
+            sum += model.getE()[k] + model.getI()[k] + model.getR()[k];
+        }
+        return sum;
+    }
+
+    void single(int experiment) {
+        const string name = "single " + to_string(experiment);
+        Model model(Model::Parameters::experiment(experiment));
+        StrainModel strains(Model::Parameters::experiment(experiment));
+        const bool SIERD = experiment >= 3;
+        bool ok = true;
+        for (unsigned long day = 0; ok && day < Date::reportDays; day++) {
+            model.step();
+            strains.step();
+            Span<const double> state = model.getState();
+            ok = state[model.compartment("S")] == strains.getS()
+                 && state[model.compartment("I")] == strains.getI()[0]
+                 && state[model.compartment("R")] == strains.getR()[0]
+                 && (!SIERD || (state[model.compartment("E")] == strains.getE()[0]
+                                && state[model.compartment("D")] == strains.getD()))
+                 && model.getStats().sumInfected == strains.getSumInfected()[0]
+                 && model.getStats().sumRecovered == strains.getSumRecovered()[0];
+        }
+        check(ok, name + ": exact");
+    }
+
+    // Two strains of the same kind splitting the infected behave as one
+    void identical() {
+        Model::Parameters parameters = Model::Parameters::experiment(4), more = parameters;
+        more.I = 1.5 * parameters.I;
+        StrainModel one(more), two(parameters);
+        two.addStrain(1.0, 0, parameters.I / 2);
+        for (unsigned long day = 0; day < 200; day++) {
+            one.step();
+            two.step();
+        }
+        const double I = two.getI()[0] + two.getI()[1], R = two.getR()[0] + two.getR()[1];
+        check(fabs(I - one.getI()[0]) < 1e-9 * one.getI()[0] && fabs(R - one.getR()[0]) < 1e-9 * one.getR()[0]
+              && fabs(two.getS() - one.getS()) < 1e-9 * one.getS(), "identical: strains add up");
+        check(fabs(total(two) - parameters.N) < 1e-6 * parameters.N, "identical: people conserved");
+    }
+
+    void escaping() {
+        Model::Parameters parameters = Model::Parameters::experiment(3);
+        parameters.timeline = Timeline();
+        StrainModel protectedModel(parameters), escapeModel(parameters);
+        for (StrainModel *model : { &protectedModel, &escapeModel }) {
+            model->addStrain(1.5, 120, 100.0);
+        }
+        escapeModel.setCrossImmunity(0, 1, 0.2);
+        for (unsigned long day = 0; day < 300; day++) {
+            protectedModel.step();
+            escapeModel.step();
+        }
+        check(protectedModel.getSumInfected()[1] < escapeModel.getSumInfected()[1], "escaping: reinfections");
+        check(escapeModel.getR()[0] < protectedModel.getR()[0], "escaping: recovered of strain 0 reinfected");
+        check(fabs(total(escapeModel) - parameters.N) < 1e-6 * parameters.N, "escaping: people conserved");
+    }
+
+    // Infections and reinfections of both strains together take more than S and R_j hold
+    void overflow() {
+        Model::Parameters parameters = Model::Parameters::experiment(1);
+        parameters.timeline = Timeline();
+        StrainModel model(parameters);
+        model.addStrain(40.0, 5, 2 * parameters.N);
+        model.setCrossImmunity(0, 1, 0.0);
+        model.setCrossImmunity(1, 0, 0.0);
+        const double people = total(model);
+        bool nonnegative = true;
+        for (unsigned long day = 0; day < 100; day++) {
+            model.step();
+            nonnegative = nonnegative && model.getS() >= 0.0;
+            for (size_t k = 0; k < model.strains(); k++) {
+                nonnegative = nonnegative && model.getR()[k] >= 0.0 && model.getI()[k] >= 0.0;
+            }
+        }
+        check(nonnegative, "overflow: S >= 0, R_j >= 0");
+        check(fabs(total(model) - people) < 1e-6 * people, "overflow: people conserved");
+    }
+}
+
+int main() {
+    for (int experiment = 1; experiment <= 4; experiment++) {
+        single(experiment);
+    }
+    identical();
+    escaping();
+    overflow();
+
+    return finish();
+}
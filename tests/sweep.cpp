@@ -0,0 +1,62 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the sweep grid files: ranges expand to their steps, a reversed
+ * or infinite range is a bad grid line
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file sweep.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/Sweep.h"
+#include "common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+    // Loads a grid file of the given lines
+    int load(Sweep &sweep, const string &lines) {
+        const char *path = "sweep-test.grid";
+        ofstream(path) << lines;
+        int status = sweep.load(path);
+        remove(path);
+        return status;
+    }
+
+    void ranges() {
+        Sweep sweep;
+        check(load(sweep, "# R0 steps\nR0 = 2:6:1\nexperiment = 1,3\n") == 0, "range: load");
+        // Cartesian product, R0 changes fastest
+        check(sweep.getRuns().size() == 10, "range: cartesian product");
+        for (size_t k = 0; k < sweep.getRuns().size(); k++) {
+            const Sweep::Run &run = sweep.getRuns()[k];
+            check(run.experiment == (k < 5 ? 1 : 3) && fabs(run.R0 - (2.0 + k % 5)) < 1e-12,
+                  "range: run " + to_string(k));
+        }
+
+        Sweep single;
+        check(load(single, "R0 = 4:4:1\n") == 0 && single.getRuns().size() == 1 && single.getRuns()[0].R0 == 4.0,
+              "range: single value");
+    }
+
+    void badRanges() {
+        const char *lines[] = { "R0 = 6:2:1\n", "R0 = 2:6:-1\n", "R0 = 2:6:0\n", "R0 = 2:inf:1\n", "R0 = nan:6:1\n" };
+        for (const char *line : lines) {
+            Sweep sweep;
+            check(load(sweep, line) != 0 && sweep.getRuns().empty(), string("bad range: ") + line);
+        }
+    }
+}
+
+int main() {
+    ranges();
+    badRanges();
+
+    return finish();
+}
@@ -0,0 +1,71 @@
+/**
+ * IMS 2020/21 Project - Epidemic on macro level
+ *
+ * Test of the thread pool: every index of parallelFor runs once, also in
+ * loops nested inside tasks on pools of one and more workers, also with more
+ * tasks than the deques hold initially
+ *
+ * @authors Matej Otčenáš, Mário Gažo
+ * @file threadpool.cpp
+ * @date 13. 11. 2020
+ */
+
+#include "../src/headers/ThreadPool.h"
+#include "common.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    void flat(unsigned threads) {
+        ThreadPool pool(threads);
+        vector<atomic<int>> runs(1000);
+        for (auto &count : runs) {
+            count = 0;
+        }
+        pool.parallelFor(runs.size(), [&runs](size_t i) { runs[i]++; });
+        // A task per index grows the deques
+        pool.parallelFor(runs.size(), [&runs](size_t i) { runs[i]++; }, 1);
+        bool twice = true;
+        for (auto &count : runs) {
+            twice = twice && count == 2;
+        }
+        check(twice, "flat " + to_string(threads) + ": every index once per loop");
+    }
+
+    // Outer loop tasks run inner loops of their own
+    void nested(unsigned threads) {
+        ThreadPool pool(threads);
+        const size_t outer = 16, inner = 100;
+        vector<atomic<int>> runs(outer * inner);
+        for (auto &count : runs) {
+            count = 0;
+        }
+        atomic<size_t> finished(0);
+        pool.parallelFor(outer, [&](size_t i) {
+            pool.parallelFor(inner, [&runs, i, inner](size_t j) { runs[i * inner + j]++; }, 7);
+            // Inner loop complete before the outer task goes on
+            bool complete = true;
+            for (size_t j = 0; j < inner; j++) {
+                complete = complete && runs[i * inner + j] == 1;
+            }
+            if (complete) {
+                finished++;
+            }
+        }, 1);
+        check(finished == outer, "nested " + to_string(threads) + ": inner loops complete");
+    }
+}
+
+int main() {
+    for (unsigned threads : { 1u, 2u, 4u }) {
+        flat(threads);
+        nested(threads);
+    }
+
+    return finish();
+}